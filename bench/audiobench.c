@@ -0,0 +1,95 @@
+// Times scoring and voice assignment for the fleet's sounds against
+// generated fleets. Runs on SDL's dummy audio driver, which mixes into
+// nothing, so no sound card is needed and the mixer still does its work
+#include "bench.h"
+
+#include "simulation.h"
+#include "simworld.h"
+#include "spatialaudio.h"
+#include "tbcommon.h"
+
+#include <SDL3/SDL.h>
+
+#define BENCH_AUDIO_SPACING 20.0f
+#define BENCH_AUDIO_WARMUP_STEPS 30
+
+void ths_register_audio_sys(TbWorld *world);
+void ths_unregister_audio_sys(TbWorld *world);
+
+static void bench_audio_scale(BenchContext *ctx, uint32_t boat_count,
+                              double *samples) {
+  BenchJson *json = ctx->json;
+
+  TbWorld world = {0};
+  ThsSimWorldDesc desc = {
+      .gp_alloc = ctx->alloc,
+      .frame_mem = ctx->frame_mem,
+  };
+  if (!ths_create_sim_world(&desc, &world)) {
+    SDL_Log("Bench: failed to create simulation world");
+    return;
+  }
+  ths_spawn_sim_ocean(&world);
+  // Sailing AI ships give the wakes something to be loud about; the first
+  // boat's camera is the listener
+  ThsFleetDesc fleet = {
+      .boat_count = boat_count,
+      .spacing = BENCH_AUDIO_SPACING,
+      .with_ai = true,
+      .with_player = true,
+  };
+  ths_spawn_fleet(&world, &fleet);
+  ths_register_audio_sys(&world);
+
+  const float step = ecs_singleton_get(world.ecs, ThsSimClock)->step;
+  for (uint32_t i = 0; i < BENCH_AUDIO_WARMUP_STEPS; ++i) {
+    ths_sim_advance(world.ecs, step);
+    ths_frame_memory_end_frame(ctx->frame_mem);
+  }
+
+  // Only the audio update is timed; the step keeps the boats moving
+  ThsAudioCounters totals = {0};
+  for (uint32_t i = 0; i < ctx->iterations; ++i) {
+    ths_sim_advance(world.ecs, step);
+    uint64_t start = bench_now();
+    ths_audio_update(world.ecs);
+    samples[i] = bench_ms_since(start);
+    ths_frame_memory_end_frame(ctx->frame_mem);
+
+    const ThsAudioCounters counters = ths_audio_counters(world.ecs);
+    totals.started += counters.started;
+    totals.stopped += counters.stopped;
+  }
+  const ThsAudioCounters last = ths_audio_counters(world.ecs);
+
+  bench_json_begin_object(json, NULL);
+  bench_json_number(json, "boats", boat_count);
+  const BenchStats stats = bench_stats(samples, ctx->iterations);
+  bench_json_stats(json, "audio_update", &stats);
+  bench_json_number(json, "scored", last.candidates);
+  bench_json_number(json, "audible", last.audible);
+  bench_json_number(json, "playing", last.playing);
+  bench_json_number(json, "virtual", last.virtualized);
+  // Voices handed over across every iteration; churn shows up here
+  bench_json_number(json, "started", totals.started);
+  bench_json_number(json, "stopped", totals.stopped);
+  bench_json_end_object(json);
+
+  ths_unregister_audio_sys(&world);
+  ths_destroy_sim_world(&world);
+}
+
+void bench_audio(BenchContext *ctx, const uint32_t *scales,
+                 uint32_t scale_count) {
+  // Has to be set before the audio subsystem starts
+  SDL_SetHint(SDL_HINT_AUDIO_DRIVER, "dummy");
+  double *samples = tb_alloc_nm_tp(ctx->alloc, ctx->iterations, double);
+
+  bench_json_begin_array(ctx->json, "audio");
+  for (uint32_t i = 0; i < scale_count; ++i) {
+    bench_audio_scale(ctx, scales[i], samples);
+  }
+  bench_json_end_array(ctx->json);
+
+  tb_free(ctx->alloc, samples);
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "allocator.h"
+#include "framememory.h"
+
+#include <stdio.h>
+
+#define BENCH_MAX_SAMPLES 4096
+
+// Timings of one benchmark case in milliseconds
+typedef struct BenchStats {
+  uint32_t count;
+  double mean;
+  double p50;
+  double p95;
+  double p99;
+  double min;
+  double max;
+} BenchStats;
+
+// Minimal streaming JSON writer so results can be diffed between commits
+typedef struct BenchJson {
+  FILE *file;
+  uint32_t depth;
+  bool needs_comma[16];
+} BenchJson;
+
+typedef struct BenchContext {
+  TbAllocator alloc;
+  ThsFrameMemory *frame_mem; // Ends a frame between iterations like the game
+  BenchJson *json;
+  uint32_t iterations;
+} BenchContext;
+
+uint64_t bench_now(void);
+double bench_ms_since(uint64_t start);
+
+// Sorts the samples in place
+BenchStats bench_stats(double *samples_ms, uint32_t count);
+
+void bench_json_begin_object(BenchJson *json, const char *key);
+void bench_json_end_object(BenchJson *json);
+void bench_json_begin_array(BenchJson *json, const char *key);
+void bench_json_end_array(BenchJson *json);
+void bench_json_number(BenchJson *json, const char *key, double value);
+void bench_json_string(BenchJson *json, const char *key, const char *value);
+void bench_json_stats(BenchJson *json, const char *key,
+                      const BenchStats *stats);
+
+// Benchmark cases; each writes one member of the top level results object
+void bench_ocean_sampling(BenchContext *ctx);
+void bench_scene_io(BenchContext *ctx);
+void bench_systems(BenchContext *ctx, const uint32_t *scales,
+                   uint32_t scale_count);
+void bench_spatial_hash(BenchContext *ctx);
+void bench_audio(BenchContext *ctx, const uint32_t *scales,
+                 uint32_t scale_count);
@@ -0,0 +1,192 @@
+// Game system microbenchmarks
+//
+// Usage: thehighseas_bench [--out results.json] [--iterations n]
+//                          [--scales 1,100,1000,10000]
+//
+// Results are written as JSON so runs from different commits can be diffed
+#include "bench.h"
+
+#include "simdlanes.h"
+#include "tbcommon.h"
+
+#include <SDL3/SDL.h>
+
+#define BENCH_DEFAULT_ITERATIONS 100
+#define BENCH_MAX_SCALES 16
+
+static const uint32_t default_scales[] = {1, 100, 1000, 10000};
+
+uint64_t bench_now(void) { return SDL_GetPerformanceCounter(); }
+
+double bench_ms_since(uint64_t start) {
+  return (double)(SDL_GetPerformanceCounter() - start) * 1000.0 /
+         (double)SDL_GetPerformanceFrequency();
+}
+
+static int32_t compare_doubles(const void *a, const void *b) {
+  const double da = *(const double *)a;
+  const double db = *(const double *)b;
+  return (da > db) - (da < db);
+}
+
+BenchStats bench_stats(double *samples_ms, uint32_t count) {
+  if (count == 0) {
+    return (BenchStats){0};
+  }
+  SDL_qsort(samples_ms, count, sizeof(double), compare_doubles);
+  double sum = 0.0;
+  for (uint32_t i = 0; i < count; ++i) {
+    sum += samples_ms[i];
+  }
+  return (BenchStats){
+      .count = count,
+      .mean = sum / count,
+      .p50 = samples_ms[(count - 1) / 2],
+      .p95 = samples_ms[(uint32_t)((count - 1) * 0.95)],
+      .p99 = samples_ms[(uint32_t)((count - 1) * 0.99)],
+      .min = samples_ms[0],
+      .max = samples_ms[count - 1],
+  };
+}
+
+static void json_key(BenchJson *json, const char *key) {
+  if (json->needs_comma[json->depth]) {
+    fprintf(json->file, ",");
+  }
+  json->needs_comma[json->depth] = true;
+  fprintf(json->file, "\n%*s", json->depth * 2, "");
+  if (key) {
+    fprintf(json->file, "\"%s\": ", key);
+  }
+}
+
+void bench_json_begin_object(BenchJson *json, const char *key) {
+  json_key(json, key);
+  fprintf(json->file, "{");
+  json->depth++;
+  json->needs_comma[json->depth] = false;
+}
+
+void bench_json_end_object(BenchJson *json) {
+  json->depth--;
+  fprintf(json->file, "\n%*s}", json->depth * 2, "");
+}
+
+void bench_json_begin_array(BenchJson *json, const char *key) {
+  json_key(json, key);
+  fprintf(json->file, "[");
+  json->depth++;
+  json->needs_comma[json->depth] = false;
+}
+
+void bench_json_end_array(BenchJson *json) {
+  json->depth--;
+  fprintf(json->file, "\n%*s]", json->depth * 2, "");
+}
+
+void bench_json_number(BenchJson *json, const char *key, double value) {
+  json_key(json, key);
+  fprintf(json->file, "%.6g", value);
+}
+
+void bench_json_string(BenchJson *json, const char *key, const char *value) {
+  json_key(json, key);
+  fprintf(json->file, "\"%s\"", value);
+}
+
+void bench_json_stats(BenchJson *json, const char *key,
+                      const BenchStats *stats) {
+  bench_json_begin_object(json, key);
+  bench_json_number(json, "samples", stats->count);
+  bench_json_number(json, "mean_ms", stats->mean);
+  bench_json_number(json, "p50_ms", stats->p50);
+  bench_json_number(json, "p95_ms", stats->p95);
+  bench_json_number(json, "p99_ms", stats->p99);
+  bench_json_number(json, "min_ms", stats->min);
+  bench_json_number(json, "max_ms", stats->max);
+  bench_json_end_object(json);
+}
+
+static uint32_t parse_scales(const char *arg, uint32_t *scales) {
+  uint32_t count = 0;
+  const char *cur = arg;
+  while (*cur && count < BENCH_MAX_SCALES) {
+    char *end = NULL;
+    scales[count++] = (uint32_t)SDL_strtoul(cur, &end, 10);
+    if (end == cur || *end != ',') {
+      break;
+    }
+    cur = end + 1;
+  }
+  return count;
+}
+
+int32_t main(int32_t argc, char *argv[]) {
+  const char *out_path = NULL;
+  uint32_t iterations = BENCH_DEFAULT_ITERATIONS;
+  uint32_t scales[BENCH_MAX_SCALES] = {0};
+  uint32_t scale_count = SDL_arraysize(default_scales);
+  SDL_memcpy(scales, default_scales, sizeof(default_scales));
+
+  for (int32_t i = 1; i < argc - 1; ++i) {
+    if (SDL_strcmp(argv[i], "--out") == 0) {
+      out_path = argv[i + 1];
+    } else if (SDL_strcmp(argv[i], "--iterations") == 0) {
+      iterations = (uint32_t)SDL_strtoul(argv[i + 1], NULL, 10);
+    } else if (SDL_strcmp(argv[i], "--scales") == 0) {
+      scale_count = parse_scales(argv[i + 1], scales);
+    }
+  }
+  iterations = SDL_clamp(iterations, 1u, (uint32_t)BENCH_MAX_SAMPLES);
+
+  if (SDL_Init(SDL_INIT_TIMER) != 0) {
+    SDL_Log("Failed to initialize SDL with error: %s", SDL_GetError());
+    return -1;
+  }
+
+  FILE *out = stdout;
+  if (out_path) {
+    out = fopen(out_path, "w");
+    if (out == NULL) {
+      SDL_Log("Failed to open %s for writing", out_path);
+      return -1;
+    }
+  }
+
+  TbGeneralAllocator gp_alloc = {0};
+  tb_create_gen_alloc(&gp_alloc, "bench_alloc");
+  ThsFrameMemory frame_mem = {0};
+  ths_create_frame_memory(gp_alloc.alloc, 1024 * 1024 * 64,
+                          THS_SCRATCH_ARENA_DEFAULT_SIZE, &frame_mem);
+
+  BenchJson json = {.file = out};
+  BenchContext ctx = {
+      .alloc = gp_alloc.alloc,
+      .frame_mem = &frame_mem,
+      .json = &json,
+      .iterations = iterations,
+  };
+
+  bench_json_begin_object(&json, NULL);
+  bench_json_number(&json, "iterations", iterations);
+  bench_json_number(&json, "cpu_count", SDL_GetCPUCount());
+  bench_json_number(&json, "simd_lanes", THS_LANE_WIDTH);
+
+  bench_ocean_sampling(&ctx);
+  bench_scene_io(&ctx);
+  bench_systems(&ctx, scales, scale_count);
+  bench_spatial_hash(&ctx);
+  bench_audio(&ctx, scales, scale_count);
+
+  bench_json_end_object(&json);
+  fprintf(out, "\n");
+
+  if (out != stdout) {
+    fclose(out);
+  }
+
+  ths_destroy_frame_memory(&frame_mem);
+  tb_destroy_gen_alloc(gp_alloc);
+  SDL_Quit();
+  return 0;
+}
@@ -0,0 +1,143 @@
+// Compares the batched ocean sampler against calling tb_sample_ocean once per
+// point, which is what the boat movement system used to do
+#include "bench.h"
+
+#include "oceancomponent.h"
+#include "oceansampling.h"
+#include "tbcommon.h"
+#include "transformcomponent.h"
+
+#include <SDL3/SDL.h>
+
+#include <flecs.h>
+
+static const uint32_t sample_counts[] = {6, 600, 6000, 60000};
+
+static float bench_randf(uint32_t *state) {
+  // xorshift32; deterministic so every run samples the same points
+  uint32_t x = *state;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  *state = x;
+  return (float)(x >> 8) / (float)(1u << 24);
+}
+
+static ecs_entity_t create_bench_ocean(ecs_world_t *ecs) {
+  TbOceanComponent ocean = {
+      .time = 12.5f,
+      .wave_count = 4,
+      .waves =
+          {
+              {.steepness = 0.4f,
+               .wavelength = 60.0f,
+               .direction_x = 1.0f,
+               .direction_y = 0.2f},
+              {.steepness = 0.3f,
+               .wavelength = 31.0f,
+               .direction_x = 0.8f,
+               .direction_y = 0.6f},
+              {.steepness = 0.2f,
+               .wavelength = 18.0f,
+               .direction_x = -0.3f,
+               .direction_y = 1.0f},
+              {.steepness = 0.1f,
+               .wavelength = 9.0f,
+               .direction_x = 0.5f,
+               .direction_y = -0.9f},
+          },
+  };
+  TbTransformComponent trans = {
+      .transform =
+          {
+              .position = {0},
+              .scale = {1, 1, 1},
+              .rotation = {0, 0, 0, 1},
+          },
+  };
+
+  ecs_entity_t ent = ecs_new_entity(ecs, "Bench Ocean");
+  ecs_set_ptr(ecs, ent, TbTransformComponent, &trans);
+  ecs_set_ptr(ecs, ent, TbOceanComponent, &ocean);
+  tb_transform_mark_dirty(ecs, ent);
+  return ent;
+}
+
+void bench_ocean_sampling(BenchContext *ctx) {
+  TbAllocator alloc = ctx->alloc;
+  BenchJson *json = ctx->json;
+
+  ecs_world_t *ecs = ecs_init();
+  ECS_COMPONENT_DEFINE(ecs, TbTransformComponent);
+  ECS_COMPONENT_DEFINE(ecs, TbOceanComponent);
+
+  ecs_entity_t ocean_ent = create_bench_ocean(ecs);
+  const TbOceanComponent *ocean = ecs_get(ecs, ocean_ent, TbOceanComponent);
+
+  double *scalar_ms = tb_alloc_nm_tp(alloc, ctx->iterations, double);
+  double *batch_ms = tb_alloc_nm_tp(alloc, ctx->iterations, double);
+
+  bench_json_begin_array(json, "ocean_sampling");
+  for (uint32_t c = 0; c < SDL_arraysize(sample_counts); ++c) {
+    const uint32_t count = sample_counts[c];
+
+    ThsOceanSampleBatch batch = {0};
+    ths_create_ocean_batch(alloc, count, &batch);
+
+    // Spread points over an area similar to a fleet
+    uint32_t seed = 0x5EA5;
+    for (uint32_t i = 0; i < count; ++i) {
+      batch.x[i] = bench_randf(&seed) * 1000.0f - 500.0f;
+      batch.z[i] = bench_randf(&seed) * 1000.0f - 500.0f;
+    }
+
+    // Make sure both paths agree before timing them
+    float max_err = 0.0f;
+    ths_sample_ocean_batch(ocean, ecs, ocean_ent, &batch);
+    for (uint32_t i = 0; i < count; ++i) {
+      TbOceanSample s = tb_sample_ocean(ocean, ecs, ocean_ent,
+                                        (float2){batch.x[i], batch.z[i]});
+      max_err = SDL_max(max_err, SDL_fabsf(s.pos.y - batch.pos_y[i]));
+    }
+
+    // Accumulate results so the compiler can't drop any of the work
+    float sink = 0.0f;
+
+    for (uint32_t iter = 0; iter < ctx->iterations; ++iter) {
+      uint64_t start = bench_now();
+      for (uint32_t i = 0; i < count; ++i) {
+        TbOceanSample s = tb_sample_ocean(ocean, ecs, ocean_ent,
+                                          (float2){batch.x[i], batch.z[i]});
+        sink += s.pos.y;
+      }
+      scalar_ms[iter] = bench_ms_since(start);
+
+      start = bench_now();
+      ths_sample_ocean_batch(ocean, ecs, ocean_ent, &batch);
+      sink += batch.pos_y[0];
+      batch_ms[iter] = bench_ms_since(start);
+    }
+    if (sink == 0.0f) {
+      SDL_Log("Ocean produced no displacement; check the wave setup");
+    }
+
+    BenchStats scalar = bench_stats(scalar_ms, ctx->iterations);
+    BenchStats batched = bench_stats(batch_ms, ctx->iterations);
+
+    bench_json_begin_object(json, NULL);
+    bench_json_number(json, "samples", count);
+    bench_json_number(json, "max_error", (double)max_err);
+    bench_json_number(json, "speedup",
+                      scalar.p50 / SDL_max(batched.p50, 1e-9));
+    bench_json_stats(json, "scalar", &scalar);
+    bench_json_stats(json, "batch", &batched);
+    bench_json_end_object(json);
+
+    ths_destroy_ocean_batch(alloc, &batch);
+  }
+  bench_json_end_array(json);
+
+  tb_free(alloc, scalar_ms);
+  tb_free(alloc, batch_ms);
+  ecs_fini(ecs);
+}
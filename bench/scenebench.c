@@ -0,0 +1,60 @@
+// Times the scene loader's background read ahead: mapping a glb and
+// faulting in every page the way the loader thread does before
+// tb_load_scene reads the file on the main thread
+#include "bench.h"
+
+#include "assets.h"
+#include "mappedfile.h"
+#include "tbcommon.h"
+
+#include <SDL3/SDL.h>
+
+static const char *bench_scenes[] = {
+    "scenes/mainmenu.glb",
+    "scenes/boat2.glb",
+};
+
+static bool read_ahead(const char *path, size_t *size) {
+  ThsMappedFile file = {0};
+  if (!ths_map_file(path, &file)) {
+    return false;
+  }
+  ths_prefault_mapped_file(&file, 0, file.size);
+  *size = file.size;
+  ths_unmap_file(&file);
+  return true;
+}
+
+void bench_scene_io(BenchContext *ctx) {
+  const uint32_t iterations = ctx->iterations;
+  double *samples = tb_alloc_nm_tp(ctx->alloc, iterations, double);
+
+  bench_json_begin_array(ctx->json, "scene_io");
+  for (uint32_t i = 0; i < SDL_arraysize(bench_scenes); ++i) {
+    char *path = tb_resolve_asset_path(ctx->alloc, bench_scenes[i]);
+    SDL_Log("Bench: scene io for %s", bench_scenes[i]);
+
+    // The first read warms the file cache; the game's read ahead usually
+    // runs against a cold one so these are a lower bound
+    size_t size = 0;
+    bool ok = read_ahead(path, &size);
+    for (uint32_t it = 0; it < iterations; ++it) {
+      const uint64_t start = bench_now();
+      ok = read_ahead(path, &size) && ok;
+      samples[it] = bench_ms_since(start);
+    }
+    const BenchStats stats = bench_stats(samples, iterations);
+
+    bench_json_begin_object(ctx->json, NULL);
+    bench_json_string(ctx->json, "scene", bench_scenes[i]);
+    bench_json_number(ctx->json, "ok", ok ? 1 : 0);
+    bench_json_number(ctx->json, "file_bytes", (double)size);
+    bench_json_stats(ctx->json, "read_ahead", &stats);
+    bench_json_end_object(ctx->json);
+
+    tb_free(ctx->alloc, path);
+  }
+  bench_json_end_array(ctx->json);
+
+  tb_free(ctx->alloc, samples);
+}
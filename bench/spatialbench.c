@@ -0,0 +1,152 @@
+// Times the boat spatial hash against a brute force pass over every pair at
+// the fleet sizes the game is expected to reach
+#include "bench.h"
+
+#include "spatialhash.h"
+#include "tbcommon.h"
+
+#include <SDL3/SDL.h>
+
+#define BENCH_HASH_SPACING 20.0f
+#define BENCH_HASH_CELL_SIZE 16.0f
+#define BENCH_HASH_RADIUS 30.0f
+#define BENCH_HASH_MAX_HITS 64
+// Brute force is quadratic so it only gets a few iterations
+#define BENCH_BRUTE_ITERATIONS 5
+
+static const uint32_t hash_scales[] = {1000, 10000};
+
+// Boats on a grid like the generated fleets, jittered so cells don't line up
+static void fill_entries(ThsSpatialHashEntry *entries, uint32_t count) {
+  const uint32_t row_len = (uint32_t)SDL_ceilf(SDL_sqrtf((float)count));
+  const float half_extent = (float)row_len * BENCH_HASH_SPACING * 0.5f;
+  uint32_t seed = 0x12345678;
+  for (uint32_t i = 0; i < count; ++i) {
+    seed = seed * 1664525u + 1013904223u;
+    const float jitter_x = (float)(seed >> 16) / 65535.0f - 0.5f;
+    seed = seed * 1664525u + 1013904223u;
+    const float jitter_z = (float)(seed >> 16) / 65535.0f - 0.5f;
+    entries[i] = (ThsSpatialHashEntry){
+        .pos = {(float)(i % row_len) * BENCH_HASH_SPACING - half_extent +
+                    jitter_x * BENCH_HASH_SPACING,
+                (float)(i / row_len) * BENCH_HASH_SPACING - half_extent +
+                    jitter_z * BENCH_HASH_SPACING},
+        .radius = 1.4f,
+        .hull = i + 1,
+        .boat = i + 1,
+    };
+  }
+}
+
+static void bench_hash_scale(BenchContext *ctx, uint32_t count,
+                             double *samples) {
+  BenchJson *json = ctx->json;
+
+  ThsSpatialHashEntry *entries =
+      tb_alloc_nm_tp(ctx->alloc, count, ThsSpatialHashEntry);
+  fill_entries(entries, count);
+  uint32_t hits[BENCH_HASH_MAX_HITS] = {0};
+
+  ThsSpatialHash hash = {0};
+  ths_create_spatial_hash(ctx->alloc, BENCH_HASH_CELL_SIZE, &hash);
+
+  bench_json_begin_object(json, NULL);
+  bench_json_number(json, "boats", count);
+
+  for (uint32_t i = 0; i < ctx->iterations; ++i) {
+    uint64_t start = bench_now();
+    ths_spatial_hash_build(&hash, entries, count);
+    samples[i] = bench_ms_since(start);
+  }
+  BenchStats stats = bench_stats(samples, ctx->iterations);
+  bench_json_stats(json, "build", &stats);
+
+  // One radius query per boat
+  uint64_t neighbours = 0;
+  for (uint32_t i = 0; i < ctx->iterations; ++i) {
+    neighbours = 0;
+    uint64_t start = bench_now();
+    for (uint32_t e = 0; e < count; ++e) {
+      neighbours += ths_spatial_hash_query(&hash, entries[e].pos,
+                                           BENCH_HASH_RADIUS, hits,
+                                           BENCH_HASH_MAX_HITS);
+    }
+    samples[i] = bench_ms_since(start);
+  }
+  stats = bench_stats(samples, ctx->iterations);
+  bench_json_stats(json, "radius_queries", &stats);
+  bench_json_number(json, "neighbours", (double)neighbours);
+
+  // What separation does every step; the nearest neighbours of other boats
+  uint64_t closest = 0;
+  for (uint32_t i = 0; i < ctx->iterations; ++i) {
+    closest = 0;
+    uint64_t start = bench_now();
+    for (uint32_t e = 0; e < count; ++e) {
+      closest += ths_spatial_hash_query_closest(
+          &hash, entries[e].pos, BENCH_HASH_RADIUS, entries[e].boat, hits,
+          BENCH_HASH_MAX_HITS);
+    }
+    samples[i] = bench_ms_since(start);
+  }
+  stats = bench_stats(samples, ctx->iterations);
+  bench_json_stats(json, "closest_queries", &stats);
+  bench_json_number(json, "closest_neighbours", (double)closest);
+
+  uint64_t found = 0;
+  for (uint32_t i = 0; i < ctx->iterations; ++i) {
+    found = 0;
+    uint64_t start = bench_now();
+    for (uint32_t e = 0; e < count; ++e) {
+      found += ths_spatial_hash_nearest(&hash, entries[e].pos,
+                                        BENCH_HASH_RADIUS * 4.0f,
+                                        entries[e].hull) >= 0;
+    }
+    samples[i] = bench_ms_since(start);
+  }
+  stats = bench_stats(samples, ctx->iterations);
+  bench_json_stats(json, "nearest_queries", &stats);
+  bench_json_number(json, "nearest_found", (double)found);
+
+  // What every boat checking every other boat costs, for comparison. The
+  // neighbour count should match the hash's
+  const uint32_t brute_iterations =
+      SDL_min(ctx->iterations, (uint32_t)BENCH_BRUTE_ITERATIONS);
+  const float radius_sq = BENCH_HASH_RADIUS * BENCH_HASH_RADIUS;
+  uint64_t brute_neighbours = 0;
+  for (uint32_t i = 0; i < brute_iterations; ++i) {
+    brute_neighbours = 0;
+    uint64_t start = bench_now();
+    for (uint32_t a = 0; a < count; ++a) {
+      uint32_t hit_count = 0;
+      for (uint32_t b = 0; b < count; ++b) {
+        const float2 d = entries[b].pos - entries[a].pos;
+        if (d.x * d.x + d.y * d.y <= radius_sq) {
+          hit_count++;
+        }
+      }
+      brute_neighbours += SDL_min(hit_count, (uint32_t)BENCH_HASH_MAX_HITS);
+    }
+    samples[i] = bench_ms_since(start);
+  }
+  stats = bench_stats(samples, brute_iterations);
+  bench_json_stats(json, "brute_force", &stats);
+  bench_json_number(json, "brute_force_neighbours", (double)brute_neighbours);
+
+  bench_json_end_object(json);
+
+  ths_destroy_spatial_hash(&hash);
+  tb_free(ctx->alloc, entries);
+}
+
+void bench_spatial_hash(BenchContext *ctx) {
+  double *samples = tb_alloc_nm_tp(ctx->alloc, ctx->iterations, double);
+
+  bench_json_begin_array(ctx->json, "spatial_hash");
+  for (uint32_t i = 0; i < SDL_arraysize(hash_scales); ++i) {
+    bench_hash_scale(ctx, hash_scales[i], samples);
+  }
+  bench_json_end_array(ctx->json);
+
+  tb_free(ctx->alloc, samples);
+}
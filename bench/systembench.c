@@ -0,0 +1,310 @@
+// Times the boat systems against generated fleets of increasing size, plus
+// the JSON component loaders the scene loader calls for every boat
+#include "bench.h"
+
+#include "boatcameracomponent.h"
+#include "boatlod.h"
+#include "boatmovementcomponent.h"
+#include "cookedcomponents.h"
+#include "navigation.h"
+#include "simulation.h"
+#include "simworld.h"
+#include "tbcommon.h"
+#include "tbgltf.h"
+#include "transformcomponent.h"
+
+#include <SDL3/SDL.h>
+
+#include <json.h>
+
+#define BENCH_FLEET_SPACING 20.0f
+#define BENCH_WARMUP_STEPS 8
+#define BENCH_NAV_CELL_SIZE 8.0f
+#define BENCH_NAV_ISLAND_COUNT 4
+
+bool ths_load_boat_movement_comp(TbWorld *world, ecs_entity_t ent,
+                                 const char *source_path,
+                                 const cgltf_node *node, json_object *json);
+bool ths_load_boat_camera_comp(TbWorld *world, ecs_entity_t ent,
+                               const char *source_path, const cgltf_node *node,
+                               json_object *json);
+
+// Systems are looked up by name so this doesn't need to reach into the
+// system implementations
+static const char *system_names[] = {
+    "Wind Update",         "Spatial Hash Update",
+    "Ship AI Tick",        "Boat Movement Prepare",
+    "Boat Movement Tick",  "Boat Movement Merge",
+    "boat_camera_update_tick",
+};
+
+// Matches what the boat scene carries in its extras
+static const char *boat_movement_json =
+    "{\"heading_change_speed\": 0.5, \"acceleration\": 2.0, "
+    "\"max_speed\": 10.0, \"inertia\": 0.5, \"friction\": 0.2, "
+    "\"half_width\": 1.0, \"half_length\": 1.0, \"half_height\": 0.5, "
+    "\"density\": 500.0}";
+static const char *boat_camera_json =
+    "{\"min_dist\": 10.0, \"max_dist\": 40.0, \"move_speed\": 1.0, "
+    "\"zoom_speed\": 1.0, \"pitch_limit\": 0.8}";
+// The same values as the cook step would pack them; both descriptors are
+// plain floats
+static const float boat_movement_cooked[] = {0.5f, 2.0f, 10.0f, 0.5f, 0.2f,
+                                             1.0f, 1.0f, 0.5f, 500.0f};
+static const float boat_camera_cooked[] = {10.0f, 40.0f, 1.0f, 1.0f, 0.8f};
+#define BENCH_COOKED_SCENE "bench_cooked.glb"
+#define BENCH_COOKED_NODE "Bench Boat"
+
+// Systems run in pipeline order every iteration since the movement tick
+// buffers writes that only the merge clears. ecs_run calls each one on this
+// thread, so multi threaded systems are timed single threaded here; sim_step
+// is the number with the worker pipeline behind it
+static void bench_pipeline(BenchContext *ctx, TbWorld *world,
+                           const ecs_entity_t *systems, float step,
+                           double *samples) {
+  for (uint32_t i = 0; i < ctx->iterations; ++i) {
+    for (uint32_t s = 0; s < SDL_arraysize(system_names); ++s) {
+      if (systems[s] == 0) {
+        continue;
+      }
+      uint64_t start = bench_now();
+      ecs_run(world->ecs, systems[s], step, NULL);
+      samples[s * ctx->iterations + i] = bench_ms_since(start);
+    }
+    ths_frame_memory_end_frame(ctx->frame_mem);
+  }
+}
+
+static void bench_step(BenchContext *ctx, TbWorld *world, float step,
+                       double *samples) {
+  for (uint32_t i = 0; i < ctx->iterations; ++i) {
+    uint64_t start = bench_now();
+    ths_sim_advance(world->ecs, step);
+    samples[i] = bench_ms_since(start);
+    ths_frame_memory_end_frame(ctx->frame_mem);
+  }
+}
+
+typedef bool (*BenchLoadFn)(TbWorld *, ecs_entity_t, const char *,
+                            const cgltf_node *, json_object *);
+
+static void bench_loader(BenchContext *ctx, TbWorld *world, uint32_t count,
+                         const char *json_str, const char *source_path,
+                         const cgltf_node *node, BenchLoadFn load,
+                         double *samples) {
+  // Parse once up front; the scene loader hands components an already
+  // parsed object too
+  json_object *json = json_tokener_parse(json_str);
+  // Loaders expect what the scene gives them: each node under its own boat
+  // root that has a transform. Far from the fleet so nothing reacts to them
+  TbTransformComponent trans = {
+      .transform =
+          {
+              .scale = {1, 1, 1},
+              .rotation = {0, 0, 0, 1},
+          },
+  };
+  TbTransformComponent boat_trans = trans;
+  boat_trans.transform.position = (float3){0, 0, -10000};
+  ecs_entity_t *boats = tb_alloc_nm_tp(ctx->alloc, count, ecs_entity_t);
+  ecs_entity_t *ents = tb_alloc_nm_tp(ctx->alloc, count, ecs_entity_t);
+  for (uint32_t i = 0; i < count; ++i) {
+    boats[i] = ecs_new_id(world->ecs);
+    ecs_set_ptr(world->ecs, boats[i], TbTransformComponent, &boat_trans);
+    ents[i] = ecs_new_w_pair(world->ecs, EcsChildOf, boats[i]);
+    ecs_set_ptr(world->ecs, ents[i], TbTransformComponent, &trans);
+  }
+  for (uint32_t i = 0; i < ctx->iterations; ++i) {
+    uint64_t start = bench_now();
+    for (uint32_t e = 0; e < count; ++e) {
+      load(world, ents[e], source_path, node, json);
+    }
+    samples[i] = bench_ms_since(start);
+  }
+  for (uint32_t i = 0; i < count; ++i) {
+    // Takes the node with it
+    ecs_delete(world->ecs, boats[i]);
+  }
+  tb_free(ctx->alloc, ents);
+  tb_free(ctx->alloc, boats);
+  json_object_put(json);
+}
+
+static void bind_bench_cooked(BenchContext *ctx, TbWorld *world) {
+  ThsCookedWriter writer = {0};
+  ths_create_cooked_writer(ctx->alloc, &writer);
+  ths_cooked_writer_add(&writer, BENCH_COOKED_NODE, "ThsBoatMovementDescriptor",
+                        boat_movement_cooked, sizeof(boat_movement_cooked));
+  ths_cooked_writer_add(&writer, BENCH_COOKED_NODE, "ThsBoatCameraDescriptor",
+                        boat_camera_cooked, sizeof(boat_camera_cooked));
+  size_t size = 0;
+  uint8_t *blob = ths_cooked_writer_finish(&writer, &size);
+  ths_bind_cooked_components(world, ctx->alloc, BENCH_COOKED_SCENE, blob,
+                             size);
+  ths_destroy_cooked_writer(&writer);
+}
+
+// A grid over the whole fleet with a ring of round islands between the
+// boats and their destinations so fields have something to route around
+static void bind_bench_nav_grid(BenchContext *ctx, TbWorld *world,
+                                uint32_t boat_count) {
+  const uint32_t row_len = (uint32_t)SDL_ceilf(SDL_sqrtf((float)boat_count));
+  const float half_extent =
+      (float)row_len * BENCH_FLEET_SPACING * 0.5f + BENCH_FLEET_SPACING;
+  const uint32_t side =
+      (uint32_t)SDL_ceilf(half_extent * 2.0f / BENCH_NAV_CELL_SIZE);
+  ThsNavGridHeader header = {
+      .magic = THS_NAV_MAGIC,
+      .version = THS_NAV_VERSION,
+      .width = side,
+      .height = side,
+      .cell_size = BENCH_NAV_CELL_SIZE,
+      .origin_x = -half_extent,
+      .origin_z = -half_extent,
+  };
+  uint8_t *blocked = tb_alloc_nm_tp(ctx->alloc, side * side, uint8_t);
+  SDL_memset(blocked, 0, side * side);
+
+  const float ring = half_extent * 0.5f;
+  const float radius = half_extent * 0.15f;
+  for (uint32_t i = 0; i < BENCH_NAV_ISLAND_COUNT; ++i) {
+    const float angle = (float)i * (2.0f * SDL_PI_F / BENCH_NAV_ISLAND_COUNT);
+    const float cx = SDL_cosf(angle) * ring;
+    const float cz = SDL_sinf(angle) * ring;
+    for (uint32_t z = 0; z < side; ++z) {
+      for (uint32_t x = 0; x < side; ++x) {
+        const float px = header.origin_x + ((float)x + 0.5f) * header.cell_size;
+        const float pz = header.origin_z + ((float)z + 0.5f) * header.cell_size;
+        const float dx = px - cx;
+        const float dz = pz - cz;
+        if (dx * dx + dz * dz <= radius * radius && !blocked[z * side + x]) {
+          blocked[z * side + x] = 1;
+          header.blocked_count++;
+        }
+      }
+    }
+  }
+  ths_nav_set_grid(world->ecs, &header, blocked);
+  tb_free(ctx->alloc, blocked);
+}
+
+static void bench_scale(BenchContext *ctx, uint32_t boat_count,
+                        double *samples) {
+  BenchJson *json = ctx->json;
+
+  TbWorld world = {0};
+  ThsSimWorldDesc desc = {
+      .gp_alloc = ctx->alloc,
+      .frame_mem = ctx->frame_mem,
+  };
+  if (!ths_create_sim_world(&desc, &world)) {
+    SDL_Log("Bench: failed to create simulation world");
+    return;
+  }
+  ths_spawn_sim_ocean(&world);
+  ThsFleetDesc fleet = {
+      .boat_count = boat_count,
+      .spacing = BENCH_FLEET_SPACING,
+      .with_cameras = true,
+      .with_ai = true,
+  };
+  ths_spawn_fleet(&world, &fleet);
+  bind_bench_nav_grid(ctx, &world, boat_count);
+
+  // Let transforms settle before timing anything
+  const float step = ecs_singleton_get(world.ecs, ThsSimClock)->step;
+  for (uint32_t i = 0; i < BENCH_WARMUP_STEPS; ++i) {
+    ths_sim_advance(world.ecs, step);
+    ths_frame_memory_end_frame(ctx->frame_mem);
+  }
+
+  bench_json_begin_object(json, NULL);
+  bench_json_number(json, "boats", boat_count);
+  // What the movement tick touches per hull; tuning is shared per class
+  bench_json_number(json, "hull_state_bytes",
+                    (double)sizeof(ThsBoatMovementComponent));
+
+  bench_step(ctx, &world, step, samples);
+  BenchStats stats = bench_stats(samples, ctx->iterations);
+  bench_json_stats(json, "sim_step", &stats);
+
+  // How the fleet was split between LOD tiers on the last step
+  const ThsBoatLodCounters lod = ths_boat_lod_counters(world.ecs);
+  bench_json_begin_object(json, "lod");
+  bench_json_number(json, "near", lod.tiers[THS_BOAT_LOD_NEAR]);
+  bench_json_number(json, "mid", lod.tiers[THS_BOAT_LOD_MID]);
+  bench_json_number(json, "far", lod.tiers[THS_BOAT_LOD_FAR]);
+  bench_json_number(json, "asleep", lod.asleep);
+  bench_json_number(json, "ticked", lod.ticked);
+  bench_json_end_object(json);
+
+  // Fleet AI shares a handful of fields so lookups should dwarf builds
+  const tb_auto *nav = ecs_singleton_get(world.ecs, ThsNavigation);
+  bench_json_begin_object(json, "nav");
+  bench_json_number(json, "lookups", nav->lookups);
+  bench_json_number(json, "fields_built", nav->fields_built);
+  bench_json_number(json, "fields_resident", nav->fields_resident);
+  bench_json_number(json, "build_ms", nav->build_ms);
+  bench_json_end_object(json);
+
+  ecs_entity_t systems[SDL_arraysize(system_names)] = {0};
+  for (uint32_t i = 0; i < SDL_arraysize(system_names); ++i) {
+    systems[i] = ecs_lookup(world.ecs, system_names[i]);
+    if (systems[i] == 0) {
+      SDL_Log("Bench: no system named %s", system_names[i]);
+    }
+  }
+  bench_pipeline(ctx, &world, systems, step, samples);
+
+  bench_json_begin_object(json, "systems_single_threaded");
+  for (uint32_t i = 0; i < SDL_arraysize(system_names); ++i) {
+    if (systems[i] != 0) {
+      stats = bench_stats(&samples[i * ctx->iterations], ctx->iterations);
+      bench_json_stats(json, system_names[i], &stats);
+    }
+  }
+  bench_json_end_object(json);
+
+  bench_json_begin_object(json, "component_loading");
+  bench_loader(ctx, &world, boat_count, boat_movement_json, "bench", NULL,
+               ths_load_boat_movement_comp, samples);
+  stats = bench_stats(samples, ctx->iterations);
+  bench_json_stats(json, "boat_movement", &stats);
+  bench_loader(ctx, &world, boat_count, boat_camera_json, "bench", NULL,
+               ths_load_boat_camera_comp, samples);
+  stats = bench_stats(samples, ctx->iterations);
+  bench_json_stats(json, "boat_camera", &stats);
+
+  // Same loaders reading from a cooked sidecar instead
+  bind_bench_cooked(ctx, &world);
+  cgltf_node node = {.name = BENCH_COOKED_NODE};
+  bench_loader(ctx, &world, boat_count, boat_movement_json, BENCH_COOKED_SCENE,
+               &node, ths_load_boat_movement_comp, samples);
+  stats = bench_stats(samples, ctx->iterations);
+  bench_json_stats(json, "boat_movement_cooked", &stats);
+  bench_loader(ctx, &world, boat_count, boat_camera_json, BENCH_COOKED_SCENE,
+               &node, ths_load_boat_camera_comp, samples);
+  stats = bench_stats(samples, ctx->iterations);
+  bench_json_stats(json, "boat_camera_cooked", &stats);
+  bench_json_end_object(json);
+
+  bench_json_end_object(json);
+
+  ths_destroy_sim_world(&world);
+}
+
+void bench_systems(BenchContext *ctx, const uint32_t *scales,
+                   uint32_t scale_count) {
+  // One row of samples per system
+  const uint32_t sample_count =
+      ctx->iterations * (uint32_t)SDL_arraysize(system_names);
+  double *samples = tb_alloc_nm_tp(ctx->alloc, sample_count, double);
+
+  bench_json_begin_array(ctx->json, "systems");
+  for (uint32_t i = 0; i < scale_count; ++i) {
+    bench_scale(ctx, scales[i], samples);
+  }
+  bench_json_end_array(ctx->json);
+
+  tb_free(ctx->alloc, samples);
+}
@@ -1,10 +1,15 @@
 #include "boatcameracomponent.h"
 
+#include "classprefab.h"
+#include "cookedcomponents.h"
+#include "tbcommon.h"
+#include "transformcomponent.h"
 #include "world.h"
 
 #include <flecs.h>
 #include <json.h>
 
+ECS_COMPONENT_DECLARE(ThsBoatCameraTuningComponent);
 ECS_COMPONENT_DECLARE(ThsBoatCameraComponent);
 
 typedef struct ThsBoatCameraDescriptor {
@@ -16,36 +21,115 @@ typedef struct ThsBoatCameraDescriptor {
 } ThsBoatCameraDescriptor;
 ECS_COMPONENT_DECLARE(ThsBoatCameraDescriptor);
 
-bool ths_load_boat_camera_comp(TbWorld *world, ecs_entity_t ent,
-                               const char *source_path, const cgltf_node *node,
-                               json_object *object) {
-  (void)node;
-  (void)source_path;
-  ThsBoatCameraComponent comp = {0};
+static void parse_boat_camera_desc(json_object *object,
+                                   ThsBoatCameraDescriptor *desc) {
   json_object_object_foreach(object, key, value) {
     if (SDL_strcmp(key, "min_dist") == 0) {
-      comp.min_dist = (float)json_object_get_double(value);
+      desc->min_dist = (float)json_object_get_double(value);
     } else if (SDL_strcmp(key, "max_dist") == 0) {
-      comp.max_dist = (float)json_object_get_double(value);
+      desc->max_dist = (float)json_object_get_double(value);
     } else if (SDL_strcmp(key, "move_speed") == 0) {
-      comp.move_speed = (float)json_object_get_double(value);
+      desc->move_speed = (float)json_object_get_double(value);
     } else if (SDL_strcmp(key, "zoom_speed") == 0) {
-      comp.zoom_speed = (float)json_object_get_double(value);
+      desc->zoom_speed = (float)json_object_get_double(value);
     } else if (SDL_strcmp(key, "pitch_limit") == 0) {
-      comp.pitch_limit = (float)json_object_get_double(value);
+      desc->pitch_limit = (float)json_object_get_double(value);
     }
   }
+}
+
+ecs_entity_t
+ths_boat_camera_class_prefab(ecs_world_t *ecs,
+                             const ThsBoatCameraTuningComponent *tuning) {
+  return ths_class_prefab(ecs, "BoatCameraClass",
+                          ecs_id(ThsBoatCameraTuningComponent),
+                          sizeof(*tuning), tuning);
+}
+
+bool ths_load_boat_camera_comp(TbWorld *world, ecs_entity_t ent,
+                               const char *source_path, const cgltf_node *node,
+                               json_object *object) {
+  // Scenes cooked with COOK_ASSETS carry this already packed
+  ThsBoatCameraDescriptor desc = {0};
+  const ThsBoatCameraDescriptor *cooked = ths_find_cooked_component(
+      world, source_path, node, "ThsBoatCameraDescriptor", sizeof(desc));
+  if (cooked) {
+    desc = *cooked;
+  } else {
+    parse_boat_camera_desc(object, &desc);
+  }
+
+  ThsBoatCameraTuningComponent tuning = {
+      .min_dist = desc.min_dist,
+      .max_dist = desc.max_dist,
+      .move_speed = desc.move_speed,
+      .zoom_speed = desc.zoom_speed,
+      .pitch_limit = desc.pitch_limit,
+  };
+  ecs_add_pair(world->ecs, ent, EcsIsA,
+               ths_boat_camera_class_prefab(world->ecs, &tuning));
+  // Starts from wherever the camera was placed in the scene
+  ThsBoatCameraComponent comp = {0};
   ecs_set_ptr(world->ecs, ent, ThsBoatCameraComponent, &comp);
   return true;
 }
 
 void ths_destroy_boat_camera_comp(TbWorld *world, ecs_entity_t ent) {
   ecs_remove(world->ecs, ent, ThsBoatCameraComponent);
+  ths_remove_class_prefab(world->ecs, ent,
+                          ecs_id(ThsBoatCameraTuningComponent));
+}
+
+bool ths_find_active_boat_camera(ecs_world_t *ecs, ecs_query_t **query,
+                                 ThsActiveBoatCamera *active) {
+  if (*query == NULL) {
+    *query = ecs_query(ecs, {.filter.terms =
+                                 {
+                                     {.id = ecs_id(TbTransformComponent),
+                                      .inout = EcsIn},
+                                     {.id = ecs_id(ThsBoatCameraComponent),
+                                      .inout = EcsIn},
+                                 }});
+  }
+  ecs_entity_t camera = 0;
+  ecs_iter_t it = ecs_query_iter(ecs, *query);
+  while (ecs_iter_next(&it)) {
+    if (it.count > 0) {
+      camera = it.entities[0];
+      ecs_iter_fini(&it);
+      break;
+    }
+  }
+  if (camera == 0) {
+    return false;
+  }
+
+  const TbTransform *local =
+      &ecs_get(ecs, camera, TbTransformComponent)->transform;
+  *active = (ThsActiveBoatCamera){
+      .camera = camera,
+      .hull = ecs_get_parent(ecs, camera),
+      .position = local->position,
+      .right = tb_transform_get_right(local),
+  };
+  for (ecs_entity_t ent = active->hull; ent != 0;
+       ent = ecs_get_parent(ecs, ent)) {
+    const tb_auto *trans = ecs_get(ecs, ent, TbTransformComponent);
+    if (trans == NULL) {
+      break;
+    }
+    const TbTransform *t = &trans->transform;
+    active->position =
+        t->position + tb_qrotf3(t->rotation, active->position * t->scale);
+    active->right = tb_qrotf3(t->rotation, active->right);
+  }
+  return true;
 }
 
 ecs_entity_t ths_register_boat_camera_comp(TbWorld *world) {
   ecs_world_t *ecs = world->ecs;
   ECS_COMPONENT_DEFINE(ecs, ThsBoatCameraDescriptor);
+  ECS_COMPONENT_DEFINE(ecs, ThsBoatCameraTuningComponent);
   ECS_COMPONENT_DEFINE(ecs, ThsBoatCameraComponent);
 
   ecs_struct(ecs,
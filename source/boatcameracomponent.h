@@ -4,14 +4,40 @@
 
 #include <flecs.h>
 
-typedef struct ThsBoatCameraComponent {
+// How a boat camera orbits and zooms. Shared by every camera set up the
+// same way through a prefab (see classprefab.h)
+typedef struct ThsBoatCameraTuningComponent {
   float min_dist;
   float max_dist;
   float move_speed;
   float zoom_speed;
   float pitch_limit;
+} ThsBoatCameraTuningComponent;
+extern ECS_COMPONENT_DECLARE(ThsBoatCameraTuningComponent);
 
-  float target_dist;
+// Where the camera currently wants to be relative to its hull
+typedef struct ThsBoatCameraComponent {
   float3 target_hull_to_camera;
+  float target_dist;
 } ThsBoatCameraComponent;
 extern ECS_COMPONENT_DECLARE(ThsBoatCameraComponent);
+
+// Prefab for cameras tuned like this, created the first time it's asked for
+ecs_entity_t
+ths_boat_camera_class_prefab(ecs_world_t *ecs,
+                             const ThsBoatCameraTuningComponent *tuning);
+
+// The camera the player looks through
+typedef struct ThsActiveBoatCamera {
+  ecs_entity_t camera;
+  ecs_entity_t hull; // What the camera follows
+  float3 position;   // World space
+  float3 right;      // World space
+} ThsActiveBoatCamera;
+
+// The first boat camera is the active one. World matrices are only rebuilt
+// after the simulation has stepped, so its pose is walked up the hierarchy.
+// The query is created on first use since the camera component may register
+// after the caller; the caller owns it. Returns false without a camera
+bool ths_find_active_boat_camera(ecs_world_t *ecs, ecs_query_t **query,
+                                 ThsActiveBoatCamera *active);
@@ -1,7 +1,11 @@
 #include "cameracomponent.h"
 #include "inputsystem.h"
+#include "profiler.h"
+#include "simulation.h"
 #include "tbcommon.h"
 #include "transformcomponent.h"
+#include "transformwrites.h"
+#include "vlog.h"
 #include "world.h"
 
 #include "boatcameracomponent.h"
@@ -9,28 +13,92 @@
 #include <SDL3/SDL_log.h>
 #include <flecs.h>
 
+typedef struct ThsBoatCameraLook {
+  float zoom;  // Mouse wheel clicks
+  float yaw;   // Radians
+  float pitch; // Radians
+} ThsBoatCameraLook;
+
+// Orbit and zoom input is gathered once per rendered frame and spent evenly
+// over the steps that frame takes, so the camera turns as far at any frame
+// rate and input on frames without a step waits for the next one
+typedef struct ThsBoatCameraInput {
+  ThsBoatCameraLook pending; // Not yet spent
+  ThsBoatCameraLook step;    // Spent by the current step
+} ThsBoatCameraInput;
+ECS_COMPONENT_DECLARE(ThsBoatCameraInput);
+
+static ThsProfileTrack camera_track = 0;
+
+void boat_camera_input_tick(ecs_iter_t *it) {
+  tb_auto *ecs = it->world;
+  const tb_auto *input = ecs_singleton_get(ecs, TbInputSystem);
+  tb_auto *pending = &ecs_singleton_get_mut(ecs, ThsBoatCameraInput)->pending;
+
+  pending->zoom += input->mouse.wheel[1];
+
+  float look_speed = 5.0f;
+  if (input->mouse.left || input->mouse.right || input->mouse.middle) {
+    float2 look_axis = input->mouse.axis;
+    pending->yaw += look_axis.x * it->delta_time * look_speed;
+    pending->pitch += look_axis.y * it->delta_time * look_speed;
+  } else if (input->gamepad_count > 0) {
+    const TbGameControllerState *ctl_state = &input->gamepad_states[0];
+    float2 look_axis = ctl_state->right_stick;
+    float deadzone = 0.15f;
+    if (look_axis.x > -deadzone && look_axis.x < deadzone) {
+      look_axis.x = 0.0f;
+    }
+    if (look_axis.y > -deadzone && look_axis.y < deadzone) {
+      look_axis.y = 0.0f;
+    }
+    pending->yaw += look_axis.x * it->delta_time;
+    pending->pitch += look_axis.y * it->delta_time;
+  }
+}
+
+// Runs once per step, ahead of the camera tick which may run per table
+void boat_camera_share_tick(ecs_iter_t *it) {
+  tb_auto *ecs = it->world;
+  const tb_auto *clock = ecs_singleton_get(ecs, ThsSimClock);
+  tb_auto *input = ecs_singleton_get_mut(ecs, ThsBoatCameraInput);
+  // Steps run outside of an advance, like the bench's, spend it all
+  const uint32_t steps_left = clock->frame_steps > clock->frame_step
+                                  ? clock->frame_steps - clock->frame_step
+                                  : 1;
+  input->step = (ThsBoatCameraLook){
+      .zoom = input->pending.zoom / (float)steps_left,
+      .yaw = input->pending.yaw / (float)steps_left,
+      .pitch = input->pending.pitch / (float)steps_left,
+  };
+  input->pending.zoom -= input->step.zoom;
+  input->pending.yaw -= input->step.yaw;
+  input->pending.pitch -= input->step.pitch;
+}
+
 void boat_camera_update_tick(ecs_iter_t *it) {
   TracyCZoneN(ctx, "Boat Camera Update System", true);
   TracyCZoneColor(ctx, TracyCategoryColorGame);
+  ThsProfileScope prof = ths_profile_begin(camera_track);
 
   tb_auto *ecs = it->world;
 
-  const tb_auto *input = ecs_singleton_get(ecs, TbInputSystem);
+  const tb_auto *look = &ecs_singleton_get(ecs, ThsBoatCameraInput)->step;
 
   tb_auto *transforms = ecs_field(it, TbTransformComponent, 1);
   tb_auto *boat_cameras = ecs_field(it, ThsBoatCameraComponent, 2);
+  // The parent transform tells us where the boat hull that we want to focus
+  // on is. Cameras in a table share a hull so it is the same for all of them
+  const tb_auto *hull_transform = ecs_field(it, TbTransformComponent, 3);
+  const float3 hull_pos = hull_transform->transform.position;
+  // Cameras in a table share a class too
+  const tb_auto *tuning = ecs_field(it, ThsBoatCameraTuningComponent, 4);
 
   for (int32_t i = 0; i < it->count; ++i) {
-    // Get parent transform to determine where the parent boat hull is that we
-    // want to focus on
     tb_auto entity = it->entities[i];
     tb_auto *transform_comp = &transforms[i];
     tb_auto *boat_cam = &boat_cameras[i];
 
-    tb_auto hull = ecs_get_parent(ecs, entity);
-    tb_auto hull_transform = ecs_get_mut(ecs, hull, TbTransformComponent);
-    tb_auto hull_pos = hull_transform->transform.position;
-
     // A target distance of 0 makes no sense; interpret as initialization
     // and set a variety of parameters to whatever is stored on the transform
     tb_auto target_dist = boat_cam->target_dist;
@@ -49,38 +117,16 @@ void boat_camera_update_tick(ecs_iter_t *it) {
         target_dist = tb_magf3(pos_hull_diff);
       }
 
-      target_dist += input->mouse.wheel[1] * boat_cam->zoom_speed;
-      target_dist =
-          tb_clampf(target_dist, boat_cam->min_dist, boat_cam->max_dist);
+      target_dist += look->zoom * tuning->zoom_speed;
+      target_dist = tb_clampf(target_dist, tuning->min_dist, tuning->max_dist);
     }
 
     // Arcball the camera around the boat
     {
-      float look_speed = 5.0f;
-      float look_yaw = 0.0f;
-      float look_pitch = 0.0f;
-      if (input->mouse.left || input->mouse.right || input->mouse.middle) {
-        float2 look_axis = input->mouse.axis;
-        look_yaw = look_axis.x * it->delta_time * look_speed;
-        look_pitch = look_axis.y * it->delta_time * look_speed;
-      } else if (input->gamepad_count > 0) {
-        const TbGameControllerState *ctl_state = &input->gamepad_states[0];
-        float2 look_axis = ctl_state->right_stick;
-        float deadzone = 0.15f;
-        if (look_axis.x > -deadzone && look_axis.x < deadzone) {
-          look_axis.x = 0.0f;
-        }
-        if (look_axis.y > -deadzone && look_axis.y < deadzone) {
-          look_axis.y = 0.0f;
-        }
-        look_yaw = look_axis.x * it->delta_time;
-        look_pitch = look_axis.y * it->delta_time;
-      }
-
-      tb_auto yaw_quat = tb_angle_axis_to_quat((float4){0, 1, 0, look_yaw});
+      tb_auto yaw_quat = tb_angle_axis_to_quat((float4){0, 1, 0, look->yaw});
       hull_to_camera = tb_normf3(tb_qrotf3(yaw_quat, hull_to_camera));
       tb_auto right = tb_normf3(tb_crossf3(TB_UP, hull_to_camera));
-      tb_auto pitch_quat = tb_angle_axis_to_quat(tb_f3tof4(right, look_pitch));
+      tb_auto pitch_quat = tb_angle_axis_to_quat(tb_f3tof4(right, look->pitch));
       hull_to_camera = tb_normf3(tb_qrotf3(pitch_quat, hull_to_camera));
     }
 
@@ -89,21 +135,85 @@ void boat_camera_update_tick(ecs_iter_t *it) {
 
     float3 camera_pos = (hull_to_camera * target_dist);
 
-    // Make sure the camera looks at the hull
-    transform_comp->transform =
+    if (THS_VLOG_ENABLED(THS_VLOG_CAMERA)) {
+      // The orbit is relative to the boat the hull belongs to
+      const ecs_entity_t hull = ecs_get_parent(ecs, entity);
+      const tb_auto *boat =
+          ecs_get(ecs, ecs_get_parent(ecs, hull), TbTransformComponent);
+      if (boat) {
+        const float3 focus = boat->transform.position + hull_pos;
+        THS_VLOG_LOCATION(ecs, THS_VLOG_CAMERA, focus, 0.5f, tb_f3(1, 1, 0));
+        THS_VLOG_LOCATION(ecs, THS_VLOG_CAMERA, focus + camera_pos, 0.25f,
+                          tb_f3(0, 1, 1));
+      }
+    }
+
+    // Make sure the camera looks at the hull. A camera that didn't move is
+    // dropped when the writes are applied
+    const TbTransform camera_transform =
         tb_look_forward_transform(camera_pos, -hull_to_camera, TB_UP);
-    tb_transform_mark_dirty(ecs, entity);
+    ths_write_transform(ecs, entity, &camera_transform);
   }
 
+  ths_profile_end(prof);
   TracyCZoneEnd(ctx);
 }
 
+void boat_camera_on_set(ecs_iter_t *it) {
+  for (int32_t i = 0; i < it->count; ++i) {
+    ths_sim_interpolate(it->world, it->entities[i]);
+  }
+}
+
 void ths_register_boat_camera_sys(TbWorld *world) {
   ecs_world_t *ecs = world->ecs;
+  ECS_COMPONENT_DEFINE(ecs, ThsBoatCameraTuningComponent);
   ECS_COMPONENT_DEFINE(ecs, ThsBoatCameraComponent);
-
-  ECS_SYSTEM(ecs, boat_camera_update_tick, EcsOnUpdate, TbTransformComponent,
-             ThsBoatCameraComponent);
+  ECS_COMPONENT_DEFINE(ecs, ThsBoatCameraInput);
+  ThsBoatCameraInput input = {0};
+  ecs_singleton_set_ptr(ecs, ThsBoatCameraInput, &input);
+
+  camera_track = ths_profiler_track("Boat Camera Update");
+
+  ecs_observer(ecs, {.filter.terms =
+                         {
+                             {.id = ecs_id(ThsBoatCameraComponent)},
+                         },
+                     .events = {EcsOnSet},
+                     .callback = boat_camera_on_set});
+
+  // Input the toybox input system or a replay left for this frame
+  ecs_system(ecs, {.entity = ecs_entity(ecs, {.name = "boat_camera_input_tick",
+                                              .add = {ecs_dependson(
+                                                  ths_sim_frame_phase(ecs))}}),
+                   .callback = boat_camera_input_tick});
+
+  // Systems in a phase run in the order they were registered
+  ecs_system(ecs, {.entity = ecs_entity(
+                       ecs, {.name = "boat_camera_share_tick",
+                             .add = {ecs_dependson(ths_sim_phase(
+                                 ecs, THS_SIM_POST_UPDATE))}}),
+                   .callback = boat_camera_share_tick});
+
+  // Follows the hull so it has to run after boat movement
+  ecs_system(ecs, {.entity = ecs_entity(
+                       ecs, {.name = "boat_camera_update_tick",
+                             .add = {ecs_dependson(ths_sim_phase(
+                                 ecs, THS_SIM_POST_UPDATE))}}),
+                   .query.filter.terms =
+                       {
+                           {.id = ecs_id(TbTransformComponent)},
+                           {.id = ecs_id(ThsBoatCameraComponent)},
+                           {.id = ecs_id(TbTransformComponent),
+                            .inout = EcsIn,
+                            .src.flags = EcsUp | EcsCascade,
+                            .src.trav = EcsChildOf},
+                           {.id = ecs_id(ThsBoatCameraTuningComponent),
+                            .inout = EcsIn,
+                            .src.flags = EcsUp,
+                            .src.trav = EcsIsA},
+                       },
+                   .callback = boat_camera_update_tick});
 }
 
 void ths_unregister_boat_camera_sys(TbWorld *world) {
@@ -0,0 +1,184 @@
+#include "boatlod.h"
+
+#include "profiler.h"
+#include "profiling.h"
+#include "simulation.h"
+#include "tbcommon.h"
+#include "transformcomponent.h"
+#include "world.h"
+
+#include "boatcameracomponent.h"
+#include "boatmovementcomponent.h"
+
+#include <SDL3/SDL_stdinc.h>
+
+ECS_COMPONENT_DECLARE(ThsBoatLod);
+ECS_COMPONENT_DECLARE(ThsBoatLodSystem);
+
+static ThsProfileTrack lod_track = 0;
+
+// Waits for the first update like the camera query does
+static void init_queries(ThsBoatLodSystem *sys, ecs_world_t *ecs) {
+  if (sys->hull_query) {
+    return;
+  }
+  sys->hull_query =
+      ecs_query(ecs, {.filter.terms =
+                          {
+                              {.id = ecs_id(ThsBoatLod)},
+                              {.id = ecs_id(ThsBoatMovementComponent),
+                               .inout = EcsIn},
+                              {.id = ecs_id(TbTransformComponent),
+                               .inout = EcsIn,
+                               .src.flags = EcsUp,
+                               .src.trav = EcsChildOf},
+                          }});
+}
+
+static ThsBoatLodTier pick_tier(const ThsBoatLodSystem *sys, float dist_sq) {
+  for (uint32_t t = 0; t < THS_BOAT_LOD_FAR; ++t) {
+    const float max_dist = sys->tiers[t].max_distance;
+    if (dist_sq <= max_dist * max_dist) {
+      return (ThsBoatLodTier)t;
+    }
+  }
+  return THS_BOAT_LOD_FAR;
+}
+
+void ths_update_boat_lod(ecs_world_t *ecs) {
+  TracyCZoneNC(ctx, "Boat LOD Update", TracyCategoryColorGame, true);
+  ThsProfileScope prof = ths_profile_begin(lod_track);
+
+  tb_auto *sys = ecs_singleton_get_mut(ecs, ThsBoatLodSystem);
+  init_queries(sys, ecs);
+  const uint64_t step = ecs_singleton_get(ecs, ThsSimClock)->step_count;
+
+  // Without a camera distances are measured from the origin
+  ThsActiveBoatCamera camera = {0};
+  ths_find_active_boat_camera(ecs, &sys->camera_query, &camera);
+  sys->focus = camera.position;
+  const ecs_entity_t player_hull = camera.hull;
+
+  ThsBoatLodCounters counters = {0};
+  ecs_iter_t it = ecs_query_iter(ecs, sys->hull_query);
+  while (ecs_iter_next(&it)) {
+    tb_auto *lods = ecs_field(&it, ThsBoatLod, 1);
+    const tb_auto *hulls = ecs_field(&it, ThsBoatMovementComponent, 2);
+    // Hulls in a table share a boat so the distance is the same for all
+    const tb_auto *boat_transform = ecs_field(&it, TbTransformComponent, 3);
+    const float3 offset = boat_transform->transform.position - sys->focus;
+    const ThsBoatLodTier tier = pick_tier(sys, tb_magsqf3(offset));
+    const ThsBoatLodTierDesc *desc = &sys->tiers[tier];
+
+    for (int32_t i = 0; i < it.count; ++i) {
+      tb_auto *lod = &lods[i];
+      const tb_auto *hull = &hulls[i];
+      lod->tier = tier;
+      lod->sample_count = desc->sample_count;
+      lod->interval = desc->interval;
+      lod->player = it.entities[i] == player_hull;
+
+      // Speed and turn rate only change while the hull ticks, so an AI ship
+      // that fell asleep under throttle, e.g. stalled head to wind, also
+      // counts so that it keeps trying when the wind shifts
+      const bool steering = hull->speed != 0.0f ||
+                            hull->heading_change_speed != 0.0f ||
+                            (hull->autopilot && hull->throttle > 0.0f);
+      if (lod->asleep) {
+        lod->asleep = !lod->player && !steering && tier != THS_BOAT_LOD_NEAR;
+      } else {
+        lod->asleep = !lod->player && !steering &&
+                      tier != THS_BOAT_LOD_NEAR &&
+                      lod->still_steps >= THS_BOAT_LOD_SLEEP_STEPS;
+      }
+      if (lod->asleep) {
+        lod->due = false;
+        counters.asleep++;
+        continue;
+      }
+
+      lod->due = ((step + lod->phase) & (desc->interval - 1)) == 0;
+      counters.tiers[tier]++;
+      counters.ticked += lod->due ? 1 : 0;
+    }
+  }
+  sys->counters = counters;
+
+  TracyCPlot("Boat LOD Near", (double)counters.tiers[THS_BOAT_LOD_NEAR]);
+  TracyCPlot("Boat LOD Mid", (double)counters.tiers[THS_BOAT_LOD_MID]);
+  TracyCPlot("Boat LOD Far", (double)counters.tiers[THS_BOAT_LOD_FAR]);
+  TracyCPlot("Boat LOD Asleep", (double)counters.asleep);
+  TracyCPlot("Boat LOD Ticked", (double)counters.ticked);
+
+  ths_profile_end(prof);
+  TracyCZoneEnd(ctx);
+}
+
+ThsBoatLodCounters ths_boat_lod_counters(ecs_world_t *ecs) {
+  const tb_auto *sys = ecs_singleton_get(ecs, ThsBoatLodSystem);
+  return sys ? sys->counters : (ThsBoatLodCounters){0};
+}
+
+void boat_lod_on_set(ecs_iter_t *it) {
+  ecs_world_t *ecs = it->world;
+  for (int32_t i = 0; i < it->count; ++i) {
+    const ecs_entity_t ent = it->entities[i];
+    if (ecs_has(ecs, ent, ThsBoatLod)) {
+      continue;
+    }
+    // Spread hulls evenly over the reduced rate ticks
+    uint32_t phase = (uint32_t)ent * 0x9E3779B1u;
+    ThsBoatLod lod = {
+        .phase = phase ^ (phase >> 16),
+        .sample_count = 6,
+        .interval = 1,
+        .due = true,
+    };
+    ecs_set_ptr(ecs, ent, ThsBoatLod, &lod);
+  }
+}
+
+void ths_register_boat_lod_sys(TbWorld *world) {
+  ecs_world_t *ecs = world->ecs;
+  ECS_COMPONENT_DEFINE(ecs, ThsBoatLod);
+  ECS_COMPONENT_DEFINE(ecs, ThsBoatLodSystem);
+
+  lod_track = ths_profiler_track("Boat LOD Update");
+
+  ThsBoatLodSystem sys = {
+      .tiers =
+          {
+              [THS_BOAT_LOD_NEAR] = {.max_distance = 150.0f,
+                                     .interval = 1,
+                                     .sample_count = 6},
+              [THS_BOAT_LOD_MID] = {.max_distance = 600.0f,
+                                    .interval = 2,
+                                    .sample_count = 3},
+              [THS_BOAT_LOD_FAR] = {.max_distance = SDL_FLT_MAX,
+                                    .interval = 8,
+                                    .sample_count = 1},
+          },
+  };
+  ecs_singleton_set_ptr(ecs, ThsBoatLodSystem, &sys);
+
+  ecs_observer(ecs, {.filter.terms =
+                         {
+                             {.id = ecs_id(ThsBoatMovementComponent)},
+                         },
+                     .events = {EcsOnSet},
+                     .callback = boat_lod_on_set});
+}
+
+void ths_unregister_boat_lod_sys(TbWorld *world) {
+  ecs_world_t *ecs = world->ecs;
+  tb_auto *sys = ecs_singleton_get_mut(ecs, ThsBoatLodSystem);
+  if (sys->hull_query) {
+    ecs_query_fini(sys->hull_query);
+  }
+  if (sys->camera_query) {
+    ecs_query_fini(sys->camera_query);
+  }
+  ecs_singleton_remove(ecs, ThsBoatLodSystem);
+}
+
+TB_REGISTER_SYS(ths, boat_lod, TB_SYSTEM_NORMAL)
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "simd.h"
+
+#include <flecs.h>
+
+// Simulation level of detail for boats
+//
+// Every step each hull is placed in a tier by its boat's distance to the
+// active boat camera. Nearer tiers tick every step with every ocean sample.
+// Farther tiers tick less often with fewer samples; ticks are staggered so
+// only a slice of the far boats is updated on any one step and the buoyancy
+// simulation carries the rest along in between. Boats that aren't player
+// controlled and have come to rest outside the near tier sleep until the
+// player steers them, a save moves them or something bumps into them
+
+typedef enum ThsBoatLodTier {
+  THS_BOAT_LOD_NEAR,
+  THS_BOAT_LOD_MID,
+  THS_BOAT_LOD_FAR,
+  THS_BOAT_LOD_TIER_COUNT,
+} ThsBoatLodTier;
+
+// Steps a hull has to be at rest before it may sleep
+#define THS_BOAT_LOD_SLEEP_STEPS 60
+// Horizontal speed in m/s under which a hull counts as at rest. Waves keep
+// hulls bobbing so vertical motion is ignored
+#define THS_BOAT_LOD_REST_SPEED 0.25f
+
+typedef struct ThsBoatLod {
+  ThsBoatLodTier tier;
+  uint32_t phase;        // Staggers reduced rate ticks between hulls
+  uint32_t sample_count; // Ocean samples to take when ticking
+  uint32_t interval;     // Steps between ticks
+  uint32_t still_steps;  // Consecutive steps spent at rest
+  bool due;              // Whether the hull ticks this step
+  bool player;           // Followed by the active camera
+  bool asleep;
+} ThsBoatLod;
+extern ECS_COMPONENT_DECLARE(ThsBoatLod);
+
+typedef struct ThsBoatLodTierDesc {
+  float max_distance;    // Boats beyond this fall into the next tier
+  uint32_t interval;     // Tick every this many steps; a power of two
+  uint32_t sample_count; // 1, 3 or 6
+} ThsBoatLodTierDesc;
+
+// Hulls counted on the most recent step
+typedef struct ThsBoatLodCounters {
+  uint32_t tiers[THS_BOAT_LOD_TIER_COUNT]; // Awake hulls per tier
+  uint32_t asleep;
+  uint32_t ticked; // Hulls whose tick ran
+} ThsBoatLodCounters;
+
+typedef struct ThsBoatLodSystem {
+  ThsBoatLodTierDesc tiers[THS_BOAT_LOD_TIER_COUNT];
+  ThsBoatLodCounters counters;
+  float3 focus; // Where the active camera was
+  ecs_query_t *hull_query;
+  ecs_query_t *camera_query;
+} ThsBoatLodSystem;
+extern ECS_COMPONENT_DECLARE(ThsBoatLodSystem);
+
+// Assigns tiers and decides which hulls tick this step. Runs on the main
+// thread before the boat movement tick
+void ths_update_boat_lod(ecs_world_t *ecs);
+
+ThsBoatLodCounters ths_boat_lod_counters(ecs_world_t *ecs);
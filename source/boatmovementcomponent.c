@@ -1,8 +1,11 @@
 #include "boatmovementcomponent.h"
 
+#include "classprefab.h"
+#include "cookedcomponents.h"
 #include "world.h"
 #include <json.h>
 
+ECS_COMPONENT_DECLARE(ThsBoatTuningComponent);
 ECS_COMPONENT_DECLARE(ThsBoatMovementComponent);
 
 typedef struct ThsBoatMovementDescriptor {
@@ -11,39 +14,103 @@ typedef struct ThsBoatMovementDescriptor {
   float max_speed;
   float inertia;
   float friction;
+  float half_width;
+  float half_length;
+  float half_height;
+  float density;
 } ThsBoatMovementDescriptor;
 ECS_COMPONENT_DECLARE(ThsBoatMovementDescriptor);
 
-bool ths_load_boat_movement_comp(TbWorld *world, ecs_entity_t ent,
-                                 const char *source_path,
-                                 const cgltf_node *node, json_object *json) {
-  (void)node;
-  (void)source_path;
-  ThsBoatMovementComponent comp = {0};
+static void parse_boat_movement_desc(json_object *json,
+                                     ThsBoatMovementDescriptor *desc) {
   json_object_object_foreach(json, key, value) {
     if (SDL_strcmp(key, "heading_change_speed") == 0) {
-      comp.heading_change_speed = (float)json_object_get_double(value);
+      desc->heading_change_speed = (float)json_object_get_double(value);
     } else if (SDL_strcmp(key, "acceleration") == 0) {
-      comp.acceleration = (float)json_object_get_double(value);
+      desc->acceleration = (float)json_object_get_double(value);
     } else if (SDL_strcmp(key, "max_speed") == 0) {
-      comp.max_speed = (float)json_object_get_double(value);
+      desc->max_speed = (float)json_object_get_double(value);
     } else if (SDL_strcmp(key, "inertia") == 0) {
-      comp.inertia = (float)json_object_get_double(value);
+      desc->inertia = (float)json_object_get_double(value);
     } else if (SDL_strcmp(key, "friction") == 0) {
-      comp.friction = (float)json_object_get_double(value);
+      desc->friction = (float)json_object_get_double(value);
+    } else if (SDL_strcmp(key, "half_width") == 0) {
+      desc->half_width = (float)json_object_get_double(value);
+    } else if (SDL_strcmp(key, "half_length") == 0) {
+      desc->half_length = (float)json_object_get_double(value);
+    } else if (SDL_strcmp(key, "half_height") == 0) {
+      desc->half_height = (float)json_object_get_double(value);
+    } else if (SDL_strcmp(key, "density") == 0) {
+      desc->density = (float)json_object_get_double(value);
     }
   }
+}
+
+ecs_entity_t ths_boat_class_prefab(ecs_world_t *ecs,
+                                   const ThsBoatTuningComponent *tuning) {
+  return ths_class_prefab(ecs, "BoatClass", ecs_id(ThsBoatTuningComponent),
+                          sizeof(*tuning), tuning);
+}
+
+bool ths_load_boat_movement_comp(TbWorld *world, ecs_entity_t ent,
+                                 const char *source_path,
+                                 const cgltf_node *node, json_object *json) {
+  // Scenes cooked with COOK_ASSETS carry this already packed
+  ThsBoatMovementDescriptor desc = {0};
+  const ThsBoatMovementDescriptor *cooked =
+      ths_find_cooked_component(world, source_path, node,
+                                "ThsBoatMovementDescriptor", sizeof(desc));
+  if (cooked) {
+    desc = *cooked;
+  } else {
+    parse_boat_movement_desc(json, &desc);
+  }
+
+  // Scenes authored before hulls floated don't carry a hull size
+  if (desc.half_width <= 0.0f) {
+    desc.half_width = 1.0f;
+  }
+  if (desc.half_length <= 0.0f) {
+    desc.half_length = 1.0f;
+  }
+  if (desc.half_height <= 0.0f) {
+    desc.half_height = 0.5f;
+  }
+  if (desc.density <= 0.0f) {
+    desc.density = 500.0f; // Floats about half way up the hull
+  }
+
+  ThsBoatTuningComponent tuning = {
+      .max_acceleration = desc.acceleration,
+      .max_speed = desc.max_speed,
+      .inertia = desc.inertia,
+      .friction = desc.friction,
+      .half_width = desc.half_width,
+      .half_length = desc.half_length,
+      .half_height = desc.half_height,
+      .density = desc.density,
+  };
+  // The class has to be there before the hull is set since the hull body is
+  // sized from it
+  ecs_add_pair(world->ecs, ent, EcsIsA,
+               ths_boat_class_prefab(world->ecs, &tuning));
+
+  ThsBoatMovementComponent comp = {
+      .heading_change_speed = desc.heading_change_speed,
+  };
   ecs_set_ptr(world->ecs, ent, ThsBoatMovementComponent, &comp);
   return true;
 }
 
 void ths_destroy_boat_movement_comp(TbWorld *world, ecs_entity_t ent) {
   ecs_remove(world->ecs, ent, ThsBoatMovementComponent);
+  ths_remove_class_prefab(world->ecs, ent, ecs_id(ThsBoatTuningComponent));
 }
 
 ecs_entity_t ths_register_boat_movement_comp(TbWorld *world) {
   ecs_world_t *ecs = world->ecs;
   ECS_COMPONENT_DEFINE(ecs, ThsBoatMovementDescriptor);
+  ECS_COMPONENT_DEFINE(ecs, ThsBoatTuningComponent);
   ECS_COMPONENT_DEFINE(ecs, ThsBoatMovementComponent);
 
   ecs_struct(
@@ -54,9 +121,13 @@ ecs_entity_t ths_register_boat_movement_comp(TbWorld *world) {
               {
                   {.name = "heading_change_speed", .type = ecs_id(ecs_f32_t)},
                   {.name = "acceleration", .type = ecs_id(ecs_f32_t)},
-                  {.name = "max_delta", .type = ecs_id(ecs_f32_t)},
+                  {.name = "max_speed", .type = ecs_id(ecs_f32_t)},
                   {.name = "inertia", .type = ecs_id(ecs_f32_t)},
                   {.name = "friction", .type = ecs_id(ecs_f32_t)},
+                  {.name = "half_width", .type = ecs_id(ecs_f32_t)},
+                  {.name = "half_length", .type = ecs_id(ecs_f32_t)},
+                  {.name = "half_height", .type = ecs_id(ecs_f32_t)},
+                  {.name = "density", .type = ecs_id(ecs_f32_t)},
               },
       });
 
@@ -4,20 +4,40 @@
 
 #include <flecs.h>
 
-// State for managing movement of the boat
-// Both the speed and heading of the ship as well as how it rotates and bobs on
-// the waves
-typedef struct ThsBoatMovementComponent {
-  float heading_change_speed; // How fast the boat will face the target heading
+// How a class of boat handles and floats. Shared by every hull of the class
+// through a prefab (see classprefab.h) and never written while simulating
+typedef struct ThsBoatTuningComponent {
   float max_acceleration;
   float max_speed;
   float inertia;  // The magnitude of velocity required to start moving
   float friction; // How fast the boat will come to a stop
 
-  float target_height_offset; // Target height offset to move to
-  float3 target_heading;      // Direction we want the boat to face
+  // Box the hull is simulated as when floating on the ocean
+  float half_width;
+  float half_length;
+  float half_height;
+  float density; // kg/m^3; water is 1000
+} ThsBoatTuningComponent;
+extern ECS_COMPONENT_DECLARE(ThsBoatTuningComponent);
+
+// State for managing movement of the boat
+// Both the speed and heading of the ship as well as how it turns. Kept to
+// what changes every step so the movement tick touches as little as
+// possible per hull
+typedef struct ThsBoatMovementComponent {
+  float2 target_heading;      // XZ direction we want the boat to face
+  float heading_change_speed; // How fast the boat is turning to face it
   // Current heading is the attached transform component's forward
   float acceleration;
   float speed;
+  float throttle;             // 0 to 1
+  float target_height_offset; // Target height offset to move to
+  // Set by whatever steers the boat in place of player input, which then
+  // turns towards target_heading at this throttle
+  bool autopilot;
 } ThsBoatMovementComponent;
 extern ECS_COMPONENT_DECLARE(ThsBoatMovementComponent);
+
+// Prefab for hulls tuned like this, created the first time it's asked for
+ecs_entity_t ths_boat_class_prefab(ecs_world_t *ecs,
+                                   const ThsBoatTuningComponent *tuning);
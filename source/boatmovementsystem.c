@@ -1,12 +1,22 @@
 #include "boatmovementsystem.h"
 
+#include "boatlod.h"
+#include "buoyancy.h"
+#include "framememory.h"
 #include "inputsystem.h"
 #include "meshcomponent.h"
+#include "oceancache.h"
 #include "oceancomponent.h"
+#include "oceansampling.h"
+#include "profiler.h"
 #include "profiling.h"
+#include "simulation.h"
+#include "spatialhash.h"
 #include "tbcommon.h"
 #include "transformcomponent.h"
-#include "visualloggingsystem.h"
+#include "transformwrites.h"
+#include "vlog.h"
+#include "wind.h"
 #include "world.h"
 
 #include <SDL3/SDL_log.h>
@@ -15,70 +25,238 @@
 
 #include "boatmovementcomponent.h"
 
+// The rigid body a hull floats as and what the tick decided it should do
+typedef struct ThsHullBody {
+  uint32_t body;
+  ThsHullInput input;
+  // Boat transform as of the last step. Anything else moving the boat, like
+  // loading a save, teleports the body to match
+  TbTransform synced;
+  bool sleeping; // Body was deactivated because its boat is asleep
+} ThsHullBody;
+ECS_COMPONENT_DECLARE(ThsHullBody);
+
 typedef struct ThsBoatMovementSystem {
-  ecs_query_t *ocean_query;
+  // Resolved once per frame before the parallel tick
+  const ThsOceanCache *cache;
+
+  ThsBuoyancyWorld *buoyancy;
+  ecs_query_t *body_query;
+  TB_DYN_ARR_OF(ThsHullInput) inputs;
+  // Matches inputs; components don't move during the merge
+  TB_DYN_ARR_OF(ThsHullBody *) bodies;
+  TB_DYN_ARR_OF(ThsBoatLod *) lods;
+  TB_DYN_ARR_OF(ecs_entity_t) boats;
+  // Each boat's transform as the body query saw it; writes are buffered
+  TB_DYN_ARR_OF(const TbTransform *) poses;
 } ThsBoatMovementSystem;
 ECS_COMPONENT_DECLARE(ThsBoatMovementSystem);
 
+static ThsProfileTrack prepare_track = 0;
+static ThsProfileTrack tick_track = 0;
+static ThsProfileTrack merge_track = 0;
+static ThsProfileTrack buoyancy_track = 0;
+
+// What boats the player isn't steering see
+static const TbInputSystem idle_controls = {0};
+
+// Turns towards the target heading as hard as the hull allows once it is
+// this far off, in radians
+#define AUTOPILOT_FULL_TURN 0.5f
+
+// Stands in for the turn stick and throttle of a boat steering itself
+static void read_autopilot(const ThsBoatMovementComponent *hull,
+                           float3 forward, float *turn, float *throttle) {
+  const float3 target =
+      tb_normf3((float3){hull->target_heading.x, 0.0f, hull->target_heading.y});
+  // Positive turns are counter clockwise about up, like the A key
+  const float cross_y = forward.z * target.x - forward.x * target.z;
+  const float angle = SDL_atan2f(cross_y, tb_dotf3(forward, target));
+  *turn = tb_clampf(angle / AUTOPILOT_FULL_TURN, -1.0f, 1.0f);
+  *throttle = tb_clampf(hull->throttle, 0.0f, 1.0f);
+}
+
+// Boats with sails set in this much wind accelerate at their full rate.
+// Stronger wind drives them harder, up to a point
+#define SAIL_REFERENCE_WIND 8.0f
+#define SAIL_MAX_WIND_FACTOR 1.5f
+// Fastest a hull can sail as a multiple of the wind speed, on its best point
+// of sail. Never more than the hull's own max speed
+#define SAIL_SPEED_RATIO 1.5f
+// m/s^2 a hull slows by with its sails down or over its sail speed
+#define COAST_DRAG 6.0f
+
+// Fraction of the wind a sail turns into drive given the cosine of the angle
+// between the heading and where the wind blows to. Running before the wind
+// is good, a beam reach is best and nothing sails straight into the wind
+static float sail_efficiency(float cos_angle) {
+  static const float cosines[] = {-1.0f, -0.8f, -0.5f, 0.0f, 1.0f};
+  static const float efficiency[] = {0.0f, 0.0f, 0.5f, 1.0f, 0.7f};
+  for (uint32_t i = 1; i < SDL_arraysize(cosines); ++i) {
+    if (cos_angle <= cosines[i]) {
+      const float t =
+          (cos_angle - cosines[i - 1]) / (cosines[i] - cosines[i - 1]);
+      return efficiency[i - 1] + (efficiency[i] - efficiency[i - 1]) * t;
+    }
+  }
+  return efficiency[SDL_arraysize(efficiency) - 1];
+}
+
+// Gap in meters hulls try to keep between their bounding circles
+#define SEPARATION_MARGIN 4.0f
+// Speed away from a neighbour once the gap has closed; more when overlapping
+#define SEPARATION_SPEED 3.0f
+#define SEPARATION_MAX_SPEED 8.0f
+// A crowd beyond this many neighbours is already pushing hard enough
+#define SEPARATION_MAX_NEIGHBOURS 16
+
+// How fast a hull should move to get clear of the hulls around it. The push
+// from each neighbour grows from nothing at the margin and keeps growing
+// while the hulls overlap, so hulls are shoved apart before the physics has
+// to resolve them as a hard contact
+static float3 separate_hull(const ThsSpatialHash *hash, ecs_entity_t boat,
+                            float3 pos, float radius) {
+  const float2 center = {pos.x, pos.z};
+  const float reach = radius + hash->max_radius + SEPARATION_MARGIN;
+  // Hulls of the same boat move together so they aren't neighbours. In a
+  // crowd the closest neighbours are the ones that matter
+  uint32_t hits[SEPARATION_MAX_NEIGHBOURS] = {0};
+  const uint32_t hit_count = ths_spatial_hash_query_closest(
+      hash, center, reach, boat, hits, SEPARATION_MAX_NEIGHBOURS);
+
+  float2 push = {0};
+  for (uint32_t h = 0; h < hit_count; ++h) {
+    const tb_auto *other = &hash->entries[hits[h]];
+    const float2 away = center - other->pos;
+    const float dist = SDL_sqrtf(away.x * away.x + away.y * away.y);
+    const float gap = dist - (radius + other->radius);
+    if (gap >= SEPARATION_MARGIN) {
+      continue;
+    }
+    // Boats stacked on one spot split along X by entity so both don't pick
+    // the same way out
+    float2 dir = {boat < other->boat ? 1.0f : -1.0f, 0.0f};
+    if (dist > 0.001f) {
+      dir = away / dist;
+    }
+    const float weight = (SEPARATION_MARGIN - gap) / SEPARATION_MARGIN;
+    push += dir * (weight * SEPARATION_SPEED);
+  }
+
+  const float speed = SDL_sqrtf(push.x * push.x + push.y * push.y);
+  if (speed > SEPARATION_MAX_SPEED) {
+    push *= SEPARATION_MAX_SPEED / speed;
+  }
+  return (float3){push.x, 0.0f, push.y};
+}
+
+// Runs single threaded before the parallel tick so that workers only ever
+// read shared state
+void boat_movement_prepare_tick(ecs_iter_t *it) {
+  TracyCZoneN(ctx, "Boat Movement Prepare", true);
+  TracyCZoneColor(ctx, TracyCategoryColorGame);
+  ThsProfileScope prof = ths_profile_begin(prepare_track);
+
+  ecs_world_t *ecs = it->world;
+  tb_auto *sys = ecs_singleton_get_mut(ecs, ThsBoatMovementSystem);
+
+  // The ocean cache tracks the ocean entity for us
+  sys->cache = ecs_singleton_get(ecs, ThsOceanCache);
+
+  // Decides which hulls the parallel tick skips this step
+  ths_update_boat_lod(ecs);
+
+  ths_prepare_transform_writes(ecs);
+
+  ths_profile_end(prof);
+  TracyCZoneEnd(ctx);
+}
+
+// Runs on flecs worker threads. Each invocation only writes to the hull
+// components it was handed and to its stage's vlog ring. Nothing is
+// moved here; the tick decides what each hull wants and the merge hands that
+// to the buoyancy simulation
 void boat_movement_update_tick(ecs_iter_t *it) {
   TracyCZoneN(ctx, "Boat Movement System Tick", true);
   TracyCZoneColor(ctx, TracyCategoryColorGame);
+  ThsProfileScope prof = ths_profile_begin(tick_track);
 
   ecs_world_t *ecs = it->world;
 
   const tb_auto *sys = ecs_singleton_get(ecs, ThsBoatMovementSystem);
-  tb_auto *vlog = ecs_singleton_get_mut(ecs, TbVisualLoggingSystem);
   const tb_auto *input = ecs_singleton_get(ecs, TbInputSystem);
 
-  ecs_singleton_modified(ecs, TbVisualLoggingSystem);
+  const tb_auto *cache = sys->cache;
+  TB_CHECK(cache && cache->ocean_ent, "Boats expect exactly one ocean");
 
-  // Find oceans
-  // For now we assume only one
-  TbOceanComponent *ocean = NULL;
-  ecs_entity_t ocean_ent = 0;
-  {
-    ecs_iter_t ocean_it = ecs_query_iter(ecs, sys->ocean_query);
-    int32_t ocean_count = 0;
-    while (ecs_iter_next(&ocean_it)) {
-
-      if (ocean_count == 0 && ocean_it.count == 1) {
-        ocean = ecs_field(&ocean_it, TbOceanComponent, 1);
-        ocean_ent = ocean_it.entities[0];
-      }
+  tb_auto *transforms = ecs_field(it, TbTransformComponent, 1);
+  tb_auto *hulls = ecs_field(it, ThsBoatMovementComponent, 2);
+  // Every hull in a table shares a parent, so the boat comes with the table
+  // rather than being looked up per hull
+  const tb_auto *boat_transform = ecs_field(it, TbTransformComponent, 3);
+  const ecs_entity_t boat = ecs_field_src(it, 3);
+  tb_auto *bodies = ecs_field(it, ThsHullBody, 4);
+  const tb_auto *lods = ecs_field(it, ThsBoatLod, 5);
+  // Hulls in a table are also of one class, so the tuning is read once
+  const tb_auto *tuning = ecs_field(it, ThsBoatTuningComponent, 6);
+  // Rebuilt at the start of the step and only read from here on
+  const tb_auto *spatial_hash = ecs_singleton_get(ecs, ThsSpatialHash);
+  const tb_auto *wind_field = ecs_singleton_get(ecs, ThsWindField);
+
+  // Take six samples
+  // One at the port, two at the stern
+  // one port, one starboard
+  // one in the middle forward
+  //    *    |
+  //   / \   |
+  //  /   \  |
+  //  * * *  |
+  //  |   |  |
+  //  |   |  |
+  //  *___*  |
+  //         |
 
-      ocean_count += ocean_it.count;
-    }
-    TB_CHECK(ocean_count == 1, "Not expecting more than one ocean");
+#define SAMPLE_COUNT 6
+  // Farther tiers only take the three corners or just the center
+  static const uint32_t three_samples[] = {1, 4, 5};
+  static const uint32_t one_sample[] = {0};
+
+  // Hulls only tick when their LOD says so and take as many samples as
+  // their tier allows, so each hull's first sample is found up front
+  TbAllocator scratch = ths_scratch_alloc(ecs);
+  uint32_t *first_sample = tb_alloc_nm_tp(scratch, it->count, uint32_t);
+  uint32_t sample_count = 0;
+  for (int32_t i = 0; i < it->count; ++i) {
+    first_sample[i] = sample_count;
+    sample_count += lods[i].due ? lods[i].sample_count : 0;
+  }
+  if (sample_count == 0) {
+    ths_profile_end(prof);
+    TracyCZoneEnd(ctx);
+    return;
   }
 
-  tb_auto *transforms = ecs_field(it, TbTransformComponent, 1);
-  tb_auto *hulls = ecs_field(it, ThsBoatMovementComponent, 2);
+  // Gather the sample points of every hull in this table so that the ocean
+  // can be looked up for all of them in one batch. The table only lives for
+  // this call so it comes from the stage's scratch arena
+  ThsOceanSampleBatch stage_batch = {0};
+  tb_auto *batch = &stage_batch;
+  {
+    bool ok = ths_create_ocean_batch(scratch, sample_count, batch);
+    TB_CHECK(ok, "Failed to allocate ocean sample batch");
+  }
 
   for (int32_t i = 0; i < it->count; ++i) {
     tb_auto *transform = &transforms[i];
-    tb_auto *hull = &hulls[i];
-
-    tb_auto boat = ecs_get_parent(ecs, it->entities[i]);
-    tb_auto boat_transform = ecs_get_mut(ecs, boat, TbTransformComponent);
+    const tb_auto *lod = &lods[i];
+    if (!lod->due) {
+      continue;
+    }
 
     float3 hull_pos = boat_transform->transform.position;
 
-    // Take six samples
-    // One at the port, two at the stern
-    // one port, one starboard
-    // one in the middle forward
-    //    *    |
-    //   / \   |
-    //  /   \  |
-    //  * * *  |
-    //  |   |  |
-    //  |   |  |
-    //  *___*  |
-    //         |
-
-#define SAMPLE_COUNT 6
-    float half_width = 1.0f; // hull->width * 0.5f;
-    float half_depth = 1.0f; // hull->depth * 0.5f;
+    float half_width = tuning->half_width;
+    float half_depth = tuning->half_length;
 
     TbQuaternion boat_rot = boat_transform->transform.rotation;
     float3 forward =
@@ -94,51 +272,86 @@ void boat_movement_update_tick(ecs_iter_t *it) {
         hull_pos - (right * half_width) - (forward * half_depth), // left stern
         hull_pos + (right * half_width) - (forward * half_depth), // right stern
     };
-    TbOceanSample average_sample = {.pos = {0}};
-    for (uint32_t i = 0; i < SAMPLE_COUNT; ++i) {
-      const float3 point = sample_points[i];
-      tb_vlog_location(vlog, tb_f3(point.x, 10.0f, point.z), 0.4f,
-                       tb_normf3(tb_f3(point.x, 0, point.z)));
-
-      TbOceanSample sample = tb_sample_ocean(ocean, ecs, ocean_ent, point.xz);
-      average_sample.pos += sample.pos;
-      average_sample.tangent += sample.tangent;
-      average_sample.binormal += sample.binormal;
-    }
-    average_sample.pos /= SAMPLE_COUNT;
-    average_sample.tangent /= SAMPLE_COUNT;
-    average_sample.tangent = tb_normf3(average_sample.tangent);
-    average_sample.binormal /= SAMPLE_COUNT;
-    average_sample.binormal = tb_normf3(average_sample.binormal);
-
-    transform->transform.position[1] =
-        tb_lerpf(average_sample.pos[1], transform->transform.position[1],
-                 tb_clampf(it->delta_time, 0.0f, 1.0f));
+    for (uint32_t s = 0; s < lod->sample_count; ++s) {
+      uint32_t point_idx = s;
+      if (lod->sample_count == 3) {
+        point_idx = three_samples[s];
+      } else if (lod->sample_count == 1) {
+        point_idx = one_sample[s];
+      }
+      const float3 point = sample_points[point_idx];
+      THS_VLOG_LOCATION(ecs, THS_VLOG_BUOYANCY, tb_f3(point.x, 10.0f, point.z),
+                        0.4f, tb_normf3(tb_f3(point.x, 0, point.z)));
+
+      const uint32_t idx = first_sample[i] + s;
+      batch->x[idx] = point.x;
+      batch->z[idx] = point.z;
+    }
+  }
 
+  ths_ocean_cache_sample_batch(cache, ecs, batch);
+
+  // Every hull of a class is the same size
+  const float radius = SDL_sqrtf(tuning->half_width * tuning->half_width +
+                                 tuning->half_length * tuning->half_length);
+
+  for (int32_t i = 0; i < it->count; ++i) {
+    tb_auto *hull = &hulls[i];
+    tb_auto *hull_input = &bodies[i].input;
+    const tb_auto *lod = &lods[i];
+    const TbTransform *boat_trans = &boat_transform->transform;
+    if (!lod->due) {
+      continue;
+    }
+    // Only the boat the camera follows is steered by the player
+    const TbInputSystem *controls = lod->player ? input : &idle_controls;
+    // Hulls on a reduced rate catch up on every step since their last tick
+    const float tick_time = it->delta_time * (float)lod->interval;
+
+    // Project forward onto the XZ plane to get the forward we want to use
+    // for movement
+    float3 mov_forward = tb_transform_get_forward(boat_trans);
+    mov_forward = tb_normf3((float3){mov_forward.x, 0.0f, mov_forward.z});
+
+    const bool autopilot = !lod->player && hull->autopilot;
+    float autopilot_turn = 0.0f;
+    float autopilot_throttle = 0.0f;
+    if (autopilot) {
+      read_autopilot(hull, mov_forward, &autopilot_turn, &autopilot_throttle);
+    }
+
+    // The hull floats on the plane through the average of its samples
+    TbOceanSample average_sample = ths_average_ocean_batch(
+        batch, first_sample[i], lod->sample_count);
     float3 normal =
         tb_normf3(tb_crossf3(average_sample.tangent, average_sample.binormal));
-    TbQuaternion rot =
-        tb_look_at_quat((float3){0}, average_sample.binormal, normal);
-
-    transform->transform.rotation =
-        tb_slerp(transform->transform.rotation, rot,
-                 tb_clampf(it->delta_time, 0.0f, 1.0f));
-#undef SAMPLE_COUNT
+    hull_input->water_point[0] = average_sample.pos[0];
+    hull_input->water_point[1] = average_sample.pos[1];
+    hull_input->water_point[2] = average_sample.pos[2];
+    hull_input->water_normal[0] = normal.x;
+    hull_input->water_normal[1] = normal.y;
+    hull_input->water_normal[2] = normal.z;
+
+    const float3 separation =
+        separate_hull(spatial_hash, boat, boat_trans->position, radius);
+    hull_input->separation[0] = separation.x;
+    hull_input->separation[1] = separation.y;
+    hull_input->separation[2] = separation.z;
 
     // Modify boat rotation based on input
     {
       float rotation_alpha = 0.0f;
       bool rotating = false;
-      if (input->keyboard.key_A == 1) {
+      if (controls->keyboard.key_A == 1) {
         rotation_alpha = 1.0f;
         rotating = true;
       }
-      if (input->keyboard.key_D == 1) {
+      if (controls->keyboard.key_D == 1) {
         rotation_alpha = -1.0f;
         rotating = true;
       }
-      if (!rotating && input->gamepad_count > 0) {
-        float a = -input->gamepad_states[0].left_stick.x;
+      if (!rotating && controls->gamepad_count > 0) {
+        float a = -controls->gamepad_states[0].left_stick.x;
         float deadzone = 0.15f;
         if (a > -deadzone && a < deadzone) {
           a = 0.0f;
@@ -150,7 +363,13 @@ void boat_movement_update_tick(ecs_iter_t *it) {
       }
 
       const float accel_rate = 0.1f;
-      if (rotating) {
+      if (autopilot) {
+        // Ease the turn rate towards what the heading error asks for so the
+        // boat settles on its heading instead of swinging past it
+        hull->heading_change_speed +=
+            tb_clampf(autopilot_turn - hull->heading_change_speed,
+                      -accel_rate, accel_rate);
+      } else if (rotating) {
         const float accel = accel_rate * rotation_alpha;
         hull->heading_change_speed += accel;
       } else if (hull->heading_change_speed != 0.0f) {
@@ -168,80 +387,372 @@ void boat_movement_update_tick(ecs_iter_t *it) {
             1.0f * SDL_copysignf(1, hull->heading_change_speed);
       }
 
-      boat_transform->transform.rotation =
-          tb_mulq(boat_transform->transform.rotation,
-                  tb_angle_axis_to_quat((float4){
-                      0, 1, 0, hull->heading_change_speed * it->delta_time}));
-      tb_transform_mark_dirty(ecs, boat);
+      hull_input->target_yaw_rate = hull->heading_change_speed;
     }
 
     // Move boat forward based on angle compared to the wind direction
     {
-      // Project forward onto the XZ plane to get the forward we want to use
-      // for movement
-      float3 mov_forward = tb_transform_get_forward(&boat_transform->transform);
-      mov_forward = tb_normf3((float3){mov_forward.x, 0.0f, mov_forward.z});
-
       float movement_axis = 0.0f;
-      if (input->keyboard.key_W > 0) {
+      if (autopilot) {
+        movement_axis = autopilot_throttle;
+      } else if (controls->keyboard.key_W > 0) {
         movement_axis = 1.0f;
-      } else if (input->gamepad_count > 0) {
-        const TbGameControllerState *state = &input->gamepad_states[0];
+      } else if (controls->gamepad_count > 0) {
+        const TbGameControllerState *state = &controls->gamepad_states[0];
         movement_axis = tb_clampf(state->left_trigger, -1.0f, 1.0f);
       }
 
+      const float2 wind = ths_sample_wind(
+          wind_field, (float2){boat_trans->position.x, boat_trans->position.z});
+      const float wind_speed = SDL_sqrtf(wind.x * wind.x + wind.y * wind.y);
+      float efficiency = 0.0f;
+      if (wind_speed > 0.0f) {
+        efficiency = sail_efficiency(
+            (mov_forward.x * wind.x + mov_forward.z * wind.y) / wind_speed);
+      }
+      // As fast as the sails can carry the hull with this much sail set
+      const float sail_speed =
+          SDL_min(wind_speed * efficiency * SAIL_SPEED_RATIO,
+                  tuning->max_speed) *
+          SDL_fabsf(movement_axis);
+
+      const float drag = COAST_DRAG * tick_time;
       if (movement_axis == 0) {
         // Try to apply some drag if there's no input
-        const float speed_threshold = 0.1f;
-        const float drag = 0.1f;
-        if (hull->speed > speed_threshold && hull->speed - drag >= 0.0f) {
-          hull->speed = drag * -SDL_copysignf(1, hull->speed);
-        } else if (hull->speed < SDL_FLT_EPSILON &&
-                   hull->speed > -SDL_FLT_EPSILON) {
+        hull->acceleration = 0.0f;
+        if (SDL_fabsf(hull->speed) > drag) {
+          hull->speed -= drag * SDL_copysignf(1, hull->speed);
+        } else {
           hull->speed = 0.0f;
         }
       } else {
-        hull->speed += 0.1f * movement_axis;
+        const float wind_factor =
+            SDL_min(wind_speed / SAIL_REFERENCE_WIND, SAIL_MAX_WIND_FACTOR);
+        hull->acceleration =
+            tuning->max_acceleration * movement_axis * efficiency * wind_factor;
+        hull->speed += hull->acceleration * tick_time;
       }
 
-      float3 velocity = mov_forward * hull->speed;
+      // Sails can't hold speed the wind doesn't give, e.g. after turning
+      // into it, so the excess bleeds off like drag
+      if (movement_axis != 0 && SDL_fabsf(hull->speed) > sail_speed) {
+        const float slowed = SDL_max(SDL_fabsf(hull->speed) - drag, sail_speed);
+        hull->speed = SDL_copysignf(slowed, hull->speed);
+      }
+
+      hull_input->forward[0] = mov_forward.x;
+      hull_input->forward[1] = mov_forward.y;
+      hull_input->forward[2] = mov_forward.z;
+      hull_input->target_speed = hull->speed;
+    }
+  }
+#undef SAMPLE_COUNT
+
+  ths_profile_end(prof);
+  TracyCZoneEnd(ctx);
+}
 
-      // TEMP
-      hull->max_speed = 25.0f;
-      float speed_sq = hull->max_speed * hull->max_speed;
-      if (tb_magsqf3(velocity) > speed_sq) {
-        hull->speed = hull->max_speed;
-        velocity = tb_normf3(velocity) * hull->max_speed;
+// Steps every hull body with what the tick decided and writes the resulting
+// poses back to the boats
+static void step_buoyancy(ecs_world_t *ecs, ThsBoatMovementSystem *sys,
+                          float delta_time) {
+  ThsProfileScope prof = ths_profile_begin(buoyancy_track);
+
+  TB_DYN_ARR_CLEAR(sys->inputs);
+  TB_DYN_ARR_CLEAR(sys->bodies);
+  TB_DYN_ARR_CLEAR(sys->lods);
+  TB_DYN_ARR_CLEAR(sys->boats);
+  TB_DYN_ARR_CLEAR(sys->poses);
+
+  ecs_iter_t it = ecs_query_iter(ecs, sys->body_query);
+  while (ecs_iter_next(&it)) {
+    tb_auto *bodies = ecs_field(&it, ThsHullBody, 1);
+    tb_auto *lods = ecs_field(&it, ThsBoatLod, 2);
+    const tb_auto *boat_transform = ecs_field(&it, TbTransformComponent, 3);
+    const ecs_entity_t boat = ecs_field_src(&it, 3);
+    const TbTransform *boat_trans = &boat_transform->transform;
+    for (int32_t i = 0; i < it.count; ++i) {
+      tb_auto *body = &bodies[i];
+      tb_auto *lod = &lods[i];
+      if (body->body == THS_BUOYANCY_INVALID_BODY) {
+        continue;
+      }
+      if (!ths_transforms_equal(&body->synced, boat_trans)) {
+        const float pos[3] = {boat_trans->position.x, boat_trans->position.y,
+                              boat_trans->position.z};
+        const float rot[4] = {boat_trans->rotation.x, boat_trans->rotation.y,
+                              boat_trans->rotation.z, boat_trans->rotation.w};
+        ths_buoyancy_teleport_hull(sys->buoyancy, body->body, pos, rot);
+        body->synced = *boat_trans;
       }
 
-      boat_transform->transform.position += velocity * it->delta_time;
-      tb_transform_mark_dirty(ecs, boat);
+      if (lod->asleep && !body->sleeping) {
+        ths_buoyancy_set_hull_active(sys->buoyancy, body->body, false);
+        body->sleeping = true;
+      } else if (!lod->asleep && body->sleeping) {
+        ths_buoyancy_set_hull_active(sys->buoyancy, body->body, true);
+        body->sleeping = false;
+      }
+      if (body->sleeping) {
+        // Jolt wakes sleeping bodies that get bumped or teleported
+        ThsHullState state = {0};
+        if (!ths_buoyancy_get_hull(sys->buoyancy, body->body, &state) ||
+            !state.active) {
+          continue;
+        }
+        body->sleeping = false;
+        lod->asleep = false;
+        lod->still_steps = 0;
+      }
+
+      if (!lod->due) {
+        // Between reduced rate ticks the water plane follows the hull with
+        // the height and slope it had when it was last sampled
+        body->input.water_point[0] = boat_trans->position.x;
+        body->input.water_point[2] = boat_trans->position.z;
+      }
+      body->input.body = body->body;
+      TB_DYN_ARR_APPEND(sys->inputs, body->input);
+      TB_DYN_ARR_APPEND(sys->bodies, body);
+      TB_DYN_ARR_APPEND(sys->lods, lod);
+      TB_DYN_ARR_APPEND(sys->boats, boat);
+      TB_DYN_ARR_APPEND(sys->poses, boat_trans);
     }
   }
 
+  const uint32_t count = (uint32_t)TB_DYN_ARR_SIZE(sys->inputs);
+  if (count > 0) {
+    ths_buoyancy_step(sys->buoyancy, &TB_DYN_ARR_AT(sys->inputs, 0), count,
+                      delta_time);
+  }
+
+  for (uint32_t i = 0; i < count; ++i) {
+    tb_auto *body = TB_DYN_ARR_AT(sys->bodies, i);
+    const ecs_entity_t boat = TB_DYN_ARR_AT(sys->boats, i);
+    tb_auto *lod = TB_DYN_ARR_AT(sys->lods, i);
+    ThsHullState state = {0};
+    if (!ths_buoyancy_get_hull(sys->buoyancy, body->body, &state)) {
+      continue;
+    }
+    const float rest_speed_sq =
+        THS_BOAT_LOD_REST_SPEED * THS_BOAT_LOD_REST_SPEED;
+    const float speed_sq = state.velocity[0] * state.velocity[0] +
+                           state.velocity[2] * state.velocity[2];
+    lod->still_steps = speed_sq < rest_speed_sq ? lod->still_steps + 1 : 0;
+
+    // Keeps whatever scale the boat was authored with
+    TbTransform trans = *TB_DYN_ARR_AT(sys->poses, i);
+    trans.position =
+        tb_f3(state.position[0], state.position[1], state.position[2]);
+    trans.rotation = (TbQuaternion){state.rotation[0], state.rotation[1],
+                                    state.rotation[2], state.rotation[3]};
+    ths_write_transform(ecs, boat, &trans);
+    body->synced = trans;
+  }
+
+  const ThsBuoyancyStats stats = ths_buoyancy_stats(sys->buoyancy);
+  TracyCPlot("Hull Bodies", (double)stats.body_count);
+  TracyCPlot("Hulls Submerged", (double)stats.submerged_count);
+
+  ths_profile_end(prof);
+}
+
+// Sync point after the parallel tick. Steps the hull bodies and applies every
+// stage's buffered writes on the main thread so later systems in the step see
+// the moved boats
+void boat_movement_merge_tick(ecs_iter_t *it) {
+  TracyCZoneN(ctx, "Boat Movement Merge", true);
+  TracyCZoneColor(ctx, TracyCategoryColorGame);
+  ThsProfileScope prof = ths_profile_begin(merge_track);
+
+  ecs_world_t *ecs = it->world;
+  tb_auto *sys = ecs_singleton_get_mut(ecs, ThsBoatMovementSystem);
+
+  step_buoyancy(ecs, sys, it->delta_time);
+
+  // Dirty marking waits until the frame's transforms are final
+  ths_apply_transform_writes(ecs);
+
+  ths_profile_end(prof);
   TracyCZoneEnd(ctx);
 }
 
+// Whether another hull of the boat already floats it
+static bool boat_has_hull_body(ecs_world_t *ecs, ecs_entity_t boat) {
+  ecs_iter_t it = ecs_children(ecs, boat);
+  while (ecs_children_next(&it)) {
+    if (ecs_table_has_id(ecs, it.table, ecs_id(ThsHullBody))) {
+      ecs_iter_fini(&it);
+      return true;
+    }
+  }
+  return false;
+}
+
+void boat_movement_on_set(ecs_iter_t *it) {
+  ecs_world_t *ecs = it->world;
+  tb_auto *sys = ecs_singleton_get_mut(ecs, ThsBoatMovementSystem);
+  for (int32_t i = 0; i < it->count; ++i) {
+    const ecs_entity_t ent = it->entities[i];
+    const ecs_entity_t boat = ecs_get_parent(ecs, ent);
+    ths_sim_interpolate(ecs, ent);
+    // A hull without a boat above it has no pose to float from
+    if (boat == 0) {
+      continue;
+    }
+    ths_sim_interpolate(ecs, boat);
+
+    const tb_auto *boat_transform = ecs_get(ecs, boat, TbTransformComponent);
+    // Inherited from the hull's class
+    const tb_auto *tuning = ecs_get(ecs, ent, ThsBoatTuningComponent);
+    if (ecs_has(ecs, ent, ThsHullBody) || boat_transform == NULL ||
+        tuning == NULL) {
+      continue;
+    }
+    // One body stands in for the whole boat and writes the boat's pose, so
+    // a second hull would fight the first for it. Extra hulls aren't ticked
+    if (boat_has_hull_body(ecs, boat)) {
+      SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION,
+                  "Boat %s has more than one hull; ignoring hull %s",
+                  ecs_get_name(ecs, boat), ecs_get_name(ecs, ent));
+      continue;
+    }
+    // Boats are root entities so their local transform is their pose
+    const TbTransform *trans = &boat_transform->transform;
+    ThsHullDesc desc = {
+        .position = {trans->position.x, trans->position.y, trans->position.z},
+        .rotation = {trans->rotation.x, trans->rotation.y, trans->rotation.z,
+                     trans->rotation.w},
+        .half_extents = {tuning->half_width, tuning->half_height,
+                         tuning->half_length},
+        .density = tuning->density,
+    };
+    ThsHullBody body = {
+        .body = ths_buoyancy_add_hull(sys->buoyancy, &desc),
+        .synced = *trans,
+    };
+    if (body.body == THS_BUOYANCY_INVALID_BODY) {
+      SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION,
+                  "Failed to create a buoyancy body for hull %s",
+                  ecs_get_name(ecs, ent));
+    }
+    ecs_set_ptr(ecs, ent, ThsHullBody, &body);
+  }
+}
+
+void hull_body_on_remove(ecs_iter_t *it) {
+  ecs_world_t *ecs = it->world;
+  // The system goes away first when the world is torn down and takes every
+  // body with it
+  tb_auto *sys = ecs_singleton_get_mut(ecs, ThsBoatMovementSystem);
+  if (sys == NULL || sys->buoyancy == NULL) {
+    return;
+  }
+  tb_auto *bodies = ecs_field(it, ThsHullBody, 1);
+  for (int32_t i = 0; i < it->count; ++i) {
+    ths_buoyancy_remove_hull(sys->buoyancy, bodies[i].body);
+  }
+}
+
 void ths_register_boat_movement_sys(TbWorld *world) {
   ecs_world_t *ecs = world->ecs;
   ECS_COMPONENT_DEFINE(ecs, ThsBoatMovementSystem);
-
+  ECS_COMPONENT_DEFINE(ecs, ThsHullBody);
+  // The LOD system may register after us but our queries need its component
+  ECS_COMPONENT_DEFINE(ecs, ThsBoatLod);
+
+  prepare_track = ths_profiler_track("Boat Movement Prepare");
+  // Summed across worker threads
+  tick_track = ths_profiler_track("Boat Movement Tick");
+  merge_track = ths_profiler_track("Boat Movement Merge");
+  buoyancy_track = ths_profiler_track("Buoyancy Step");
+
+  // Buoyancy only needs to beat gravity by a little to float the hulls; the
+  // drag keeps them from bouncing on every wave
+  ThsBuoyancyDesc buoyancy_desc = {
+      .buoyancy = 1.1f,
+      .linear_drag = 0.5f,
+      .angular_drag = 0.05f,
+  };
   ThsBoatMovementSystem sys = {
-      .ocean_query = ecs_query(ecs, {.filter.terms =
-                                         {
-                                             {.id = ecs_id(TbOceanComponent)},
-                                         }}),
+      .buoyancy = ths_create_buoyancy_world(&buoyancy_desc),
+      .body_query = ecs_query(
+          ecs, {.filter.terms =
+                    {
+                        {.id = ecs_id(ThsHullBody)},
+                        {.id = ecs_id(ThsBoatLod)},
+                        {.id = ecs_id(TbTransformComponent),
+                         .inout = EcsIn,
+                         .src.flags = EcsUp,
+                         .src.trav = EcsChildOf},
+                    }}),
   };
+  TB_DYN_ARR_RESET(sys.inputs, world->gp_alloc, 64);
+  TB_DYN_ARR_RESET(sys.bodies, world->gp_alloc, 64);
+  TB_DYN_ARR_RESET(sys.lods, world->gp_alloc, 64);
+  TB_DYN_ARR_RESET(sys.boats, world->gp_alloc, 64);
+  TB_DYN_ARR_RESET(sys.poses, world->gp_alloc, 64);
   ecs_set_ptr(ecs, ecs_id(ThsBoatMovementSystem), ThsBoatMovementSystem, &sys);
 
-  ECS_SYSTEM(ecs, boat_movement_update_tick, EcsOnUpdate, TbTransformComponent,
-             ThsBoatMovementComponent);
+  // Boats and their hulls are blended between simulation steps
+  ecs_observer(ecs, {.filter.terms =
+                         {
+                             {.id = ecs_id(ThsBoatMovementComponent)},
+                         },
+                     .events = {EcsOnSet},
+                     .callback = boat_movement_on_set});
+  ecs_observer(ecs, {.filter.terms =
+                         {
+                             {.id = ecs_id(ThsHullBody)},
+                         },
+                     .events = {EcsOnRemove},
+                     .callback = hull_body_on_remove});
+
+  // Systems in a phase run in declaration order. Switching between single
+  // and multi threaded systems is what gives us the sync points
+  ecs_entity_t phase = ths_sim_phase(ecs, THS_SIM_UPDATE);
+  ecs_system(ecs, {.entity = ecs_entity(ecs, {.name = "Boat Movement Prepare",
+                                              .add = {ecs_dependson(phase)}}),
+                   .callback = boat_movement_prepare_tick});
+  ecs_system(ecs,
+             {.entity = ecs_entity(ecs, {.name = "Boat Movement Tick",
+                                         .add = {ecs_dependson(phase)}}),
+              .query.filter.terms =
+                  {
+                      {.id = ecs_id(TbTransformComponent)},
+                      {.id = ecs_id(ThsBoatMovementComponent)},
+                      // The boat the hull belongs to. Cascade keeps hulls of
+                      // the same boat together
+                      {.id = ecs_id(TbTransformComponent),
+                       .inout = EcsIn,
+                       .src.flags = EcsUp | EcsCascade,
+                       .src.trav = EcsChildOf},
+                      {.id = ecs_id(ThsHullBody)},
+                      {.id = ecs_id(ThsBoatLod), .inout = EcsIn},
+                      // Only ever on the class prefab
+                      {.id = ecs_id(ThsBoatTuningComponent),
+                       .inout = EcsIn,
+                       .src.flags = EcsUp,
+                       .src.trav = EcsIsA},
+                  },
+              .callback = boat_movement_update_tick,
+              .multi_threaded = true});
+  ecs_system(ecs, {.entity = ecs_entity(ecs, {.name = "Boat Movement Merge",
+                                              .add = {ecs_dependson(phase)}}),
+                   .callback = boat_movement_merge_tick});
 }
 
 void ths_unregister_boat_movement_sys(TbWorld *world) {
   ecs_world_t *ecs = world->ecs;
   tb_auto sys = ecs_singleton_get_mut(ecs, ThsBoatMovementSystem);
-  ecs_query_fini(sys->ocean_query);
+  ecs_query_fini(sys->body_query);
+  ths_destroy_buoyancy_world(sys->buoyancy);
+  sys->buoyancy = NULL;
+  TB_DYN_ARR_DESTROY(sys->inputs);
+  TB_DYN_ARR_DESTROY(sys->bodies);
+  TB_DYN_ARR_DESTROY(sys->lods);
+  TB_DYN_ARR_DESTROY(sys->boats);
+  TB_DYN_ARR_DESTROY(sys->poses);
   ecs_singleton_remove(ecs, ThsBoatMovementSystem);
 }
 
@@ -0,0 +1,359 @@
+#include "buoyancy.h"
+
+#include "profiling.h"
+
+// Jolt.h must come before any other Jolt header
+#include <Jolt/Jolt.h>
+
+#include <Jolt/Core/Factory.h>
+#include <Jolt/Core/JobSystemThreadPool.h>
+#include <Jolt/Core/TempAllocator.h>
+#include <Jolt/Physics/Body/BodyCreationSettings.h>
+#include <Jolt/Physics/Body/BodyLock.h>
+#include <Jolt/Physics/Collision/Shape/BoxShape.h>
+#include <Jolt/Physics/PhysicsSettings.h>
+#include <Jolt/Physics/PhysicsSystem.h>
+#include <Jolt/RegisterTypes.h>
+
+#include <SDL3/SDL.h>
+
+#include <vector>
+
+// Hulls bump into each other but nothing else exists in this world yet
+namespace Layers {
+static constexpr JPH::ObjectLayer hulls = 0;
+static constexpr JPH::uint count = 1;
+} // namespace Layers
+
+namespace BroadPhaseLayers {
+static constexpr JPH::BroadPhaseLayer moving(0);
+static constexpr JPH::uint count = 1;
+} // namespace BroadPhaseLayers
+
+class ThsBroadPhaseLayers final : public JPH::BroadPhaseLayerInterface {
+public:
+  JPH::uint GetNumBroadPhaseLayers() const override {
+    return BroadPhaseLayers::count;
+  }
+  JPH::BroadPhaseLayer GetBroadPhaseLayer(JPH::ObjectLayer) const override {
+    return BroadPhaseLayers::moving;
+  }
+#if defined(JPH_EXTERNAL_PROFILE) || defined(JPH_PROFILE_ENABLED)
+  const char *GetBroadPhaseLayerName(JPH::BroadPhaseLayer) const override {
+    return "Moving";
+  }
+#endif
+};
+
+class ThsObjectVsBroadPhase final
+    : public JPH::ObjectVsBroadPhaseLayerFilter {
+public:
+  bool ShouldCollide(JPH::ObjectLayer, JPH::BroadPhaseLayer) const override {
+    return true;
+  }
+};
+
+class ThsObjectLayerPairs final : public JPH::ObjectLayerPairFilter {
+public:
+  bool ShouldCollide(JPH::ObjectLayer, JPH::ObjectLayer) const override {
+    return true;
+  }
+};
+
+// Hulls per job; small enough that a few hundred hulls spread across cores
+#define THS_BUOYANCY_JOB_SIZE 32
+// How quickly hulls reach the speed and turn rate they steer towards
+#define THS_BUOYANCY_STEER_RATE 2.0f
+#define THS_BUOYANCY_TEMP_SIZE (1024 * 1024 * 8)
+
+struct ThsBuoyancyWorld {
+  ThsBuoyancyDesc desc;
+  bool owns_factory;
+
+  ThsBroadPhaseLayers broad_phase_layers;
+  ThsObjectVsBroadPhase object_vs_broad_phase;
+  ThsObjectLayerPairs object_layer_pairs;
+
+  JPH::TempAllocatorImpl *temp;
+  JPH::JobSystemThreadPool *jobs;
+  JPH::PhysicsSystem physics;
+
+  // Indexed by body index; written by jobs for disjoint bodies
+  std::vector<uint8_t> submerged;
+
+  ThsBuoyancyStats stats;
+};
+
+static JPH::BodyID to_body_id(uint32_t body) { return JPH::BodyID(body); }
+
+static float ms_since(uint64_t start) {
+  return (float)((double)(SDL_GetPerformanceCounter() - start) * 1000.0 /
+                 (double)SDL_GetPerformanceFrequency());
+}
+
+extern "C" {
+
+ThsBuoyancyWorld *ths_create_buoyancy_world(const ThsBuoyancyDesc *desc) {
+  // Toybox may have brought Jolt up already
+  bool owns_factory = JPH::Factory::sInstance == nullptr;
+  if (owns_factory) {
+    JPH::RegisterDefaultAllocator();
+    JPH::Factory::sInstance = new JPH::Factory();
+    JPH::RegisterTypes();
+  }
+
+  ThsBuoyancyWorld *world = new ThsBuoyancyWorld();
+  world->desc = *desc;
+  world->owns_factory = owns_factory;
+
+  int32_t thread_count = desc->thread_count;
+  if (thread_count <= 0) {
+    // The calling thread helps out while it waits
+    thread_count = SDL_max(SDL_GetCPUCount() - 1, 1);
+  }
+  world->temp = new JPH::TempAllocatorImpl(THS_BUOYANCY_TEMP_SIZE);
+  world->jobs = new JPH::JobSystemThreadPool(
+      JPH::cMaxPhysicsJobs, JPH::cMaxPhysicsBarriers, thread_count);
+
+  world->physics.Init(THS_BUOYANCY_MAX_BODIES, 0, THS_BUOYANCY_MAX_BODIES,
+                      THS_BUOYANCY_MAX_BODIES, world->broad_phase_layers,
+                      world->object_vs_broad_phase,
+                      world->object_layer_pairs);
+  world->submerged.resize(THS_BUOYANCY_MAX_BODIES, 0);
+  return world;
+}
+
+void ths_destroy_buoyancy_world(ThsBuoyancyWorld *world) {
+  if (world == nullptr) {
+    return;
+  }
+  const bool owns_factory = world->owns_factory;
+
+  // Bodies have to go before the physics system does
+  JPH::BodyIDVector bodies;
+  world->physics.GetBodies(bodies);
+  JPH::BodyInterface &iface = world->physics.GetBodyInterfaceNoLock();
+  for (const JPH::BodyID &id : bodies) {
+    iface.RemoveBody(id);
+    iface.DestroyBody(id);
+  }
+
+  delete world->jobs;
+  delete world->temp;
+  delete world;
+
+  if (owns_factory) {
+    JPH::UnregisterTypes();
+    delete JPH::Factory::sInstance;
+    JPH::Factory::sInstance = nullptr;
+  }
+}
+
+uint32_t ths_buoyancy_add_hull(ThsBuoyancyWorld *world,
+                               const ThsHullDesc *desc) {
+  JPH::BoxShapeSettings shape_settings(JPH::Vec3(
+      desc->half_extents[0], desc->half_extents[1], desc->half_extents[2]));
+  shape_settings.SetDensity(desc->density);
+  JPH::ShapeSettings::ShapeResult shape = shape_settings.Create();
+  if (shape.HasError()) {
+    SDL_Log("Buoyancy: failed to create hull shape: %s",
+            shape.GetError().c_str());
+    return THS_BUOYANCY_INVALID_BODY;
+  }
+
+  JPH::BodyCreationSettings settings(
+      shape.Get(),
+      JPH::RVec3(desc->position[0], desc->position[1], desc->position[2]),
+      JPH::Quat(desc->rotation[0], desc->rotation[1], desc->rotation[2],
+                desc->rotation[3])
+          .Normalized(),
+      JPH::EMotionType::Dynamic, Layers::hulls);
+  // Waves keep pushing hulls around so they never really rest
+  settings.mAllowSleeping = false;
+
+  JPH::BodyInterface &iface = world->physics.GetBodyInterface();
+  JPH::BodyID id = iface.CreateAndAddBody(settings, JPH::EActivation::Activate);
+  if (id.IsInvalid()) {
+    return THS_BUOYANCY_INVALID_BODY;
+  }
+  world->stats.body_count++;
+  return id.GetIndexAndSequenceNumber();
+}
+
+void ths_buoyancy_remove_hull(ThsBuoyancyWorld *world, uint32_t body) {
+  if (body == THS_BUOYANCY_INVALID_BODY) {
+    return;
+  }
+  JPH::BodyInterface &iface = world->physics.GetBodyInterface();
+  const JPH::BodyID id = to_body_id(body);
+  iface.RemoveBody(id);
+  iface.DestroyBody(id);
+  world->submerged[id.GetIndex()] = 0;
+  world->stats.body_count--;
+}
+
+void ths_buoyancy_teleport_hull(ThsBuoyancyWorld *world, uint32_t body,
+                                const float position[3],
+                                const float rotation[4]) {
+  if (body == THS_BUOYANCY_INVALID_BODY) {
+    return;
+  }
+  JPH::BodyInterface &iface = world->physics.GetBodyInterface();
+  const JPH::BodyID id = to_body_id(body);
+  iface.SetPositionAndRotation(
+      id, JPH::RVec3(position[0], position[1], position[2]),
+      JPH::Quat(rotation[0], rotation[1], rotation[2], rotation[3])
+          .Normalized(),
+      JPH::EActivation::Activate);
+  iface.SetLinearAndAngularVelocity(id, JPH::Vec3::sZero(),
+                                    JPH::Vec3::sZero());
+}
+
+void ths_buoyancy_set_hull_active(ThsBuoyancyWorld *world, uint32_t body,
+                                  bool active) {
+  if (body == THS_BUOYANCY_INVALID_BODY) {
+    return;
+  }
+  JPH::BodyInterface &iface = world->physics.GetBodyInterface();
+  const JPH::BodyID id = to_body_id(body);
+  if (active) {
+    iface.ActivateBody(id);
+  } else {
+    // Whatever it was doing shouldn't carry on once it wakes
+    iface.SetLinearAndAngularVelocity(id, JPH::Vec3::sZero(),
+                                      JPH::Vec3::sZero());
+    iface.DeactivateBody(id);
+  }
+}
+
+// Buoyancy and drag from the part of the hull below the water plane, then a
+// nudge towards the speed and turn rate the hull is steering for and away
+// from any hull it is about to run into
+static void apply_hull_forces(ThsBuoyancyWorld *world,
+                              const ThsHullInput *input, float dt) {
+  const JPH::BodyLockInterfaceNoLock &locks =
+      world->physics.GetBodyLockInterfaceNoLock();
+  JPH::BodyLockWrite lock(locks, to_body_id(input->body));
+  if (!lock.Succeeded()) {
+    return;
+  }
+  JPH::Body &body = lock.GetBody();
+
+  const JPH::RVec3 surface(input->water_point[0], input->water_point[1],
+                           input->water_point[2]);
+  const JPH::Vec3 normal(input->water_normal[0], input->water_normal[1],
+                         input->water_normal[2]);
+  const ThsBuoyancyDesc *desc = &world->desc;
+  const bool submerged = body.ApplyBuoyancyImpulse(
+      surface, normal.NormalizedOr(JPH::Vec3::sAxisY()), desc->buoyancy,
+      desc->linear_drag, desc->angular_drag, JPH::Vec3::sZero(),
+      world->physics.GetGravity(), dt);
+  world->submerged[body.GetID().GetIndex()] = submerged ? 1 : 0;
+
+  // Sails and rudders only work in the water
+  if (!submerged) {
+    return;
+  }
+  const float steer = SDL_min(THS_BUOYANCY_STEER_RATE * dt, 1.0f);
+
+  const JPH::Vec3 forward(input->forward[0], input->forward[1],
+                          input->forward[2]);
+  JPH::Vec3 velocity = body.GetLinearVelocity();
+  const float forward_speed = velocity.Dot(forward);
+  velocity += forward * ((input->target_speed - forward_speed) * steer);
+
+  // Only tops up the speed away from neighbours so hulls already parting
+  // aren't slowed down
+  const JPH::Vec3 separation(input->separation[0], input->separation[1],
+                             input->separation[2]);
+  const float separation_speed = separation.Length();
+  if (separation_speed > 0.0f) {
+    const JPH::Vec3 away = separation / separation_speed;
+    const float away_speed = velocity.Dot(away);
+    if (away_speed < separation_speed) {
+      velocity += away * ((separation_speed - away_speed) * steer);
+    }
+  }
+  body.SetLinearVelocityClamped(velocity);
+
+  JPH::Vec3 angular = body.GetAngularVelocity();
+  angular.SetY(angular.GetY() + (input->target_yaw_rate - angular.GetY()) *
+                                    steer);
+  body.SetAngularVelocityClamped(angular);
+}
+
+void ths_buoyancy_step(ThsBuoyancyWorld *world, const ThsHullInput *inputs,
+                       uint32_t input_count, float dt) {
+  TracyCZoneNC(ctx, "Buoyancy Step", TracyCategoryColorPhysics, true);
+
+  // Each job owns a contiguous range of hulls so no two touch the same body
+  uint64_t start = SDL_GetPerformanceCounter();
+  {
+    JPH::JobSystem::Barrier *barrier = world->jobs->CreateBarrier();
+    for (uint32_t first = 0; first < input_count;
+         first += THS_BUOYANCY_JOB_SIZE) {
+      const uint32_t last =
+          SDL_min(first + THS_BUOYANCY_JOB_SIZE, input_count);
+      JPH::JobHandle job = world->jobs->CreateJob(
+          "Hull Forces", JPH::Color::sCyan, [world, inputs, first, last, dt]() {
+            for (uint32_t i = first; i < last; ++i) {
+              apply_hull_forces(world, &inputs[i], dt);
+            }
+          });
+      barrier->AddJob(job);
+    }
+    world->jobs->WaitForJobs(barrier);
+    world->jobs->DestroyBarrier(barrier);
+  }
+  world->stats.forces_ms = ms_since(start);
+
+  start = SDL_GetPerformanceCounter();
+  world->physics.Update(dt, 1, world->temp, world->jobs);
+  world->stats.physics_ms = ms_since(start);
+
+  uint32_t submerged_count = 0;
+  for (uint32_t i = 0; i < input_count; ++i) {
+    submerged_count +=
+        world->submerged[to_body_id(inputs[i].body).GetIndex()];
+  }
+  world->stats.submerged_count = submerged_count;
+
+  TracyCPlot("Buoyancy Forces ms", (double)world->stats.forces_ms);
+  TracyCPlot("Buoyancy Physics ms", (double)world->stats.physics_ms);
+  TracyCZoneEnd(ctx);
+}
+
+bool ths_buoyancy_get_hull(const ThsBuoyancyWorld *world, uint32_t body,
+                           ThsHullState *state) {
+  if (body == THS_BUOYANCY_INVALID_BODY) {
+    return false;
+  }
+  const JPH::BodyID id = to_body_id(body);
+  const JPH::BodyInterface &iface = world->physics.GetBodyInterfaceNoLock();
+  if (!iface.IsAdded(id)) {
+    return false;
+  }
+  JPH::RVec3 pos;
+  JPH::Quat rot;
+  iface.GetPositionAndRotation(id, pos, rot);
+  state->position[0] = (float)pos.GetX();
+  state->position[1] = (float)pos.GetY();
+  state->position[2] = (float)pos.GetZ();
+  state->rotation[0] = rot.GetX();
+  state->rotation[1] = rot.GetY();
+  state->rotation[2] = rot.GetZ();
+  state->rotation[3] = rot.GetW();
+  const JPH::Vec3 velocity = iface.GetLinearVelocity(id);
+  state->velocity[0] = velocity.GetX();
+  state->velocity[1] = velocity.GetY();
+  state->velocity[2] = velocity.GetZ();
+  state->submerged = world->submerged[id.GetIndex()] != 0;
+  state->active = iface.IsActive(id);
+  return true;
+}
+
+ThsBuoyancyStats ths_buoyancy_stats(const ThsBuoyancyWorld *world) {
+  return world->stats;
+}
+
+} // extern "C"
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Rigid body hulls floating on the ocean, simulated with Jolt
+//
+// Jolt lives in buoyancy.cpp behind this C interface so the rest of the game
+// stays C. Every step the game hands in the water surface under each hull
+// along with what the hull is trying to do. Buoyancy, drag and steering
+// forces are then applied in parallel on Jolt's own job system before the
+// physics update, which uses the same thread pool
+//
+// Vectors are plain floats so this header doesn't depend on the simd types
+
+#define THS_BUOYANCY_INVALID_BODY 0xFFFFFFFF
+#define THS_BUOYANCY_MAX_BODIES 4096
+
+typedef struct ThsBuoyancyWorld ThsBuoyancyWorld;
+
+typedef struct ThsBuoyancyDesc {
+  int32_t thread_count; // Jolt worker threads; 0 picks one per core
+  // How much stronger buoyancy is than what would exactly float the hull
+  float buoyancy;
+  float linear_drag;
+  float angular_drag;
+} ThsBuoyancyDesc;
+
+typedef struct ThsHullDesc {
+  float position[3];
+  float rotation[4];
+  float half_extents[3]; // Box the hull is simulated as
+  float density;         // kg/m^3; water is 1000
+} ThsHullDesc;
+
+// What the game decided for a hull this step
+typedef struct ThsHullInput {
+  uint32_t body;
+  float water_point[3];  // A point on the water surface under the hull
+  float water_normal[3]; // Surface normal at that point
+  float forward[3];      // Direction to drive in, flat on the XZ plane
+  float target_speed;
+  float target_yaw_rate; // Radians per second around up
+  // Velocity on the XZ plane the hull should at least have away from its
+  // neighbours. Zero when nothing is close
+  float separation[3];
+} ThsHullInput;
+
+typedef struct ThsHullState {
+  float position[3];
+  float rotation[4];
+  float velocity[3];
+  bool submerged; // Whether any part of the hull touched the water last step
+  bool active;    // False while put to sleep and nothing has woken it
+} ThsHullState;
+
+typedef struct ThsBuoyancyStats {
+  uint32_t body_count;
+  uint32_t submerged_count;
+  float forces_ms;  // Parallel buoyancy and steering forces
+  float physics_ms; // Jolt's physics update
+} ThsBuoyancyStats;
+
+ThsBuoyancyWorld *ths_create_buoyancy_world(const ThsBuoyancyDesc *desc);
+void ths_destroy_buoyancy_world(ThsBuoyancyWorld *world);
+
+// Returns THS_BUOYANCY_INVALID_BODY when the world is full
+uint32_t ths_buoyancy_add_hull(ThsBuoyancyWorld *world,
+                               const ThsHullDesc *desc);
+void ths_buoyancy_remove_hull(ThsBuoyancyWorld *world, uint32_t body);
+
+// Moves a hull without simulating, e.g. when a save is restored
+void ths_buoyancy_teleport_hull(ThsBuoyancyWorld *world, uint32_t body,
+                                const float position[3],
+                                const float rotation[4]);
+
+// Sleeping hulls aren't simulated until activated again or until another
+// body bumps into them. Hulls that sleep shouldn't be passed to the step
+void ths_buoyancy_set_hull_active(ThsBuoyancyWorld *world, uint32_t body,
+                                  bool active);
+
+// Applies forces for every input then advances the physics by dt
+void ths_buoyancy_step(ThsBuoyancyWorld *world, const ThsHullInput *inputs,
+                       uint32_t input_count, float dt);
+
+bool ths_buoyancy_get_hull(const ThsBuoyancyWorld *world, uint32_t body,
+                           ThsHullState *state);
+
+ThsBuoyancyStats ths_buoyancy_stats(const ThsBuoyancyWorld *world);
+
+#ifdef __cplusplus
+}
+#endif
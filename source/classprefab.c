@@ -0,0 +1,61 @@
+#include "classprefab.h"
+
+#include "profiling.h"
+
+#include <SDL3/SDL.h>
+
+// Different tuning hashing the same is unlikely; past this many the value
+// gets a prefab of its own that nothing else finds
+#define MAX_COLLISIONS 8
+
+static uint32_t hash_value(const void *value, size_t size) {
+  // FNV-1a
+  const uint8_t *bytes = value;
+  uint32_t hash = 2166136261u;
+  for (size_t i = 0; i < size; ++i) {
+    hash = (hash ^ bytes[i]) * 16777619u;
+  }
+  return hash;
+}
+
+ecs_entity_t ths_class_prefab(ecs_world_t *ecs, const char *prefix,
+                              ecs_id_t comp, size_t size, const void *value) {
+  TracyCZoneNC(ctx, "Find Class Prefab", TracyCategoryColorCore, true);
+  const uint32_t hash = hash_value(value, size);
+  char name[64] = {0};
+  for (uint32_t i = 0; i < MAX_COLLISIONS; ++i) {
+    SDL_snprintf(name, sizeof(name), "%s_%08x_%u", prefix, hash, i);
+    const ecs_entity_t prefab = ecs_lookup(ecs, name);
+    if (prefab == 0) {
+      break;
+    }
+    const void *existing = ecs_get_id(ecs, prefab, comp);
+    if (existing && SDL_memcmp(existing, value, size) == 0) {
+      TracyCZoneEnd(ctx);
+      return prefab;
+    }
+  }
+
+  // Either a new class or one that collided too often; the name of the last
+  // slot tried is free in the first case and reused in the second
+  const ecs_entity_t prefab =
+      ecs_entity(ecs, {.name = ecs_lookup(ecs, name) ? NULL : name,
+                       .add = {EcsPrefab}});
+  ecs_set_id(ecs, prefab, comp, size, value);
+  TracyCZoneEnd(ctx);
+  return prefab;
+}
+
+void ths_remove_class_prefab(ecs_world_t *ecs, ecs_entity_t ent,
+                             ecs_id_t comp) {
+  for (int32_t i = 0;; ++i) {
+    const ecs_entity_t prefab = ecs_get_target(ecs, ent, EcsIsA, i);
+    if (prefab == 0) {
+      return;
+    }
+    if (ecs_owns_id(ecs, prefab, comp)) {
+      ecs_remove_pair(ecs, ent, EcsIsA, prefab);
+      return;
+    }
+  }
+}
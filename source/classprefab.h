@@ -0,0 +1,21 @@
+#pragma once
+
+#include <flecs.h>
+
+// Tuning that every boat of a kind shares lives on a prefab the boats
+// inherit from (IsA) rather than on each boat. Queries match it with an up
+// term on IsA, which hands the tick one copy per table instead of one per
+// boat
+//
+// Boats tuned the same are the same class, so prefabs are keyed by the
+// tuning itself. Scenes and generated fleets with identical boats end up
+// sharing one prefab no matter how the boats were made
+
+// Finds the prefab holding exactly this value of the component, creating
+// it if there is none yet. The prefix names the prefab for debugging
+ecs_entity_t ths_class_prefab(ecs_world_t *ecs, const char *prefix,
+                              ecs_id_t comp, size_t size, const void *value);
+
+// Stops an entity inheriting from whichever class prefab holds the component
+void ths_remove_class_prefab(ecs_world_t *ecs, ecs_entity_t ent,
+                             ecs_id_t comp);
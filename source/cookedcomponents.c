@@ -0,0 +1,248 @@
+#include "cookedcomponents.h"
+
+#include "mappedfile.h"
+#include "profiling.h"
+#include "tbcommon.h"
+#include "tbgltf.h"
+#include "world.h"
+
+#include <SDL3/SDL.h>
+
+#include <stdio.h>
+
+// Payloads start on this boundary so any descriptor can be read in place
+#define THS_COOKED_ALIGN 8
+
+// The sidecar of the scene a world is loading. Scenes load one at a time on
+// the main thread so each world only needs a single slot
+typedef struct ThsCookedScene {
+  TbAllocator alloc;
+  char source_path[512];
+  ThsMappedFile mapped; // Sidecars read from disk are used in place
+  uint8_t *blob;        // Blobs bound directly are owned
+  const uint8_t *data;
+  size_t size;
+  const ThsCookedRecord *records;
+  uint32_t record_count;
+} ThsCookedScene;
+
+ECS_COMPONENT_DECLARE(ThsCookedScene);
+
+uint32_t ths_cooked_hash(const char *str) {
+  // FNV-1a
+  uint32_t h = 0x811C9DC5u;
+  for (const char *c = str; *c; ++c) {
+    h ^= (uint8_t)*c;
+    h *= 0x01000193u;
+  }
+  return h;
+}
+
+void ths_create_cooked_writer(TbAllocator alloc, ThsCookedWriter *writer) {
+  *writer = (ThsCookedWriter){.alloc = alloc};
+  TB_DYN_ARR_RESET(writer->records, alloc, 64);
+  TB_DYN_ARR_RESET(writer->payload, alloc, 1024);
+}
+
+void ths_destroy_cooked_writer(ThsCookedWriter *writer) {
+  TB_DYN_ARR_DESTROY(writer->records);
+  TB_DYN_ARR_DESTROY(writer->payload);
+}
+
+void ths_cooked_writer_add(ThsCookedWriter *writer, const char *node_name,
+                           const char *type_name, const void *data,
+                           uint32_t size) {
+  while (TB_DYN_ARR_SIZE(writer->payload) % THS_COOKED_ALIGN != 0) {
+    TB_DYN_ARR_APPEND(writer->payload, 0);
+  }
+  ThsCookedRecord record = {
+      .node_hash = ths_cooked_hash(node_name),
+      .type_hash = ths_cooked_hash(type_name),
+      // Relative to the payload until the writer finishes
+      .offset = (uint32_t)TB_DYN_ARR_SIZE(writer->payload),
+      .size = size,
+  };
+  TB_DYN_ARR_APPEND(writer->records, record);
+  const uint8_t *bytes = data;
+  for (uint32_t i = 0; i < size; ++i) {
+    TB_DYN_ARR_APPEND(writer->payload, bytes[i]);
+  }
+}
+
+static int32_t compare_records(const void *a, const void *b) {
+  const ThsCookedRecord *ra = a;
+  const ThsCookedRecord *rb = b;
+  if (ra->node_hash != rb->node_hash) {
+    return ra->node_hash < rb->node_hash ? -1 : 1;
+  }
+  return (ra->type_hash > rb->type_hash) - (ra->type_hash < rb->type_hash);
+}
+
+uint8_t *ths_cooked_writer_finish(ThsCookedWriter *writer, size_t *size) {
+  const uint32_t record_count = (uint32_t)TB_DYN_ARR_SIZE(writer->records);
+  const size_t payload_size = TB_DYN_ARR_SIZE(writer->payload);
+  size_t payload_start =
+      sizeof(ThsCookedHeader) + sizeof(ThsCookedRecord) * record_count;
+  payload_start = (payload_start + THS_COOKED_ALIGN - 1) &
+                  ~(size_t)(THS_COOKED_ALIGN - 1);
+
+  *size = payload_start + payload_size;
+  uint8_t *blob = tb_alloc_nm_tp(writer->alloc, *size, uint8_t);
+  SDL_memset(blob, 0, *size);
+
+  ThsCookedHeader header = {
+      .magic = THS_COOKED_MAGIC,
+      .version = THS_COOKED_VERSION,
+      .record_count = record_count,
+  };
+  SDL_memcpy(blob, &header, sizeof(header));
+
+  ThsCookedRecord *records = (ThsCookedRecord *)(blob + sizeof(header));
+  for (uint32_t i = 0; i < record_count; ++i) {
+    records[i] = TB_DYN_ARR_AT(writer->records, i);
+    records[i].offset += (uint32_t)payload_start;
+  }
+  SDL_qsort(records, record_count, sizeof(ThsCookedRecord), compare_records);
+
+  if (payload_size > 0) {
+    SDL_memcpy(blob + payload_start, &TB_DYN_ARR_AT(writer->payload, 0),
+               payload_size);
+  }
+  return blob;
+}
+
+bool ths_cooked_writer_save(ThsCookedWriter *writer, const char *path) {
+  size_t size = 0;
+  uint8_t *blob = ths_cooked_writer_finish(writer, &size);
+  FILE *file = fopen(path, "wb");
+  bool ok = file != NULL;
+  if (ok) {
+    ok = fwrite(blob, 1, size, file) == size;
+    fclose(file);
+  }
+  tb_free(writer->alloc, blob);
+  return ok;
+}
+
+static void unbind_cooked_scene(ThsCookedScene *scene) {
+  if (scene->blob) {
+    tb_free(scene->alloc, scene->blob);
+  }
+  ths_unmap_file(&scene->mapped);
+  *scene = (ThsCookedScene){0};
+}
+
+// Points the scene slot at data if it holds a valid blob
+static bool bind_data(ThsCookedScene *scene, const char *source_path,
+                      const uint8_t *data, size_t size) {
+  SDL_strlcpy(scene->source_path, source_path, sizeof(scene->source_path));
+  if (data == NULL) {
+    // Remember that there is no sidecar so we don't look again per node
+    return false;
+  }
+
+  const ThsCookedHeader *header = (const ThsCookedHeader *)data;
+  const bool valid =
+      size >= sizeof(ThsCookedHeader) && header->magic == THS_COOKED_MAGIC &&
+      header->version == THS_COOKED_VERSION &&
+      size >= sizeof(ThsCookedHeader) +
+                  sizeof(ThsCookedRecord) * (size_t)header->record_count;
+  if (!valid) {
+    SDL_Log("Ignoring stale or corrupt cooked components for %s",
+            source_path);
+    return false;
+  }
+
+  scene->data = data;
+  scene->size = size;
+  scene->records = (const ThsCookedRecord *)(data + sizeof(ThsCookedHeader));
+  scene->record_count = header->record_count;
+  return true;
+}
+
+void ths_bind_cooked_components(TbWorld *world, TbAllocator alloc,
+                                const char *source_path, uint8_t *blob,
+                                size_t size) {
+  tb_auto *scene = ecs_singleton_get_mut(world->ecs, ThsCookedScene);
+  unbind_cooked_scene(scene);
+  scene->alloc = alloc;
+  if (bind_data(scene, source_path, blob, size)) {
+    scene->blob = blob;
+  } else if (blob) {
+    tb_free(alloc, blob);
+  }
+}
+
+static void load_sidecar(ThsCookedScene *scene, const char *source_path) {
+  TracyCZoneNC(ctx, "Load Cooked Components", TracyCategoryColorCore, true);
+  char path[512] = {0};
+  SDL_snprintf(path, sizeof(path), "%s%s", source_path, THS_COOKED_EXTENSION);
+
+  unbind_cooked_scene(scene);
+  ThsMappedFile mapped = {0};
+  ths_map_file(path, &mapped);
+  if (bind_data(scene, source_path, mapped.data, mapped.size)) {
+    scene->mapped = mapped;
+  } else {
+    ths_unmap_file(&mapped);
+  }
+  TracyCZoneEnd(ctx);
+}
+
+const void *ths_find_cooked_component(TbWorld *world, const char *source_path,
+                                      const cgltf_node *node,
+                                      const char *type_name, uint32_t size) {
+  if (source_path == NULL || node == NULL || node->name == NULL) {
+    return NULL;
+  }
+  tb_auto *scene = ecs_singleton_get_mut(world->ecs, ThsCookedScene);
+  if (SDL_strcmp(scene->source_path, source_path) != 0) {
+    load_sidecar(scene, source_path);
+  }
+  if (scene->record_count == 0) {
+    return NULL;
+  }
+
+  const ThsCookedRecord key = {
+      .node_hash = ths_cooked_hash(node->name),
+      .type_hash = ths_cooked_hash(type_name),
+  };
+  const ThsCookedRecord *records = scene->records;
+  uint32_t lo = 0;
+  uint32_t hi = scene->record_count;
+  while (lo < hi) {
+    const uint32_t mid = lo + (hi - lo) / 2;
+    const int32_t cmp = compare_records(&records[mid], &key);
+    if (cmp == 0) {
+      const ThsCookedRecord *rec = &records[mid];
+      // A descriptor that changed shape since cooking can't be trusted
+      if (rec->size != size ||
+          (size_t)rec->offset + rec->size > scene->size) {
+        return NULL;
+      }
+      return scene->data + rec->offset;
+    }
+    if (cmp < 0) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  return NULL;
+}
+
+void ths_register_cooked_components_sys(TbWorld *world) {
+  ecs_world_t *ecs = world->ecs;
+  ECS_COMPONENT_DEFINE(ecs, ThsCookedScene);
+  ThsCookedScene scene = {0};
+  ecs_singleton_set_ptr(ecs, ThsCookedScene, &scene);
+}
+
+void ths_unregister_cooked_components_sys(TbWorld *world) {
+  ecs_world_t *ecs = world->ecs;
+  tb_auto *scene = ecs_singleton_get_mut(ecs, ThsCookedScene);
+  unbind_cooked_scene(scene);
+  ecs_singleton_remove(ecs, ThsCookedScene);
+}
+
+TB_REGISTER_SYS(ths, cooked_components, TB_SYSTEM_NORMAL)
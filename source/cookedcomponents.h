@@ -0,0 +1,62 @@
+#pragma once
+
+#include "allocator.h"
+#include "dynarray.h"
+
+typedef struct TbWorld TbWorld;
+typedef struct cgltf_node cgltf_node;
+
+// Component descriptors baked out of glTF extras at cook time
+//
+// A scene `foo.glb` may have a `foo.glb.thsc` sidecar holding one packed
+// descriptor per component bearing node. Records are laid out exactly as the
+// descriptor structs registered with ecs_struct so loaders can copy them
+// instead of walking json
+#define THS_COOKED_MAGIC 0x43534854 // THSC
+#define THS_COOKED_VERSION 1
+#define THS_COOKED_EXTENSION ".thsc"
+
+typedef struct ThsCookedHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t record_count;
+  uint32_t reserved;
+} ThsCookedHeader;
+
+// Records follow the header sorted by node hash then type hash
+typedef struct ThsCookedRecord {
+  uint32_t node_hash; // Hash of the node name
+  uint32_t type_hash; // Hash of the descriptor type name
+  uint32_t offset;    // From the start of the blob
+  uint32_t size;
+} ThsCookedRecord;
+
+uint32_t ths_cooked_hash(const char *str);
+
+typedef struct ThsCookedWriter {
+  TbAllocator alloc;
+  TB_DYN_ARR_OF(ThsCookedRecord) records;
+  TB_DYN_ARR_OF(uint8_t) payload;
+} ThsCookedWriter;
+
+void ths_create_cooked_writer(TbAllocator alloc, ThsCookedWriter *writer);
+void ths_destroy_cooked_writer(ThsCookedWriter *writer);
+void ths_cooked_writer_add(ThsCookedWriter *writer, const char *node_name,
+                           const char *type_name, const void *data,
+                           uint32_t size);
+// Returns a blob allocated from the writer's allocator
+uint8_t *ths_cooked_writer_finish(ThsCookedWriter *writer, size_t *size);
+bool ths_cooked_writer_save(ThsCookedWriter *writer, const char *path);
+
+// Makes a blob the one the world's loaders read from for a given scene.
+// Takes ownership of the blob, which must come from alloc
+void ths_bind_cooked_components(TbWorld *world, TbAllocator alloc,
+                                const char *source_path, uint8_t *blob,
+                                size_t size);
+
+// Finds the cooked descriptor of a node, loading the scene's sidecar into the
+// world on first use. Returns NULL if there is none or if its size doesn't
+// match, in which case the caller should read the json instead
+const void *ths_find_cooked_component(TbWorld *world, const char *source_path,
+                                      const cgltf_node *node,
+                                      const char *type_name, uint32_t size);
@@ -0,0 +1,140 @@
+#include "framememory.h"
+
+#include "profiling.h"
+#include "tbcommon.h"
+
+#include <SDL3/SDL_log.h>
+
+#include <mimalloc.h>
+
+ECS_COMPONENT_DECLARE(ThsScratchArenas);
+
+void ths_create_frame_memory(TbAllocator gp_alloc, size_t frame_size,
+                             size_t scratch_size, ThsFrameMemory *mem) {
+  *mem = (ThsFrameMemory){
+      .gp_alloc = gp_alloc,
+      .scratch_size = scratch_size,
+  };
+  tb_create_arena_alloc("Frame Arena", &mem->front, frame_size);
+  tb_create_arena_alloc("Frame Arena", &mem->back, frame_size);
+  mem->frame_alloc = mem->front.alloc;
+}
+
+static void destroy_scratch(ThsFrameMemory *mem) {
+  for (int32_t i = 0; i < mem->scratch_count; ++i) {
+    tb_destroy_arena_alloc(mem->scratch[i]);
+  }
+  tb_free(mem->gp_alloc, mem->scratch);
+  mem->scratch = NULL;
+  mem->scratch_count = 0;
+}
+
+void ths_destroy_frame_memory(ThsFrameMemory *mem) {
+  destroy_scratch(mem);
+  tb_destroy_arena_alloc(mem->front);
+  tb_destroy_arena_alloc(mem->back);
+  *mem = (ThsFrameMemory){0};
+}
+
+TbAllocator ths_frame_alloc(const ThsFrameMemory *mem) {
+  return mem->frame_alloc;
+}
+
+void ths_attach_frame_memory(ThsFrameMemory *mem, ecs_world_t *ecs) {
+  ECS_COMPONENT_DEFINE(ecs, ThsScratchArenas);
+
+  const int32_t stage_count = ecs_get_stage_count(ecs);
+  if (stage_count > mem->scratch_count) {
+    destroy_scratch(mem);
+    mem->scratch =
+        tb_alloc_nm_tp(mem->gp_alloc, stage_count, TbArenaAllocator);
+    for (int32_t i = 0; i < stage_count; ++i) {
+      tb_create_arena_alloc("Scratch Arena", &mem->scratch[i],
+                            mem->scratch_size);
+    }
+    mem->scratch_count = stage_count;
+  }
+
+  ThsScratchArenas arenas = {.mem = mem};
+  ecs_singleton_set_ptr(ecs, ThsScratchArenas, &arenas);
+}
+
+TbAllocator ths_scratch_alloc(ecs_world_t *ecs) {
+  const tb_auto *arenas = ecs_singleton_get(ecs, ThsScratchArenas);
+  TB_CHECK(arenas && arenas->mem, "Frame memory was never attached");
+  const int32_t stage_id = ecs_get_stage_id(ecs);
+  TB_CHECK(stage_id < arenas->mem->scratch_count, "Missing scratch arena");
+  return arenas->mem->scratch[stage_id].alloc;
+}
+
+void ths_frame_memory_end_frame(ThsFrameMemory *mem) {
+  TracyCZoneNC(ctx, "Frame Memory End Frame", TracyCategoryColorCore, true);
+
+  mem->frame_used = mem->front.size;
+  mem->frame_peak = SDL_max(mem->frame_peak, mem->frame_used);
+  mem->frame_used_total += (double)mem->frame_used;
+
+  mem->scratch_used = 0;
+  for (int32_t i = 0; i < mem->scratch_count; ++i) {
+    mem->scratch_used += mem->scratch[i].size;
+    mem->scratch[i] = tb_reset_arena(mem->scratch[i], true);
+  }
+  mem->scratch_peak = SDL_max(mem->scratch_peak, mem->scratch_used);
+  mem->frame_count++;
+
+  // Whatever was allocated this frame moves to the back and stays valid for
+  // one more frame. What was in the back has been dead for a frame already
+  TbArenaAllocator finished = mem->front;
+  mem->front = mem->back;
+  mem->back = finished;
+  mem->front = tb_reset_arena(mem->front, true);
+
+  TracyCPlot("Frame Arena Bytes", (double)mem->frame_used);
+  TracyCPlot("Frame Arena Peak", (double)mem->frame_peak);
+  TracyCPlot("Scratch Arena Bytes", (double)mem->scratch_used);
+#ifdef TRACY_ENABLE
+  // Not free enough to do every frame when nobody is watching
+  size_t rss = 0;
+  size_t commit = 0;
+  mi_process_info(NULL, NULL, NULL, &rss, NULL, &commit, NULL, NULL);
+  TracyCPlot("Process RSS", (double)rss);
+  TracyCPlot("Process Commit", (double)commit);
+#endif
+
+  TracyCZoneEnd(ctx);
+}
+
+void ths_frame_memory_log_stats(const ThsFrameMemory *mem) {
+  const double mb = 1.0 / (1024.0 * 1024.0);
+  const double frame_avg =
+      mem->frame_count > 0 ? mem->frame_used_total / (double)mem->frame_count
+                           : 0.0;
+
+  SDL_Log("Frame memory after %llu frames:",
+          (unsigned long long)mem->frame_count);
+  SDL_Log("  frame arena   avg %.2f MB  peak %.2f MB  of %.2f MB",
+          frame_avg * mb, (double)mem->frame_peak * mb,
+          (double)mem->front.max_size * mb);
+  SDL_Log("  scratch       peak %.2f MB  across %d arenas of %.2f MB",
+          (double)mem->scratch_peak * mb, mem->scratch_count,
+          (double)mem->scratch_size * mb);
+
+  // The general allocator is backed by mimalloc so its numbers are the
+  // process totals
+  size_t elapsed_ms = 0;
+  size_t user_ms = 0;
+  size_t system_ms = 0;
+  size_t rss = 0;
+  size_t peak_rss = 0;
+  size_t commit = 0;
+  size_t peak_commit = 0;
+  size_t page_faults = 0;
+  mi_process_info(&elapsed_ms, &user_ms, &system_ms, &rss, &peak_rss, &commit,
+                  &peak_commit, &page_faults);
+  SDL_Log("  mimalloc      rss %.2f MB (peak %.2f)", (double)rss * mb,
+          (double)peak_rss * mb);
+  SDL_Log("  mimalloc      commit %.2f MB (peak %.2f)", (double)commit * mb,
+          (double)peak_commit * mb);
+  SDL_Log("  mimalloc      %zu page faults  %zu ms user  %zu ms system",
+          page_faults, user_ms, system_ms);
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "allocator.h"
+
+#include <flecs.h>
+
+#define THS_FRAME_ARENA_COUNT 2
+#define THS_FRAME_ARENA_DEFAULT_SIZE (1024 * 1024 * 256)  // 256 MB
+#define THS_SCRATCH_ARENA_DEFAULT_SIZE (1024 * 1024 * 16) // 16 MB
+
+// Temporary memory for the main loop
+//
+// The frame arena is double buffered: memory from the frame allocator stays
+// valid through the end of the next frame. Each flecs stage also gets its own
+// scratch arena so parallel systems never share a bump pointer
+//
+// The allocator handed out by ths_frame_alloc never changes. Ending a frame
+// swaps which arena sits behind it, so systems that copied the allocator when
+// they were registered follow along. That also means this struct must not
+// move once created
+typedef struct ThsFrameMemory {
+  TbArenaAllocator front; // Allocator handed out lives at this address
+  TbArenaAllocator back;  // Last frame's memory; reset when it swaps back
+  TbAllocator frame_alloc;
+
+  TbAllocator gp_alloc;
+  int32_t scratch_count;
+  TbArenaAllocator *scratch;
+  size_t scratch_size;
+
+  uint64_t frame_count;
+  size_t frame_used;   // Bytes the last frame took from the frame arena
+  size_t frame_peak;   // High water mark of frame_used
+  size_t scratch_used; // Bytes the last frame took from all scratch arenas
+  size_t scratch_peak;
+  double frame_used_total; // For the average in the stats dump
+} ThsFrameMemory;
+
+// Lets systems find the scratch arena of the stage they run on
+typedef struct ThsScratchArenas {
+  ThsFrameMemory *mem;
+} ThsScratchArenas;
+extern ECS_COMPONENT_DECLARE(ThsScratchArenas);
+
+void ths_create_frame_memory(TbAllocator gp_alloc, size_t frame_size,
+                             size_t scratch_size, ThsFrameMemory *mem);
+void ths_destroy_frame_memory(ThsFrameMemory *mem);
+
+TbAllocator ths_frame_alloc(const ThsFrameMemory *mem);
+
+// Makes scratch arenas available to systems of a world. Call after the world's
+// thread count is set so there is one arena per stage
+void ths_attach_frame_memory(ThsFrameMemory *mem, ecs_world_t *ecs);
+
+// Scratch allocator for the calling stage; reset at the end of every frame
+TbAllocator ths_scratch_alloc(ecs_world_t *ecs);
+
+// Records usage, swaps the frame arenas and resets the scratch arenas
+// Must not be called while worker threads are running
+void ths_frame_memory_end_frame(ThsFrameMemory *mem);
+
+// Logs peak arena usage along with mimalloc's view of the process
+void ths_frame_memory_log_stats(const ThsFrameMemory *mem);
@@ -0,0 +1,229 @@
+#include "headless.h"
+
+#include "boatmovementcomponent.h"
+#include "framememory.h"
+#include "inputreplay.h"
+#include "profiler.h"
+#include "profiling.h"
+#include "simulation.h"
+#include "simworld.h"
+#include "tbcommon.h"
+#include "transformcomponent.h"
+
+#include <SDL3/SDL.h>
+
+#define THS_HEADLESS_DEFAULT_FRAMES 3600
+#define THS_HEADLESS_DEFAULT_BOATS 100
+
+typedef struct ThsHeadlessOptions {
+  uint32_t frames;
+  float duration;
+  uint32_t boats;
+  int32_t threads;
+} ThsHeadlessOptions;
+
+bool ths_is_headless(int32_t argc, char *argv[]) {
+  for (int32_t i = 1; i < argc; ++i) {
+    if (SDL_strcmp(argv[i], "--headless") == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+static ThsHeadlessOptions parse_options(int32_t argc, char *argv[],
+                                        const ThsInputReplay *replay) {
+  ThsHeadlessOptions opts = {
+      .boats = THS_HEADLESS_DEFAULT_BOATS,
+  };
+  for (int32_t i = 1; i < argc - 1; ++i) {
+    const char *arg = argv[i];
+    const char *value = argv[i + 1];
+    if (SDL_strcmp(arg, "--frames") == 0) {
+      opts.frames = (uint32_t)SDL_strtoul(value, NULL, 10);
+    } else if (SDL_strcmp(arg, "--duration") == 0) {
+      opts.duration = (float)SDL_atof(value);
+    } else if (SDL_strcmp(arg, "--boats") == 0) {
+      opts.boats = (uint32_t)SDL_strtoul(value, NULL, 10);
+    } else if (SDL_strcmp(arg, "--threads") == 0) {
+      opts.threads = SDL_atoi(value);
+    }
+  }
+  if (opts.frames == 0 && opts.duration <= 0.0f) {
+    // A replay runs for as long as the recording unless told otherwise
+    opts.frames = replay->mode == THS_INPUT_REPLAY
+                      ? replay->frame_count
+                      : THS_HEADLESS_DEFAULT_FRAMES;
+  }
+  return opts;
+}
+
+#define FNV_OFFSET_BASIS 0xcbf29ce484222325ull
+#define FNV_PRIME 0x100000001b3ull
+
+static uint64_t hash_bytes(uint64_t hash, const void *data, size_t size) {
+  const uint8_t *bytes = (const uint8_t *)data;
+  for (size_t i = 0; i < size; ++i) {
+    hash = (hash ^ bytes[i]) * FNV_PRIME;
+  }
+  return hash;
+}
+
+// Folds where every boat is this frame into the hash. Two runs that end
+// with the same hash took the same path step for step
+static uint64_t hash_boats(ecs_world_t *ecs, ecs_query_t *query,
+                           uint64_t hash) {
+  ecs_iter_t it = ecs_query_iter(ecs, query);
+  while (ecs_iter_next(&it)) {
+    // Hulls in a table share a boat
+    const tb_auto *boat = ecs_field(&it, TbTransformComponent, 2);
+    const TbTransform *t = &boat->transform;
+    hash = hash_bytes(hash, &t->position, sizeof(float) * 3);
+    hash = hash_bytes(hash, &t->rotation, sizeof(t->rotation));
+  }
+  return hash;
+}
+
+static int32_t compare_floats(const void *a, const void *b) {
+  const float fa = *(const float *)a;
+  const float fb = *(const float *)b;
+  return (fa > fb) - (fa < fb);
+}
+
+static float percentile(const float *sorted, uint32_t count, float pct) {
+  uint32_t idx = (uint32_t)((float)(count - 1) * pct);
+  return sorted[idx];
+}
+
+static void log_frame_summary(float *frame_ms, uint32_t count,
+                              double total_secs) {
+  if (count == 0) {
+    SDL_Log("Headless: no frames were simulated");
+    return;
+  }
+  double sum = 0.0;
+  for (uint32_t i = 0; i < count; ++i) {
+    sum += frame_ms[i];
+  }
+  SDL_qsort(frame_ms, count, sizeof(float), compare_floats);
+
+  SDL_Log("Headless: %u frames in %.2fs (%.1f fps)", count, total_secs,
+          (double)count / total_secs);
+  SDL_Log("Frame ms: mean %.3f | p50 %.3f | p90 %.3f | p95 %.3f | p99 %.3f | "
+          "max %.3f",
+          sum / count, (double)percentile(frame_ms, count, 0.50f),
+          (double)percentile(frame_ms, count, 0.90f),
+          (double)percentile(frame_ms, count, 0.95f),
+          (double)percentile(frame_ms, count, 0.99f),
+          (double)frame_ms[count - 1]);
+}
+
+int32_t ths_run_headless(int32_t argc, char *argv[], TbAllocator gp_alloc,
+                         ThsFrameMemory *frame_mem) {
+  ThsInputReplay replay = {0};
+  if (!ths_input_replay_configure(&replay, argc, argv)) {
+    return 1;
+  }
+  const ThsHeadlessOptions opts = parse_options(argc, argv, &replay);
+
+  TbWorld world = {0};
+  {
+    ThsSimWorldDesc desc = {
+        .gp_alloc = gp_alloc,
+        .frame_mem = frame_mem,
+        .thread_count = opts.threads,
+    };
+    if (!ths_create_sim_world(&desc, &world)) {
+      SDL_Log("Headless: failed to create simulation world");
+      ths_input_replay_finish(&replay);
+      return 1;
+    }
+  }
+
+  ths_sim_configure(world.ecs, argc, argv);
+  const float sim_step = ecs_singleton_get(world.ecs, ThsSimClock)->step;
+
+  ths_spawn_sim_ocean(&world);
+  ThsFleetDesc fleet = {
+      .boat_count = opts.boats,
+      .spacing = 20.0f,
+      // Recorded input needs a boat to steer
+      .with_player = replay.mode != THS_INPUT_LIVE,
+  };
+  ths_spawn_fleet(&world, &fleet);
+
+  // Only replays and recordings pay for hashing the trajectory
+  const bool track_trajectory = replay.mode != THS_INPUT_LIVE;
+  uint64_t trajectory = FNV_OFFSET_BASIS;
+  ecs_query_t *boat_query = NULL;
+  if (track_trajectory) {
+    boat_query = ecs_query(
+        world.ecs, {.filter.terms = {
+                        {.id = ecs_id(ThsBoatMovementComponent),
+                         .inout = EcsIn},
+                        {.id = ecs_id(TbTransformComponent),
+                         .inout = EcsIn,
+                         .src.flags = EcsUp,
+                         .src.trav = EcsChildOf},
+                    }});
+  }
+
+  SDL_Log("Headless: simulating %u boats", opts.boats);
+
+  TB_DYN_ARR_OF(float) frame_ms = {0};
+  TB_DYN_ARR_RESET(frame_ms, gp_alloc, opts.frames > 0 ? opts.frames : 4096);
+
+  const double freq = (double)SDL_GetPerformanceFrequency();
+  const uint64_t start_time = SDL_GetPerformanceCounter();
+  uint64_t last_time = start_time;
+
+  while (true) {
+    const double elapsed = (double)(last_time - start_time) / freq;
+    if (opts.frames > 0 && TB_DYN_ARR_SIZE(frame_ms) >= opts.frames) {
+      break;
+    }
+    if (opts.duration > 0.0f && elapsed >= (double)opts.duration) {
+      break;
+    }
+
+    // Every frame is exactly one simulation step so runs are repeatable no
+    // matter how fast the machine is
+    TracyCFrameMarkStart("Simulation Frame");
+    const float delta = ths_input_replay_frame(&replay, world.ecs, sim_step);
+    if (ths_input_replay_done(&replay)) {
+      TracyCFrameMarkEnd("Simulation Frame");
+      break;
+    }
+    ths_sim_advance(world.ecs, delta);
+    if (track_trajectory) {
+      trajectory = hash_boats(world.ecs, boat_query, trajectory);
+    }
+    ths_frame_memory_end_frame(frame_mem);
+    ths_profiler_end_frame();
+    TracyCFrameMarkEnd("Simulation Frame");
+
+    const uint64_t now = SDL_GetPerformanceCounter();
+    const float ms = (float)((double)(now - last_time) / freq) * 1000.0f;
+    last_time = now;
+
+    TB_DYN_ARR_APPEND(frame_ms, ms);
+  }
+
+  const double total_secs = (double)(last_time - start_time) / freq;
+  log_frame_summary(&TB_DYN_ARR_AT(frame_ms, 0),
+                    (uint32_t)TB_DYN_ARR_SIZE(frame_ms), total_secs);
+
+  if (track_trajectory) {
+    SDL_Log("Headless: trajectory hash %016llx",
+            (unsigned long long)trajectory);
+    ecs_query_fini(boat_query);
+  }
+  ths_input_replay_finish(&replay);
+
+  ths_profiler_finish();
+  ths_frame_memory_log_stats(frame_mem);
+
+  TB_DYN_ARR_DESTROY(frame_ms);
+  ths_destroy_sim_world(&world);
+  return 0;
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include "allocator.h"
+
+typedef struct ThsFrameMemory ThsFrameMemory;
+
+// Returns true if the command line asks for a headless run
+bool ths_is_headless(int32_t argc, char *argv[]);
+
+// Runs the game simulation without a window or GPU until the requested
+// frame count or duration is reached, then logs frame time percentiles
+//
+// Options:
+//   --frames <n>      Stop after n frames
+//   --duration <sec>  Stop after this many seconds of wall time
+//   --boats <n>       Number of boats to simulate (default 100)
+//   --threads <n>     Worker thread count (default one per core)
+//   --sim-rate <hz>   Fixed simulation rate; each frame is one step
+//   --record-input <path>  Record the input of every frame to a file
+//   --replay-input <path>  Play a recording back instead of live input. Runs
+//                          for the length of the recording unless --frames
+//                          or --duration is given
+//
+// Recording or replaying steers the first boat with the input and logs a
+// hash of every boat's trajectory, which matches between runs that
+// simulated the same thing
+int32_t ths_run_headless(int32_t argc, char *argv[], TbAllocator gp_alloc,
+                         ThsFrameMemory *frame_mem);
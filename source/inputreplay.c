@@ -0,0 +1,225 @@
+#include "inputreplay.h"
+
+#include "profiling.h"
+#include "tbcommon.h"
+
+#include <SDL3/SDL.h>
+
+// Only the part of the input system the simulation reads is recorded
+#define KEYBOARD_SIZE sizeof(((TbInputSystem *)0)->keyboard)
+#define MOUSE_SIZE sizeof(((TbInputSystem *)0)->mouse)
+#define GAMEPAD_SIZE sizeof(((TbInputSystem *)0)->gamepad_states[0])
+#define MAX_GAMEPADS                                                           \
+  (sizeof(((TbInputSystem *)0)->gamepad_states) / GAMEPAD_SIZE)
+
+static bool open_recording(ThsInputReplay *replay, const char *path) {
+  replay->out = fopen(path, "wb");
+  if (replay->out == NULL) {
+    SDL_Log("Input: failed to open %s for recording", path);
+    return false;
+  }
+  // Frame count is filled in once recording finishes
+  const ThsInputFileHeader header = {
+      .magic = THS_INPUT_MAGIC,
+      .version = THS_INPUT_VERSION,
+      .keyboard_size = (uint32_t)KEYBOARD_SIZE,
+      .mouse_size = (uint32_t)MOUSE_SIZE,
+      .gamepad_size = (uint32_t)GAMEPAD_SIZE,
+  };
+  if (fwrite(&header, sizeof(header), 1, replay->out) != 1) {
+    SDL_Log("Input: failed to write %s", path);
+    fclose(replay->out);
+    replay->out = NULL;
+    return false;
+  }
+  replay->mode = THS_INPUT_RECORD;
+  // Forces the first frame to store everything
+  replay->delta = -1.0f;
+  SDL_memset(&replay->input, 0xFF, sizeof(replay->input));
+  SDL_Log("Input: recording to %s", path);
+  return true;
+}
+
+static bool open_replay(ThsInputReplay *replay, const char *path) {
+  if (!ths_map_file(path, &replay->in)) {
+    SDL_Log("Input: failed to open %s for replay", path);
+    return false;
+  }
+  const ThsInputFileHeader *header =
+      (const ThsInputFileHeader *)replay->in.data;
+  if (replay->in.size < sizeof(*header) ||
+      header->magic != THS_INPUT_MAGIC ||
+      header->version != THS_INPUT_VERSION) {
+    SDL_Log("Input: %s is not an input recording", path);
+    ths_unmap_file(&replay->in);
+    return false;
+  }
+  if (header->keyboard_size != KEYBOARD_SIZE ||
+      header->mouse_size != MOUSE_SIZE ||
+      header->gamepad_size != GAMEPAD_SIZE) {
+    SDL_Log("Input: %s was recorded by an incompatible build", path);
+    ths_unmap_file(&replay->in);
+    return false;
+  }
+  replay->mode = THS_INPUT_REPLAY;
+  replay->frame_count = header->frame_count;
+  replay->read_offset = sizeof(*header);
+  SDL_Log("Input: replaying %u frames from %s", replay->frame_count, path);
+  return true;
+}
+
+bool ths_input_replay_configure(ThsInputReplay *replay, int32_t argc,
+                                char *argv[]) {
+  *replay = (ThsInputReplay){0};
+  for (int32_t i = 1; i < argc - 1; ++i) {
+    if (SDL_strcmp(argv[i], "--record-input") == 0) {
+      return open_recording(replay, argv[i + 1]);
+    }
+    if (SDL_strcmp(argv[i], "--replay-input") == 0) {
+      return open_replay(replay, argv[i + 1]);
+    }
+  }
+  return true;
+}
+
+static bool gamepads_equal(const TbInputSystem *a, const TbInputSystem *b) {
+  return a->gamepad_count == b->gamepad_count &&
+         SDL_memcmp(a->gamepad_states, b->gamepad_states,
+                    GAMEPAD_SIZE * a->gamepad_count) == 0;
+}
+
+static void record_frame(ThsInputReplay *replay, const TbInputSystem *input,
+                         float delta) {
+  const uint32_t gamepad_count =
+      SDL_min((uint32_t)input->gamepad_count, (uint32_t)MAX_GAMEPADS);
+
+  uint8_t flags = 0;
+  if (delta != replay->delta) {
+    flags |= THS_INPUT_FRAME_DELTA;
+  }
+  if (SDL_memcmp(&input->keyboard, &replay->input.keyboard, KEYBOARD_SIZE) ||
+      SDL_memcmp(&input->mouse, &replay->input.mouse, MOUSE_SIZE) ||
+      !gamepads_equal(input, &replay->input)) {
+    flags |= THS_INPUT_FRAME_INPUT;
+  }
+
+  FILE *out = replay->out;
+  bool ok = fwrite(&flags, sizeof(flags), 1, out) == 1;
+  if (flags & THS_INPUT_FRAME_DELTA) {
+    ok = ok && fwrite(&delta, sizeof(delta), 1, out) == 1;
+    replay->delta = delta;
+  }
+  if (flags & THS_INPUT_FRAME_INPUT) {
+    const uint8_t count = (uint8_t)gamepad_count;
+    ok = ok && fwrite(&input->keyboard, KEYBOARD_SIZE, 1, out) == 1;
+    ok = ok && fwrite(&input->mouse, MOUSE_SIZE, 1, out) == 1;
+    ok = ok && fwrite(&count, sizeof(count), 1, out) == 1;
+    if (count > 0) {
+      ok = ok && fwrite(input->gamepad_states, GAMEPAD_SIZE, count, out) ==
+                     count;
+    }
+    replay->input.keyboard = input->keyboard;
+    replay->input.mouse = input->mouse;
+    replay->input.gamepad_count = input->gamepad_count;
+    SDL_memcpy(replay->input.gamepad_states, input->gamepad_states,
+               GAMEPAD_SIZE * count);
+  }
+  if (!ok) {
+    SDL_Log("Input: failed to write frame %u; recording stopped",
+            replay->frame);
+    ths_input_replay_finish(replay);
+    return;
+  }
+  replay->frame++;
+}
+
+static bool read_bytes(ThsInputReplay *replay, void *dst, size_t size) {
+  if (replay->read_offset + size > replay->in.size) {
+    return false;
+  }
+  SDL_memcpy(dst, replay->in.data + replay->read_offset, size);
+  replay->read_offset += size;
+  return true;
+}
+
+static bool replay_frame(ThsInputReplay *replay, TbInputSystem *input) {
+  uint8_t flags = 0;
+  if (replay->frame >= replay->frame_count ||
+      !read_bytes(replay, &flags, sizeof(flags))) {
+    return false;
+  }
+  if ((flags & THS_INPUT_FRAME_DELTA) &&
+      !read_bytes(replay, &replay->delta, sizeof(replay->delta))) {
+    return false;
+  }
+  if (flags & THS_INPUT_FRAME_INPUT) {
+    uint8_t count = 0;
+    if (!read_bytes(replay, &replay->input.keyboard, KEYBOARD_SIZE) ||
+        !read_bytes(replay, &replay->input.mouse, MOUSE_SIZE) ||
+        !read_bytes(replay, &count, sizeof(count)) || count > MAX_GAMEPADS ||
+        !read_bytes(replay, replay->input.gamepad_states,
+                    GAMEPAD_SIZE * count)) {
+      return false;
+    }
+    replay->input.gamepad_count = count;
+  }
+
+  input->keyboard = replay->input.keyboard;
+  input->mouse = replay->input.mouse;
+  input->gamepad_count = replay->input.gamepad_count;
+  SDL_memcpy(input->gamepad_states, replay->input.gamepad_states,
+             GAMEPAD_SIZE * replay->input.gamepad_count);
+  replay->frame++;
+  return true;
+}
+
+float ths_input_replay_frame(ThsInputReplay *replay, ecs_world_t *ecs,
+                             float delta) {
+  if (replay->mode == THS_INPUT_LIVE) {
+    return delta;
+  }
+  TracyCZoneNC(ctx, "Input Replay Frame", TracyCategoryColorCore, true);
+  tb_auto *input = ecs_singleton_get_mut(ecs, TbInputSystem);
+
+  if (replay->mode == THS_INPUT_RECORD) {
+    record_frame(replay, input, delta);
+  } else if (replay_frame(replay, input)) {
+    delta = replay->delta;
+  } else {
+    if (replay->frame < replay->frame_count) {
+      SDL_Log("Input: recording ends early after frame %u", replay->frame);
+    }
+    SDL_Log("Input: replay finished after %u frames", replay->frame);
+    ths_unmap_file(&replay->in);
+    replay->mode = THS_INPUT_LIVE;
+    replay->frame_count = replay->frame;
+  }
+
+  TracyCZoneEnd(ctx);
+  return delta;
+}
+
+bool ths_input_replay_done(const ThsInputReplay *replay) {
+  return replay->frame_count > 0 && replay->mode == THS_INPUT_LIVE;
+}
+
+void ths_input_replay_finish(ThsInputReplay *replay) {
+  if (replay->out) {
+    // Patch the frame count into the header now that it is known
+    const size_t offset = offsetof(ThsInputFileHeader, frame_count);
+    bool ok = fseek(replay->out, (long)offset, SEEK_SET) == 0 &&
+              fwrite(&replay->frame, sizeof(replay->frame), 1, replay->out) ==
+                  1;
+    ok = fclose(replay->out) == 0 && ok;
+    if (ok) {
+      SDL_Log("Input: recorded %u frames", replay->frame);
+    } else {
+      SDL_Log("Input: failed to finish the recording");
+    }
+    replay->out = NULL;
+  }
+  if (replay->mode == THS_INPUT_REPLAY) {
+    ths_unmap_file(&replay->in);
+  }
+  replay->mode = THS_INPUT_LIVE;
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "inputsystem.h"
+#include "mappedfile.h"
+
+#include <flecs.h>
+
+#include <stdio.h>
+
+// Records the input the simulation reads every frame along with the frame's
+// delta, and plays a recording back in place of devices
+//
+// With a fixed step, or in a headless run where every frame is one step,
+// replaying a recording simulates exactly the same steps with exactly the
+// same input so boats follow bit identical paths. That makes a recorded
+// session usable as a repeatable workload when comparing builds
+//
+// Files start with a ThsInputFileHeader followed by one record per frame:
+// a byte of THS_INPUT_FRAME_* flags, then the delta as a float if it
+// changed, then the keyboard, mouse, gamepad count and gamepad states if
+// any of them changed. Frames where nothing changed are a single byte
+
+#define THS_INPUT_MAGIC 0x49534854 // 'THSI'
+#define THS_INPUT_VERSION 1
+
+#define THS_INPUT_FRAME_DELTA 0x1
+#define THS_INPUT_FRAME_INPUT 0x2
+
+typedef enum ThsInputReplayMode {
+  THS_INPUT_LIVE,
+  THS_INPUT_RECORD,
+  THS_INPUT_REPLAY,
+} ThsInputReplayMode;
+
+typedef struct ThsInputFileHeader {
+  uint32_t magic;
+  uint32_t version;
+  // Input structs are stored as they are laid out in memory so only builds
+  // where these sizes match can replay the file
+  uint32_t keyboard_size;
+  uint32_t mouse_size;
+  uint32_t gamepad_size;
+  uint32_t frame_count;
+} ThsInputFileHeader;
+
+typedef struct ThsInputReplay {
+  ThsInputReplayMode mode;
+  uint32_t frame;       // Frames recorded or played back so far
+  uint32_t frame_count; // Frames in the recording being played back
+
+  FILE *out;
+  ThsMappedFile in;
+  size_t read_offset;
+
+  // What the last frame recorded or played back held
+  float delta;
+  TbInputSystem input;
+} ThsInputReplay;
+
+// Applies --record-input <path> and --replay-input <path>. Returns false if
+// the file couldn't be opened or can't be replayed by this build
+bool ths_input_replay_configure(ThsInputReplay *replay, int32_t argc,
+                                char *argv[]);
+
+// Call once per frame right before the simulation advances. Records what
+// the simulation is about to read, or replaces it with the next recorded
+// frame. Returns the delta the frame should advance by
+float ths_input_replay_frame(ThsInputReplay *replay, ecs_world_t *ecs,
+                             float delta);
+
+// True once a recording has been played back to its end. Input is live again
+// from then on
+bool ths_input_replay_done(const ThsInputReplay *replay);
+
+// Finishes writing a recording and closes any file
+void ths_input_replay_finish(ThsInputReplay *replay);
@@ -1,15 +1,19 @@
 #include "config.h"
+#include "framememory.h"
+#include "headless.h"
+#include "inputreplay.h"
+#include "profiler.h"
+#include "simulation.h"
 #include "tbcommon.h"
 #include "tbvk.h"
 #include "tbvma.h"
+#include "vlog.h"
 #include "world.h"
 
 #include <SDL3/SDL_main.h>
+#include <flecs.h>
 
 int32_t main(int32_t argc, char *argv[]) {
-  (void)argc;
-  (void)argv;
-
   {
     const char *app_info = TB_APP_INFO_STR;
     size_t app_info_len = SDL_strlen(app_info);
@@ -18,18 +22,34 @@ int32_t main(int32_t argc, char *argv[]) {
     TracyCSetThreadName("Main Thread");
   }
 
-  // Create Temporary Arena Allocator
-  TbArenaAllocator arena = {0};
-  {
-    const size_t arena_alloc_size = 1024 * 1024 * 512; // 512 MB
-    tb_create_arena_alloc("Main Arena", &arena, arena_alloc_size);
-  }
-
   TbGeneralAllocator gp_alloc = {0};
   tb_create_gen_alloc(&gp_alloc, "gp_alloc");
 
+  // Create double buffered temporary arenas; see framememory.h
+  ThsFrameMemory frame_mem = {0};
+  ths_create_frame_memory(gp_alloc.alloc, THS_FRAME_ARENA_DEFAULT_SIZE,
+                          THS_SCRATCH_ARENA_DEFAULT_SIZE, &frame_mem);
+
   TbAllocator std_alloc = gp_alloc.alloc;
-  TbAllocator tmp_alloc = arena.alloc;
+  TbAllocator tmp_alloc = ths_frame_alloc(&frame_mem);
+
+  // Off unless --profile or --profile-csv is passed
+  ths_profiler_configure(argc, argv);
+  // Every vlog category starts off unless --vlog names it
+  ths_vlog_configure(argc, argv);
+
+  // Simulation only; no window, Vulkan or ImGui
+  if (ths_is_headless(argc, argv)) {
+    if (SDL_Init(SDL_INIT_TIMER) != 0) {
+      SDL_Log("Failed to initialize SDL with error: %s", SDL_GetError());
+      return -1;
+    }
+    int32_t res = ths_run_headless(argc, argv, std_alloc, &frame_mem);
+    SDL_Quit();
+    ths_destroy_frame_memory(&frame_mem);
+    tb_destroy_gen_alloc(gp_alloc);
+    return res;
+  }
 
   {
     int32_t res = SDL_Init(SDL_INIT_VIDEO | SDL_INIT_TIMER | SDL_INIT_GAMEPAD |
@@ -70,6 +90,20 @@ int32_t main(int32_t argc, char *argv[]) {
     return 1;
   }
 
+  // Give multi threaded systems a worker per core
+  ecs_set_threads(world.ecs, SDL_GetCPUCount());
+  ths_attach_frame_memory(&frame_mem, world.ecs);
+
+  ths_sim_configure(world.ecs, argc, argv);
+
+  ThsInputReplay replay = {0};
+  if (!ths_input_replay_configure(&replay, argc, argv)) {
+    return 1;
+  }
+
+  const ThsProfileTrack frame_track = ths_profiler_track("Frame");
+  const ThsProfileTrack world_track = ths_profiler_track("World Tick");
+
   // Load first scene
   tb_load_scene(&world, "scenes/mainmenu.glb");
 
@@ -86,6 +120,7 @@ int32_t main(int32_t argc, char *argv[]) {
     TracyCFrameMarkStart("Simulation Frame");
     TracyCZoneN(trcy_ctx, "Simulation Frame", true);
     TracyCZoneColor(trcy_ctx, TracyCategoryColorCore);
+    ThsProfileScope frame_prof = ths_profile_begin(frame_track);
 
     // Use SDL High Performance Counter to get timing info
     time = SDL_GetPerformanceCounter() - start_time;
@@ -94,21 +129,36 @@ int32_t main(int32_t argc, char *argv[]) {
         (float)((double)delta_time / (double)SDL_GetPerformanceFrequency());
     last_time = time;
 
+    // Step the game simulation at its fixed rate; rendering sees transforms
+    // blended between the last two steps. A replay substitutes the recorded
+    // input and frame time so the same steps run
+    ths_sim_advance(world.ecs, ths_input_replay_frame(&replay, world.ecs,
+                                                      delta_time_seconds));
+
     // Tick the world
+    ThsProfileScope world_prof = ths_profile_begin(world_track);
     if (!tb_tick_world(&world, delta_time_seconds)) {
       running = false;
       TracyCZoneEnd(trcy_ctx);
       TracyCFrameMarkEnd("Simulation Frame");
       break;
     }
+    ths_profile_end(world_prof);
 
-    // Reset the arena allocator
-    arena = tb_reset_arena(arena, true); // Just allow it to grow for now
+    // Arenas still grow when they overflow; the stats show by how much
+    ths_frame_memory_end_frame(&frame_mem);
+
+    ths_profile_end(frame_prof);
+    ths_profiler_end_frame();
 
     TracyCZoneEnd(trcy_ctx);
     TracyCFrameMarkEnd("Simulation Frame");
   }
 
+  ths_input_replay_finish(&replay);
+  ths_profiler_finish();
+  ths_frame_memory_log_stats(&frame_mem);
+
   return 0;
 
   // This doesn't quite work yet
@@ -118,7 +168,7 @@ int32_t main(int32_t argc, char *argv[]) {
 
   SDL_Quit();
 
-  tb_destroy_arena_alloc(arena);
+  ths_destroy_frame_memory(&frame_mem);
   tb_destroy_gen_alloc(gp_alloc);
 
   return 0;
@@ -1,18 +1,63 @@
 #include "mainmenu.h"
 
 #include "imguisystem.h"
+#include "profiler.h"
 #include "profiling.h"
+#include "savegame.h"
+#include "sceneloader.h"
 #include "tbcommon.h"
 #include "tbimgui.h"
 #include "world.h"
 
 #include <flecs.h>
 
+#include <time.h>
+
 #include "gamestate.h"
 
 ECS_SYSTEM_DECLARE(main_menu_tick);
 
+#define THS_NEW_GAME_SCENE "scenes/boat2.glb"
+
 TbWorld *mm_world = NULL;
+static bool show_load_dialog = false;
+
+// Reads the save and starts loading the scene it was made in. The save is
+// applied once the scene has been instantiated
+static void load_save_slot(ThsSaveSystem *save, ThsSceneLoader *loader,
+                           const char *slot) {
+  const char *scene = ths_load_save(save, slot);
+  if (scene) {
+    show_load_dialog = false;
+    ths_request_scene(loader, scene);
+  }
+}
+
+static void load_game_dialog(ThsSaveSystem *save, ThsSceneLoader *loader) {
+  if (!igBegin("Load Game", &show_load_dialog,
+               ImGuiWindowFlags_NoResize | ImGuiWindowFlags_AlwaysAutoResize)) {
+    igEnd();
+    return;
+  }
+  if (save->slot_count == 0) {
+    igText("%s", "No saved games");
+  }
+  for (uint32_t i = 0; i < save->slot_count; ++i) {
+    const tb_auto *info = &save->slots[i];
+    char saved_at[64] = {0};
+    time_t t = (time_t)info->saved_at;
+    strftime(saved_at, sizeof(saved_at), "%Y-%m-%d %H:%M", localtime(&t));
+
+    igPushID_Int((int32_t)i);
+    if (igButton("Load", (ImVec2){0, 0})) {
+      load_save_slot(save, loader, info->slot);
+    }
+    igSameLine(0, -1);
+    igText("%s - %s (%s)", info->slot, saved_at, info->scene);
+    igPopID();
+  }
+  igEnd();
+}
 
 void main_menu_tick(ecs_iter_t *it) {
   ecs_world_t *ecs = it->world;
@@ -28,6 +73,27 @@ void main_menu_tick(ecs_iter_t *it) {
   TbImGuiSystem *ui = ecs_singleton_get_mut(ecs, TbImGuiSystem);
   TB_CHECK(ui, "Unexpectedly missing UI system");
 
+  // Most players pick New Game so start reading it while they decide
+  tb_auto *loader = ecs_singleton_get_mut(ecs, ThsSceneLoader);
+  ths_prefetch_scene(loader, THS_NEW_GAME_SCENE);
+
+  {
+    ecs_defer_suspend(ecs);
+    bool switched = ths_scene_loader_commit(loader, mm_world);
+    if (switched) {
+      // A save being loaded goes on top of the scene's initial state.
+      // Clearing the world may have moved the singleton, so fetch it after
+      tb_auto *save = ecs_singleton_get_mut(ecs, ThsSaveSystem);
+      ths_restore_pending_save(save, ecs);
+    }
+    ecs_defer_resume(ecs);
+    if (switched) {
+      return;
+    }
+  }
+
+  tb_auto *save = ecs_singleton_get_mut(ecs, ThsSaveSystem);
+
   if (ui->context_count == 0) {
     return;
   }
@@ -41,7 +107,18 @@ void main_menu_tick(ecs_iter_t *it) {
     igSetNextWindowPos(
         (ImVec2){io->DisplaySize.x * 0.5f, io->DisplaySize.y * 0.5f},
         ImGuiCond_Always, (ImVec2){0.5f, 0.5f});
-    if (igBegin("The High Seas", NULL,
+    if (loader->commit_pending) {
+      // Loading screen until the scene is ready to instantiate
+      if (igBegin("Loading", NULL,
+                  ImGuiWindowFlags_NoTitleBar | ImGuiWindowFlags_NoResize |
+                      ImGuiWindowFlags_NoMove |
+                      ImGuiWindowFlags_AlwaysAutoResize)) {
+        igText("%s", "Loading...");
+        igProgressBar(ths_scene_load_progress(loader), (ImVec2){200, 0}, NULL);
+      }
+      // ImGui wants End whether or not Begin returned true
+      igEnd();
+    } else if (igBegin("The High Seas", NULL,
                 ImGuiWindowFlags_NoTitleBar | ImGuiWindowFlags_NoResize |
                     ImGuiWindowFlags_NoMove | ImGuiWindowFlags_NoScrollbar |
                     ImGuiWindowFlags_AlwaysAutoResize)) {
@@ -59,18 +136,22 @@ void main_menu_tick(ecs_iter_t *it) {
         igBeginGroup();
         if (igButton("Continue", size)) {
           // Load the latest available save if possible
+          ths_scan_saves(save);
+          if (save->slot_count > 0) {
+            load_save_slot(save, loader, save->slots[0].slot);
+          }
         }
         igNewLine();
         if (igButton("New Game", size)) {
-          // Fade to back and begin new game
-          ecs_defer_suspend(ecs);
-          tb_clear_world(mm_world);
-          tb_load_scene(mm_world, "scenes/boat2.glb");
-          ecs_defer_resume(ecs);
+          // Show the loading screen; the switch happens once the scene is
+          // resident
+          ths_request_scene(loader, THS_NEW_GAME_SCENE);
         }
         igNewLine();
         if (igButton("Load Game", size)) {
           // Show load game dialog
+          ths_scan_saves(save);
+          show_load_dialog = true;
         }
         igNewLine();
         if (igButton("Settings", size)) {
@@ -80,12 +161,23 @@ void main_menu_tick(ecs_iter_t *it) {
         if (igButton("Exit", size)) {
           exit(0);
         }
+        igNewLine();
+        bool profiling = ths_profiler_enabled();
+        if (igCheckbox("Profiler", &profiling)) {
+          ths_profiler_set_enabled(profiling);
+        }
         igEndGroup();
       }
 
       igNewLine();
 
       igEnd();
+
+      if (show_load_dialog) {
+        load_game_dialog(save, loader);
+      }
+    } else {
+      igEnd();
     }
 
     TracyCZoneEnd(ctx);
@@ -0,0 +1,112 @@
+#include "mappedfile.h"
+
+#include <SDL3/SDL_log.h>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#define THS_PAGE_SIZE 4096
+
+#ifdef _WIN32
+
+bool ths_map_file(const char *path, ThsMappedFile *file) {
+  *file = (ThsMappedFile){0};
+  HANDLE handle = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL,
+                              OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+  if (handle == INVALID_HANDLE_VALUE) {
+    return false;
+  }
+  LARGE_INTEGER size = {0};
+  if (!GetFileSizeEx(handle, &size) || size.QuadPart == 0) {
+    CloseHandle(handle);
+    return false;
+  }
+  HANDLE mapping = CreateFileMappingA(handle, NULL, PAGE_READONLY, 0, 0, NULL);
+  if (mapping == NULL) {
+    CloseHandle(handle);
+    return false;
+  }
+  const void *view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+  if (view == NULL) {
+    CloseHandle(mapping);
+    CloseHandle(handle);
+    return false;
+  }
+  *file = (ThsMappedFile){
+      .data = view,
+      .size = (size_t)size.QuadPart,
+      .file = handle,
+      .mapping = mapping,
+  };
+  return true;
+}
+
+void ths_unmap_file(ThsMappedFile *file) {
+  if (file->data) {
+    UnmapViewOfFile(file->data);
+    CloseHandle(file->mapping);
+    CloseHandle(file->file);
+  }
+  *file = (ThsMappedFile){0};
+}
+
+#else
+
+bool ths_map_file(const char *path, ThsMappedFile *file) {
+  *file = (ThsMappedFile){.fd = -1};
+  int32_t fd = open(path, O_RDONLY);
+  if (fd < 0) {
+    return false;
+  }
+  struct stat st = {0};
+  if (fstat(fd, &st) != 0 || st.st_size == 0) {
+    close(fd);
+    return false;
+  }
+  void *view = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  if (view == MAP_FAILED) {
+    SDL_Log("Failed to map %s", path);
+    close(fd);
+    return false;
+  }
+  // glbs are parsed front to back
+  madvise(view, (size_t)st.st_size, MADV_SEQUENTIAL);
+  *file = (ThsMappedFile){
+      .data = view,
+      .size = (size_t)st.st_size,
+      .fd = fd,
+  };
+  return true;
+}
+
+void ths_unmap_file(ThsMappedFile *file) {
+  if (file->data) {
+    munmap((void *)file->data, file->size);
+    close(file->fd);
+  }
+  *file = (ThsMappedFile){.fd = -1};
+}
+
+#endif
+
+void ths_prefault_mapped_file(const ThsMappedFile *file, size_t offset,
+                              size_t size) {
+  if (offset >= file->size) {
+    return;
+  }
+  const size_t end = offset + size < file->size ? offset + size : file->size;
+  // Reading one byte per page is enough to pull it into memory
+  volatile uint8_t sink = 0;
+  for (size_t i = offset; i < end; i += THS_PAGE_SIZE) {
+    sink ^= file->data[i];
+  }
+  sink ^= file->data[end - 1];
+  (void)sink;
+}
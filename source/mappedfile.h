@@ -0,0 +1,31 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// A read only view of a whole file. Pages come from the OS file cache so
+// reading cooked data in place costs no heap copy
+//
+// Component sidecars, navigation grids and input replays are read straight
+// out of a mapping. glb scenes are not: tb_load_scene opens the file itself
+// and reads it onto the heap, so the scene loader only maps a glb to warm
+// the file cache
+typedef struct ThsMappedFile {
+  const uint8_t *data;
+  size_t size;
+#ifdef _WIN32
+  void *file;
+  void *mapping;
+#else
+  int32_t fd;
+#endif
+} ThsMappedFile;
+
+bool ths_map_file(const char *path, ThsMappedFile *file);
+void ths_unmap_file(ThsMappedFile *file);
+
+// Faults in the pages of [offset, offset + size) ahead of use. Lets a
+// background thread take the disk reads instead of whoever parses next
+void ths_prefault_mapped_file(const ThsMappedFile *file, size_t offset,
+                              size_t size);
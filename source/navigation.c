@@ -0,0 +1,493 @@
+#include "navigation.h"
+
+#include "assets.h"
+#include "profiling.h"
+#include "tbcommon.h"
+#include "world.h"
+
+#include <SDL3/SDL.h>
+
+ECS_COMPONENT_DECLARE(ThsNavigation);
+
+// Neighbours in counter clockwise order starting at +X
+static const int32_t dir_dx[8] = {1, 1, 0, -1, -1, -1, 0, 1};
+static const int32_t dir_dz[8] = {0, 1, 1, 1, 0, -1, -1, -1};
+#define DIAG 0.70710678f
+static const float2 dir_unit[8] = {
+    {1, 0}, {DIAG, DIAG}, {0, 1}, {-DIAG, DIAG},
+    {-1, 0}, {-DIAG, -DIAG}, {0, -1}, {DIAG, -DIAG},
+};
+#undef DIAG
+// Integer costs keep the search exact; roughly 10 and 10 * sqrt(2)
+#define STRAIGHT_COST 10
+#define DIAGONAL_COST 14
+
+static bool cell_blocked(const ThsNavState *state, int32_t x, int32_t z) {
+  return state->blocked[z * (int32_t)state->grid.width + x] != 0;
+}
+
+// Diagonal moves may not cut the corner of a blocked cell
+static bool can_step(const ThsNavState *state, int32_t x, int32_t z,
+                     uint32_t dir) {
+  const int32_t nx = x + dir_dx[dir];
+  const int32_t nz = z + dir_dz[dir];
+  if (nx < 0 || nz < 0 || nx >= (int32_t)state->grid.width ||
+      nz >= (int32_t)state->grid.height) {
+    return false;
+  }
+  if (cell_blocked(state, nx, nz)) {
+    return false;
+  }
+  if ((dir & 1) != 0) {
+    return !cell_blocked(state, nx, z) && !cell_blocked(state, x, nz);
+  }
+  return true;
+}
+
+static void heap_swap(ThsNavWorker *w, uint32_t a, uint32_t b) {
+  const uint32_t ca = w->heap[a];
+  const uint32_t cb = w->heap[b];
+  w->heap[a] = cb;
+  w->heap[b] = ca;
+  w->heap_pos[cb] = a;
+  w->heap_pos[ca] = b;
+}
+
+static void heap_up(ThsNavWorker *w, uint32_t i) {
+  while (i > 0) {
+    const uint32_t parent = (i - 1) / 2;
+    if (w->costs[w->heap[parent]] <= w->costs[w->heap[i]]) {
+      break;
+    }
+    heap_swap(w, i, parent);
+    i = parent;
+  }
+}
+
+static void heap_down(ThsNavWorker *w, uint32_t count, uint32_t i) {
+  for (;;) {
+    uint32_t smallest = i;
+    const uint32_t l = i * 2 + 1;
+    const uint32_t r = l + 1;
+    if (l < count && w->costs[w->heap[l]] < w->costs[w->heap[smallest]]) {
+      smallest = l;
+    }
+    if (r < count && w->costs[w->heap[r]] < w->costs[w->heap[smallest]]) {
+      smallest = r;
+    }
+    if (smallest == i) {
+      return;
+    }
+    heap_swap(w, i, smallest);
+    i = smallest;
+  }
+}
+
+// Dijkstra outwards from the goal, then every cell points at its cheapest
+// neighbour. Blocked cells point back out to open water so ships that drift
+// into an island's margin can find their way out
+static void build_field(ThsNavWorker *w, ThsNavField *field) {
+  TracyCZoneNC(ctx, "Build Flow Field", TracyCategoryColorGame, true);
+  const ThsNavState *state = w->state;
+  const int32_t width = (int32_t)state->grid.width;
+  const uint32_t cell_count = state->grid.width * state->grid.height;
+
+  for (uint32_t i = 0; i < cell_count; ++i) {
+    w->costs[i] = UINT32_MAX;
+    w->heap_pos[i] = UINT32_MAX;
+  }
+
+  uint32_t heap_count = 0;
+  const uint32_t goal = (uint32_t)field->goal;
+  w->costs[goal] = 0;
+  w->heap[heap_count] = goal;
+  w->heap_pos[goal] = heap_count++;
+
+  while (heap_count > 0) {
+    const uint32_t cell = w->heap[0];
+    heap_swap(w, 0, --heap_count);
+    w->heap_pos[cell] = UINT32_MAX;
+    heap_down(w, heap_count, 0);
+
+    const int32_t x = (int32_t)cell % width;
+    const int32_t z = (int32_t)cell / width;
+    for (uint32_t d = 0; d < 8; ++d) {
+      if (!can_step(state, x, z, d)) {
+        continue;
+      }
+      const uint32_t next =
+          (uint32_t)((z + dir_dz[d]) * width + (x + dir_dx[d]));
+      const uint32_t cost =
+          w->costs[cell] + ((d & 1) ? DIAGONAL_COST : STRAIGHT_COST);
+      if (cost >= w->costs[next]) {
+        continue;
+      }
+      w->costs[next] = cost;
+      if (w->heap_pos[next] == UINT32_MAX) {
+        w->heap[heap_count] = next;
+        w->heap_pos[next] = heap_count++;
+      }
+      heap_up(w, w->heap_pos[next]);
+    }
+  }
+
+  for (uint32_t cell = 0; cell < cell_count; ++cell) {
+    const int32_t x = (int32_t)cell % width;
+    const int32_t z = (int32_t)cell / width;
+    uint8_t best_dir = THS_NAV_NO_DIR;
+    uint32_t best_cost = cell == goal ? 0 : w->costs[cell];
+    for (uint32_t d = 0; d < 8; ++d) {
+      const int32_t nx = x + dir_dx[d];
+      const int32_t nz = z + dir_dz[d];
+      if (nx < 0 || nz < 0 || nx >= width ||
+          nz >= (int32_t)state->grid.height) {
+        continue;
+      }
+      // Open cells follow legal moves only; blocked cells take any way out
+      if (!cell_blocked(state, x, z) && !can_step(state, x, z, d)) {
+        continue;
+      }
+      const uint32_t cost = w->costs[nz * width + nx];
+      if (cost < best_cost) {
+        best_cost = cost;
+        best_dir = (uint8_t)d;
+      }
+    }
+    field->dirs[cell] = best_dir;
+  }
+
+  TracyCZoneEnd(ctx);
+}
+
+static int32_t nav_worker_thread(void *data) {
+  ThsNavWorker *worker = data;
+  ThsNavState *state = worker->state;
+  for (;;) {
+    SDL_WaitSemaphore(state->queue_sem);
+    if (atomic_load(&state->quit)) {
+      break;
+    }
+
+    // Counting ourselves busy under the lock lets the main thread know
+    // nothing is in flight once the queue is empty and busy is zero
+    int32_t index = -1;
+    SDL_LockMutex(state->queue_lock);
+    if (state->queue_count > 0) {
+      index = state->queue[state->queue_head];
+      state->queue_head = (state->queue_head + 1) % THS_NAV_MAX_FIELDS;
+      state->queue_count--;
+      atomic_fetch_add(&state->busy, 1);
+    }
+    SDL_UnlockMutex(state->queue_lock);
+    if (index < 0) {
+      continue;
+    }
+
+    ThsNavField *field = &state->fields[index];
+    atomic_store(&field->state, THS_NAV_FIELD_BUILDING);
+    const uint64_t start = SDL_GetPerformanceCounter();
+    build_field(worker, field);
+    const uint64_t us = (SDL_GetPerformanceCounter() - start) * 1000000 /
+                        SDL_GetPerformanceFrequency();
+    atomic_fetch_add(&state->build_us, (uint32_t)us);
+    atomic_fetch_add(&state->built, 1);
+    atomic_store(&field->state, THS_NAV_FIELD_READY);
+    atomic_fetch_sub(&state->busy, 1);
+  }
+  return 0;
+}
+
+// Drops queued builds and waits for the ones in flight so the grid and the
+// field storage can change underneath the workers
+static void drain_workers(ThsNavState *state) {
+  SDL_LockMutex(state->queue_lock);
+  for (uint32_t i = 0; i < state->queue_count; ++i) {
+    const int32_t index =
+        state->queue[(state->queue_head + i) % THS_NAV_MAX_FIELDS];
+    atomic_store(&state->fields[index].state, THS_NAV_FIELD_EMPTY);
+  }
+  state->queue_head = 0;
+  state->queue_count = 0;
+  SDL_UnlockMutex(state->queue_lock);
+
+  while (atomic_load(&state->busy) > 0) {
+    SDL_Delay(1);
+  }
+}
+
+static void release_grid(ThsNavState *state) {
+  drain_workers(state);
+  TbAllocator alloc = state->gp_alloc;
+  for (uint32_t i = 0; i < THS_NAV_MAX_FIELDS; ++i) {
+    tb_auto *field = &state->fields[i];
+    if (field->dirs) {
+      tb_free(alloc, field->dirs);
+    }
+    *field = (ThsNavField){.goal = -1};
+  }
+  for (uint32_t i = 0; i < THS_NAV_WORKER_COUNT; ++i) {
+    tb_auto *worker = &state->workers[i];
+    if (worker->costs) {
+      tb_free(alloc, worker->costs);
+      tb_free(alloc, worker->heap);
+      tb_free(alloc, worker->heap_pos);
+    }
+    worker->costs = NULL;
+    worker->heap = NULL;
+    worker->heap_pos = NULL;
+  }
+  if (state->owned_blocked) {
+    tb_free(alloc, state->owned_blocked);
+    state->owned_blocked = NULL;
+  }
+  ths_unmap_file(&state->mapped);
+  state->grid = (ThsNavGridHeader){0};
+  state->blocked = NULL;
+}
+
+// Worker buffers are sized for the grid up front so workers never allocate
+static void bind_grid(ThsNavState *state, const ThsNavGridHeader *header,
+                      const uint8_t *blocked) {
+  state->grid = *header;
+  state->blocked = blocked;
+  const uint32_t cell_count = header->width * header->height;
+  for (uint32_t i = 0; i < THS_NAV_WORKER_COUNT; ++i) {
+    tb_auto *worker = &state->workers[i];
+    worker->costs = tb_alloc_nm_tp(state->gp_alloc, cell_count, uint32_t);
+    worker->heap = tb_alloc_nm_tp(state->gp_alloc, cell_count, uint32_t);
+    worker->heap_pos = tb_alloc_nm_tp(state->gp_alloc, cell_count, uint32_t);
+  }
+}
+
+static bool valid_grid(const ThsNavGridHeader *header, size_t size) {
+  if (size < sizeof(ThsNavGridHeader) || header->magic != THS_NAV_MAGIC ||
+      header->version != THS_NAV_VERSION || header->cell_size <= 0.0f) {
+    return false;
+  }
+  const uint64_t cells = (uint64_t)header->width * header->height;
+  return size - sizeof(ThsNavGridHeader) >= cells;
+}
+
+void ths_nav_load_scene(ecs_world_t *ecs, const char *scene) {
+  tb_auto *nav = ecs_singleton_get_mut(ecs, ThsNavigation);
+  if (nav == NULL) {
+    return;
+  }
+  TracyCZoneNC(ctx, "Load Nav Grid", TracyCategoryColorCore, true);
+  tb_auto *state = nav->state;
+  release_grid(state);
+
+  char *scene_path = tb_resolve_asset_path(nav->gp_alloc, scene);
+  char path[512] = {0};
+  SDL_snprintf(path, sizeof(path), "%s%s", scene_path, THS_NAV_EXTENSION);
+  tb_free(nav->gp_alloc, scene_path);
+
+  ThsMappedFile mapped = {0};
+  if (!ths_map_file(path, &mapped)) {
+    // Nothing baked; ships steer straight for their destination
+    TracyCZoneEnd(ctx);
+    return;
+  }
+  const ThsNavGridHeader *header = (const ThsNavGridHeader *)mapped.data;
+  if (!valid_grid(header, mapped.size)) {
+    SDL_Log("Navigation: %s is not a valid nav grid", path);
+    ths_unmap_file(&mapped);
+    TracyCZoneEnd(ctx);
+    return;
+  }
+  if (header->width == 0 || header->height == 0) {
+    // Baked but without islands
+    ths_unmap_file(&mapped);
+    TracyCZoneEnd(ctx);
+    return;
+  }
+  state->mapped = mapped;
+  bind_grid(state, header, mapped.data + sizeof(ThsNavGridHeader));
+  SDL_Log("Navigation: %ux%u cells of %.1fm, %u blocked", header->width,
+          header->height, (double)header->cell_size, header->blocked_count);
+  TracyCZoneEnd(ctx);
+}
+
+void ths_nav_set_grid(ecs_world_t *ecs, const ThsNavGridHeader *header,
+                      const uint8_t *blocked) {
+  tb_auto *nav = ecs_singleton_get_mut(ecs, ThsNavigation);
+  tb_auto *state = nav->state;
+  release_grid(state);
+  const uint32_t cell_count = header->width * header->height;
+  if (cell_count == 0) {
+    return;
+  }
+  state->owned_blocked = tb_alloc_nm_tp(nav->gp_alloc, cell_count, uint8_t);
+  SDL_memcpy(state->owned_blocked, blocked, cell_count);
+  bind_grid(state, header, state->owned_blocked);
+}
+
+int32_t ths_nav_cell(const ThsNavigation *nav, float2 pos) {
+  const ThsNavGridHeader *grid = &nav->state->grid;
+  if (grid->width == 0) {
+    return -1;
+  }
+  const float fx = (pos.x - grid->origin_x) / grid->cell_size;
+  const float fz = (pos.y - grid->origin_z) / grid->cell_size;
+  if (fx < 0.0f || fz < 0.0f || fx >= (float)grid->width ||
+      fz >= (float)grid->height) {
+    return -1;
+  }
+  return (int32_t)fz * (int32_t)grid->width + (int32_t)fx;
+}
+
+// Builds almost always finish well before their field is due. When one
+// doesn't the step waits for it rather than steering differently
+static void wait_for_field(ThsNavField *field) {
+  if (atomic_load(&field->state) == THS_NAV_FIELD_READY) {
+    return;
+  }
+  TracyCZoneNC(ctx, "Wait For Flow Field", TracyCategoryColorGame, true);
+  while (atomic_load(&field->state) != THS_NAV_FIELD_READY) {
+    SDL_Delay(0);
+  }
+  TracyCZoneEnd(ctx);
+}
+
+const ThsNavField *ths_nav_request_field(ThsNavigation *nav, uint64_t step,
+                                         float2 destination) {
+  tb_auto *state = nav->state;
+  const int32_t goal = ths_nav_cell(nav, destination);
+  if (goal < 0) {
+    return NULL;
+  }
+
+  ThsNavField *slot = NULL;
+  for (uint32_t i = 0; i < THS_NAV_MAX_FIELDS; ++i) {
+    tb_auto *field = &state->fields[i];
+    const int32_t field_state = atomic_load(&field->state);
+    if (field_state == THS_NAV_FIELD_EMPTY) {
+      if (slot == NULL || atomic_load(&slot->state) != THS_NAV_FIELD_EMPTY) {
+        slot = field;
+      }
+      continue;
+    }
+    if (field->goal == goal) {
+      field->last_used = step;
+      if (step < field->due_step) {
+        return NULL;
+      }
+      wait_for_field(field);
+      return field;
+    }
+    // Reuse the due field nobody has read for the longest. Whether it has
+    // been built yet doesn't matter so the choice is the same every run
+    if (field->due_step <= step && field->last_used < step &&
+        (slot == NULL || (atomic_load(&slot->state) != THS_NAV_FIELD_EMPTY &&
+                          field->last_used < slot->last_used))) {
+      slot = field;
+    }
+  }
+  if (slot == NULL) {
+    // Every field is in use this step; steer straight until one frees up
+    return NULL;
+  }
+  // The workers may still be writing the field being replaced
+  if (atomic_load(&slot->state) != THS_NAV_FIELD_EMPTY) {
+    wait_for_field(slot);
+  }
+
+  if (slot->dirs == NULL) {
+    const uint32_t cell_count = state->grid.width * state->grid.height;
+    slot->dirs = tb_alloc_nm_tp(nav->gp_alloc, cell_count, uint8_t);
+  }
+  slot->goal = goal;
+  slot->last_used = step;
+  slot->due_step = step + THS_NAV_FIELD_LATENCY;
+  atomic_store(&slot->state, THS_NAV_FIELD_QUEUED);
+
+  SDL_LockMutex(state->queue_lock);
+  const uint32_t tail =
+      (state->queue_head + state->queue_count) % THS_NAV_MAX_FIELDS;
+  state->queue[tail] = (int32_t)(slot - state->fields);
+  state->queue_count++;
+  SDL_UnlockMutex(state->queue_lock);
+  SDL_PostSemaphore(state->queue_sem);
+  return NULL;
+}
+
+bool ths_nav_field_direction(const ThsNavigation *nav,
+                             const ThsNavField *field, float2 pos,
+                             float2 *dir) {
+  const int32_t cell = ths_nav_cell(nav, pos);
+  if (field == NULL || cell < 0) {
+    return false;
+  }
+  const uint8_t d = field->dirs[cell];
+  if (d == THS_NAV_NO_DIR) {
+    return false;
+  }
+  *dir = dir_unit[d];
+  return true;
+}
+
+void ths_nav_end_step(ThsNavigation *nav) {
+  tb_auto *state = nav->state;
+  nav->lookups = nav->step_lookups;
+  nav->step_lookups = 0;
+  nav->fields_built = atomic_exchange(&state->built, 0);
+  nav->build_ms = (float)atomic_exchange(&state->build_us, 0) / 1000.0f;
+  nav->fields_resident = 0;
+  for (uint32_t i = 0; i < THS_NAV_MAX_FIELDS; ++i) {
+    if (atomic_load(&state->fields[i].state) == THS_NAV_FIELD_READY) {
+      nav->fields_resident++;
+    }
+  }
+  TracyCPlot("Nav Lookups", (double)nav->lookups);
+  TracyCPlot("Nav Fields Built", (double)nav->fields_built);
+  TracyCPlot("Nav Fields Resident", (double)nav->fields_resident);
+  TracyCPlot("Nav Build ms", (double)nav->build_ms);
+}
+
+void ths_register_navigation_sys(TbWorld *world) {
+  ecs_world_t *ecs = world->ecs;
+  ECS_COMPONENT_DEFINE(ecs, ThsNavigation);
+
+  ThsNavigation nav = {
+      .gp_alloc = world->gp_alloc,
+      .state = tb_alloc_nm_tp(world->gp_alloc, 1, ThsNavState),
+  };
+  tb_auto *state = nav.state;
+  *state = (ThsNavState){
+      .gp_alloc = world->gp_alloc,
+      .queue_lock = SDL_CreateMutex(),
+      .queue_sem = SDL_CreateSemaphore(0),
+  };
+  for (uint32_t i = 0; i < THS_NAV_MAX_FIELDS; ++i) {
+    state->fields[i].goal = -1;
+  }
+  for (uint32_t i = 0; i < THS_NAV_WORKER_COUNT; ++i) {
+    tb_auto *worker = &state->workers[i];
+    worker->state = state;
+    worker->thread =
+        SDL_CreateThread(nav_worker_thread, "Flow Field Worker", worker);
+    TB_CHECK(worker->thread, "Failed to create flow field worker");
+  }
+  ecs_singleton_set_ptr(ecs, ThsNavigation, &nav);
+}
+
+void ths_unregister_navigation_sys(TbWorld *world) {
+  ecs_world_t *ecs = world->ecs;
+  tb_auto *nav = ecs_singleton_get_mut(ecs, ThsNavigation);
+  tb_auto *state = nav->state;
+
+  release_grid(state);
+  atomic_store(&state->quit, true);
+  for (uint32_t i = 0; i < THS_NAV_WORKER_COUNT; ++i) {
+    SDL_PostSemaphore(state->queue_sem);
+  }
+  for (uint32_t i = 0; i < THS_NAV_WORKER_COUNT; ++i) {
+    SDL_WaitThread(state->workers[i].thread, NULL);
+  }
+  SDL_DestroySemaphore(state->queue_sem);
+  SDL_DestroyMutex(state->queue_lock);
+  tb_free(nav->gp_alloc, state);
+  ecs_singleton_remove(ecs, ThsNavigation);
+}
+
+TB_REGISTER_SYS(ths, navigation, TB_SYSTEM_NORMAL)
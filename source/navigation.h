@@ -0,0 +1,142 @@
+#pragma once
+
+#include "allocator.h"
+#include "mappedfile.h"
+#include "simd.h"
+
+#include <flecs.h>
+
+#include <stdatomic.h>
+
+typedef struct SDL_Thread SDL_Thread;
+typedef struct SDL_Mutex SDL_Mutex;
+typedef struct SDL_Semaphore SDL_Semaphore;
+
+// Navigation for ships that aren't steered by the player
+//
+// Islands are baked at cook time into a grid of blocked cells over the XZ
+// plane and stored next to the scene in a .thsn sidecar. Ships ask for a
+// flow field towards their destination cell; one field answers for every
+// ship going to that cell, so the cost of pathing grows with the number of
+// destinations rather than the number of ships. Fields are built from the
+// grid on worker threads and ships steer straight for their destination
+// until theirs is ready
+
+#define THS_NAV_MAGIC 0x4E534854 // 'THSN'
+#define THS_NAV_VERSION 1
+#define THS_NAV_EXTENSION ".thsn"
+
+#define THS_NAV_MAX_FIELDS 32
+#define THS_NAV_WORKER_COUNT 2
+// Marks a cell that can't reach the destination or is the destination
+#define THS_NAV_NO_DIR 0xFF
+// Steps between requesting a field and ships seeing it. Fixed so that runs
+// steer the same no matter how quickly the workers got to it
+#define THS_NAV_FIELD_LATENCY 4
+
+typedef struct ThsNavGridHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t width;  // Cells along X
+  uint32_t height; // Cells along Z
+  float cell_size;
+  float origin_x; // World position of the corner of cell 0
+  float origin_z;
+  uint32_t blocked_count;
+  // Followed by width * height bytes, non zero where a cell is blocked
+} ThsNavGridHeader;
+
+typedef enum ThsNavFieldState {
+  THS_NAV_FIELD_EMPTY,
+  THS_NAV_FIELD_QUEUED,
+  THS_NAV_FIELD_BUILDING,
+  THS_NAV_FIELD_READY,
+} ThsNavFieldState;
+
+// Directions towards one destination cell, one of 8 neighbours per cell
+typedef struct ThsNavField {
+  int32_t goal;          // Cell index of the destination
+  _Atomic int32_t state; // ThsNavFieldState
+  uint8_t *dirs;
+  uint64_t last_used; // Simulation step a ship last read this field
+  uint64_t due_step;  // Simulation step ships start following this field
+} ThsNavField;
+
+typedef struct ThsNavWorker {
+  struct ThsNavState *state;
+  SDL_Thread *thread;
+  // Dijkstra state reused between fields, one entry per cell
+  uint32_t *costs;
+  uint32_t *heap;
+  uint32_t *heap_pos; // Where a cell sits in the heap or UINT32_MAX
+} ThsNavWorker;
+
+// Everything the workers share with the main thread. Heap allocated so it
+// stays put no matter what happens to component storage
+typedef struct ThsNavState {
+  TbAllocator gp_alloc;
+
+  // The grid of the current scene. A width of 0 means open water
+  ThsNavGridHeader grid;
+  const uint8_t *blocked;
+  uint8_t *owned_blocked; // Set when the grid was copied rather than mapped
+  ThsMappedFile mapped;
+
+  ThsNavField fields[THS_NAV_MAX_FIELDS];
+
+  // Field indices waiting for a worker
+  SDL_Mutex *queue_lock;
+  SDL_Semaphore *queue_sem;
+  int32_t queue[THS_NAV_MAX_FIELDS];
+  uint32_t queue_head;
+  uint32_t queue_count;
+  _Atomic int32_t busy; // Workers currently building a field
+  _Atomic bool quit;
+  ThsNavWorker workers[THS_NAV_WORKER_COUNT];
+
+  // Written by workers, drained once per step
+  _Atomic uint32_t built;
+  _Atomic uint32_t build_us;
+} ThsNavState;
+
+typedef struct ThsNavigation {
+  TbAllocator gp_alloc;
+  ThsNavState *state;
+
+  uint32_t step_lookups; // Field reads by ships during the current step
+
+  // Counts for the most recent step
+  uint32_t lookups;
+  uint32_t fields_built;
+  uint32_t fields_resident;
+  float build_ms; // Worker time spent building those fields
+} ThsNavigation;
+extern ECS_COMPONENT_DECLARE(ThsNavigation);
+
+// Loads the sidecar baked for a scene. Scenes without one are open water
+void ths_nav_load_scene(ecs_world_t *ecs, const char *scene);
+
+// Replaces the grid with a copy of the given cells. Mostly for tools and
+// the bench which have no cooked scene
+void ths_nav_set_grid(ecs_world_t *ecs, const ThsNavGridHeader *header,
+                      const uint8_t *blocked);
+
+// Positions are on the XZ plane with Z in the second lane
+//
+// Cell index of a point or -1 if it lies outside the grid
+int32_t ths_nav_cell(const ThsNavigation *nav, float2 pos);
+
+// Returns the field towards the destination once it is due. Until then
+// this queues the build and returns NULL. Waits for the workers if a due
+// field isn't built yet. Main thread only
+const ThsNavField *ths_nav_request_field(ThsNavigation *nav, uint64_t step,
+                                         float2 destination);
+
+// Unit direction on the XZ plane to follow from a point. Returns false when
+// the field has no advice there, e.g. outside the grid or at the goal
+bool ths_nav_field_direction(const ThsNavigation *nav,
+                             const ThsNavField *field, float2 pos,
+                             float2 *dir);
+
+// Publishes the step's counters and starts counting the next one
+void ths_nav_end_step(ThsNavigation *nav);
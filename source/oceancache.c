@@ -0,0 +1,73 @@
+#include "oceancache.h"
+
+#include "profiling.h"
+#include "tbcommon.h"
+#include "world.h"
+
+ECS_COMPONENT_DECLARE(ThsOceanCache);
+
+const TbOceanComponent *ths_ocean_cache_get_ocean(const ThsOceanCache *cache,
+                                                  ecs_world_t *ecs) {
+  if (cache->ocean_ent == 0) {
+    return NULL;
+  }
+  return ecs_get(ecs, cache->ocean_ent, TbOceanComponent);
+}
+
+void ocean_cache_observe(ecs_iter_t *it) {
+  ecs_world_t *ecs = it->world;
+  tb_auto *cache = ecs_singleton_get_mut(ecs, ThsOceanCache);
+
+  for (int32_t i = 0; i < it->count; ++i) {
+    if (it->event == EcsOnRemove) {
+      if (cache->ocean_ent == it->entities[i]) {
+        cache->ocean_ent = 0;
+      }
+    } else {
+      TB_CHECK(cache->ocean_ent == 0 || cache->ocean_ent == it->entities[i],
+               "Not expecting more than one ocean");
+      cache->ocean_ent = it->entities[i];
+    }
+  }
+}
+
+TbOceanSample ths_ocean_cache_sample(const ThsOceanCache *cache,
+                                     ecs_world_t *ecs, float2 pos) {
+  const TbOceanComponent *ocean = ths_ocean_cache_get_ocean(cache, ecs);
+  TB_CHECK(ocean, "Sampling the ocean cache without an ocean");
+  return tb_sample_ocean(ocean, ecs, cache->ocean_ent, pos);
+}
+
+void ths_ocean_cache_sample_batch(const ThsOceanCache *cache, ecs_world_t *ecs,
+                                  ThsOceanSampleBatch *batch) {
+  TracyCZoneNC(ctx, "Ocean Cache Sample Batch", TracyCategoryColorGame, true);
+  const TbOceanComponent *ocean = ths_ocean_cache_get_ocean(cache, ecs);
+  TB_CHECK(ocean, "Sampling the ocean cache without an ocean");
+  ths_sample_ocean_batch(ocean, ecs, cache->ocean_ent, batch);
+  TracyCZoneEnd(ctx);
+}
+
+void ths_register_ocean_cache_sys(TbWorld *world) {
+  ecs_world_t *ecs = world->ecs;
+  ECS_COMPONENT_DEFINE(ecs, ThsOceanCache);
+
+  ThsOceanCache cache = {0};
+  ecs_singleton_set_ptr(ecs, ThsOceanCache, &cache);
+
+  // Resolve the ocean entity when it shows up rather than querying for it
+  // every frame
+  ecs_observer(ecs, {.filter.terms =
+                         {
+                             {.id = ecs_id(TbOceanComponent)},
+                         },
+                     .events = {EcsOnSet, EcsOnRemove},
+                     .yield_existing = true,
+                     .callback = ocean_cache_observe});
+}
+
+void ths_unregister_ocean_cache_sys(TbWorld *world) {
+  ecs_world_t *ecs = world->ecs;
+  ecs_singleton_remove(ecs, ThsOceanCache);
+}
+
+TB_REGISTER_SYS(ths, ocean_cache, TB_SYSTEM_NORMAL)
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "oceancomponent.h"
+#include "oceansampling.h"
+#include "simd.h"
+
+#include <flecs.h>
+
+// Remembers the one ocean in the scene so consumers don't need to query for
+// it every frame
+//
+// An earlier version also kept a grid of displacement samples around every
+// boat. A hull takes at most six samples and the SIMD sampler evaluates
+// those faster than any grid could be built and fetched from, so lookups
+// always sample the ocean directly
+typedef struct ThsOceanCache {
+  // Kept up to date by an observer
+  ecs_entity_t ocean_ent;
+} ThsOceanCache;
+extern ECS_COMPONENT_DECLARE(ThsOceanCache);
+
+// Returns the ocean component the cache is tracking, if any
+const TbOceanComponent *ths_ocean_cache_get_ocean(const ThsOceanCache *cache,
+                                                  ecs_world_t *ecs);
+
+// Samples the tracked ocean at a point on the XZ plane
+TbOceanSample ths_ocean_cache_sample(const ThsOceanCache *cache,
+                                     ecs_world_t *ecs, float2 pos);
+
+// Fills in the results of a batch with the SIMD sampler
+void ths_ocean_cache_sample_batch(const ThsOceanCache *cache, ecs_world_t *ecs,
+                                  ThsOceanSampleBatch *batch);
@@ -0,0 +1,231 @@
+#include "oceansampling.h"
+
+#include "profiling.h"
+#include "simdlanes.h"
+#include "tbcommon.h"
+#include "transformcomponent.h"
+
+#include <SDL3/SDL_stdinc.h>
+
+// Number of float arrays a batch is made of
+#define THS_OCEAN_BATCH_ARRAYS 11
+
+// Capacity of the wave array on the ocean component
+#define THS_OCEAN_MAX_WAVES                                                    \
+  (sizeof(((TbOceanComponent *)0)->waves) / sizeof(TbOceanWave))
+
+// Per-wave constants hoisted out of the kernel
+typedef struct ThsWaveCoeffs {
+  float k_dir_x; // k * d.x
+  float k_dir_z; // k * d.y
+  float phase;   // k * c * time
+
+  float pos_x; // d.x * a
+  float pos_y; // a
+  float pos_z; // d.y * a
+
+  float tangent_x; // -d.x * d.x * steepness
+  float tangent_y; // d.x * steepness
+  float tangent_z; // -d.x * d.y * steepness
+
+  float binormal_x; // -d.x * d.y * steepness
+  float binormal_y; // d.y * steepness
+  float binormal_z; // -d.y * d.y * steepness
+} ThsWaveCoeffs;
+
+bool ths_create_ocean_batch(TbAllocator alloc, uint32_t count,
+                            ThsOceanSampleBatch *batch) {
+  const uint32_t capacity = ths_lane_pad(count);
+  float *data =
+      tb_alloc_nm_tp(alloc, (size_t)capacity * THS_OCEAN_BATCH_ARRAYS, float);
+  if (data == NULL) {
+    return false;
+  }
+  // Padding lanes still get evaluated so give them a defined input
+  SDL_memset(data, 0, sizeof(float) * capacity * 2);
+
+  *batch = (ThsOceanSampleBatch){
+      .count = count,
+      .capacity = capacity,
+      .stride = capacity,
+      .x = data,
+      .z = data + capacity,
+      .pos_x = data + capacity * 2,
+      .pos_y = data + capacity * 3,
+      .pos_z = data + capacity * 4,
+      .tangent_x = data + capacity * 5,
+      .tangent_y = data + capacity * 6,
+      .tangent_z = data + capacity * 7,
+      .binormal_x = data + capacity * 8,
+      .binormal_y = data + capacity * 9,
+      .binormal_z = data + capacity * 10,
+  };
+  return true;
+}
+
+bool ths_reserve_ocean_batch(TbAllocator alloc, uint32_t count,
+                             ThsOceanSampleBatch *batch) {
+  const uint32_t capacity = ths_lane_pad(count);
+  if (batch->x == NULL || capacity > batch->stride) {
+    ths_destroy_ocean_batch(alloc, batch);
+    // Grow with some headroom so a slowly growing fleet doesn't realloc
+    // every frame
+    const uint32_t stride = ths_lane_pad(count + count / 2);
+    if (!ths_create_ocean_batch(alloc, stride, batch)) {
+      return false;
+    }
+  }
+  batch->count = count;
+  batch->capacity = capacity;
+  for (uint32_t i = count; i < capacity; ++i) {
+    batch->x[i] = 0.0f;
+    batch->z[i] = 0.0f;
+  }
+  return true;
+}
+
+void ths_destroy_ocean_batch(TbAllocator alloc, ThsOceanSampleBatch *batch) {
+  if (batch->x) {
+    tb_free(alloc, batch->x);
+  }
+  *batch = (ThsOceanSampleBatch){0};
+}
+
+static uint32_t calc_wave_coeffs(const TbOceanComponent *ocean,
+                                 ThsWaveCoeffs *coeffs) {
+  const uint32_t wave_count =
+      SDL_min(ocean->wave_count, (uint32_t)THS_OCEAN_MAX_WAVES);
+  for (uint32_t i = 0; i < wave_count; ++i) {
+    const TbOceanWave *wave = &ocean->waves[i];
+
+    // Same gerstner formulation as tb_sample_ocean and the ocean shaders
+    const float steepness = wave->steepness;
+    const float k = 2.0f * SDL_PI_F / wave->wavelength;
+    const float c = SDL_sqrtf(9.8f / k);
+    const float a = steepness / k;
+
+    float dir_x = wave->direction_x;
+    float dir_z = wave->direction_y;
+    const float dir_len = SDL_sqrtf(dir_x * dir_x + dir_z * dir_z);
+    if (dir_len > 0.0f) {
+      dir_x /= dir_len;
+      dir_z /= dir_len;
+    }
+
+    coeffs[i] = (ThsWaveCoeffs){
+        .k_dir_x = k * dir_x,
+        .k_dir_z = k * dir_z,
+        .phase = k * c * ocean->time,
+        .pos_x = dir_x * a,
+        .pos_y = a,
+        .pos_z = dir_z * a,
+        .tangent_x = -dir_x * dir_x * steepness,
+        .tangent_y = dir_x * steepness,
+        .tangent_z = -dir_x * dir_z * steepness,
+        .binormal_x = -dir_x * dir_z * steepness,
+        .binormal_y = dir_z * steepness,
+        .binormal_z = -dir_z * dir_z * steepness,
+    };
+  }
+  return wave_count;
+}
+
+static ThsLane lane_rcp_len(ThsLane x, ThsLane y, ThsLane z) {
+  ThsLane len_sq = ths_lane_mul(x, x);
+  len_sq = ths_lane_madd(y, y, len_sq);
+  len_sq = ths_lane_madd(z, z, len_sq);
+  return ths_lane_div(ths_lane_set1(1.0f), ths_lane_sqrt(len_sq));
+}
+
+void ths_sample_ocean_batch(const TbOceanComponent *ocean, ecs_world_t *ecs,
+                            ecs_entity_t ocean_ent,
+                            ThsOceanSampleBatch *batch) {
+  TracyCZoneNC(ctx, "Sample Ocean Batch", TracyCategoryColorGame, true);
+
+  ThsWaveCoeffs coeffs[THS_OCEAN_MAX_WAVES] = {0};
+  const uint32_t wave_count = calc_wave_coeffs(ocean, coeffs);
+
+  // Waves are evaluated in the ocean's space
+  float3 origin = {0};
+  {
+    const tb_auto *ocean_trans = ecs_get(ecs, ocean_ent, TbTransformComponent);
+    if (ocean_trans) {
+      origin = ocean_trans->transform.position;
+    }
+  }
+  const ThsLane origin_x = ths_lane_set1(origin.x);
+  const ThsLane origin_y = ths_lane_set1(origin.y);
+  const ThsLane origin_z = ths_lane_set1(origin.z);
+
+  for (uint32_t base = 0; base < batch->capacity; base += THS_LANE_WIDTH) {
+    const ThsLane x = ths_lane_sub(ths_lane_load(&batch->x[base]), origin_x);
+    const ThsLane z = ths_lane_sub(ths_lane_load(&batch->z[base]), origin_z);
+
+    ThsLane pos_x = x;
+    ThsLane pos_y = ths_lane_set1(0.0f);
+    ThsLane pos_z = z;
+    ThsLane tan_x = ths_lane_set1(1.0f);
+    ThsLane tan_y = ths_lane_set1(0.0f);
+    ThsLane tan_z = ths_lane_set1(0.0f);
+    ThsLane bin_x = ths_lane_set1(0.0f);
+    ThsLane bin_y = ths_lane_set1(0.0f);
+    ThsLane bin_z = ths_lane_set1(1.0f);
+
+    for (uint32_t w = 0; w < wave_count; ++w) {
+      const ThsWaveCoeffs *wave = &coeffs[w];
+
+      ThsLane f = ths_lane_mul(x, ths_lane_set1(wave->k_dir_x));
+      f = ths_lane_madd(z, ths_lane_set1(wave->k_dir_z), f);
+      f = ths_lane_sub(f, ths_lane_set1(wave->phase));
+
+      ThsLane sin_f = {0};
+      ThsLane cos_f = {0};
+      ths_lane_sincos(f, &sin_f, &cos_f);
+
+      pos_x = ths_lane_madd(cos_f, ths_lane_set1(wave->pos_x), pos_x);
+      pos_y = ths_lane_madd(sin_f, ths_lane_set1(wave->pos_y), pos_y);
+      pos_z = ths_lane_madd(cos_f, ths_lane_set1(wave->pos_z), pos_z);
+
+      tan_x = ths_lane_madd(sin_f, ths_lane_set1(wave->tangent_x), tan_x);
+      tan_y = ths_lane_madd(cos_f, ths_lane_set1(wave->tangent_y), tan_y);
+      tan_z = ths_lane_madd(sin_f, ths_lane_set1(wave->tangent_z), tan_z);
+
+      bin_x = ths_lane_madd(sin_f, ths_lane_set1(wave->binormal_x), bin_x);
+      bin_y = ths_lane_madd(cos_f, ths_lane_set1(wave->binormal_y), bin_y);
+      bin_z = ths_lane_madd(sin_f, ths_lane_set1(wave->binormal_z), bin_z);
+    }
+
+    const ThsLane tan_rcp = lane_rcp_len(tan_x, tan_y, tan_z);
+    const ThsLane bin_rcp = lane_rcp_len(bin_x, bin_y, bin_z);
+
+    ths_lane_store(&batch->pos_x[base], ths_lane_add(pos_x, origin_x));
+    ths_lane_store(&batch->pos_y[base], ths_lane_add(pos_y, origin_y));
+    ths_lane_store(&batch->pos_z[base], ths_lane_add(pos_z, origin_z));
+    ths_lane_store(&batch->tangent_x[base], ths_lane_mul(tan_x, tan_rcp));
+    ths_lane_store(&batch->tangent_y[base], ths_lane_mul(tan_y, tan_rcp));
+    ths_lane_store(&batch->tangent_z[base], ths_lane_mul(tan_z, tan_rcp));
+    ths_lane_store(&batch->binormal_x[base], ths_lane_mul(bin_x, bin_rcp));
+    ths_lane_store(&batch->binormal_y[base], ths_lane_mul(bin_y, bin_rcp));
+    ths_lane_store(&batch->binormal_z[base], ths_lane_mul(bin_z, bin_rcp));
+  }
+
+  TracyCZoneEnd(ctx);
+}
+
+TbOceanSample ths_average_ocean_batch(const ThsOceanSampleBatch *batch,
+                                      uint32_t first, uint32_t count) {
+  TB_CHECK(first + count <= batch->count, "Average out of batch range");
+  TbOceanSample avg = {.pos = {0}};
+  for (uint32_t i = first; i < first + count; ++i) {
+    avg.pos += tb_f3(batch->pos_x[i], batch->pos_y[i], batch->pos_z[i]);
+    avg.tangent +=
+        tb_f3(batch->tangent_x[i], batch->tangent_y[i], batch->tangent_z[i]);
+    avg.binormal +=
+        tb_f3(batch->binormal_x[i], batch->binormal_y[i], batch->binormal_z[i]);
+  }
+  const float inv_count = 1.0f / (float)count;
+  avg.pos *= inv_count;
+  avg.tangent = tb_normf3(avg.tangent * inv_count);
+  avg.binormal = tb_normf3(avg.binormal * inv_count);
+  return avg;
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "allocator.h"
+#include "oceancomponent.h"
+#include "simd.h"
+
+#include <flecs.h>
+
+// A structure of arrays batch of ocean samples
+// Kernels process `capacity` entries which is `count` padded out to the SIMD
+// lane width so they never need a scalar tail. `stride` is how many entries
+// each array was allocated with and may be larger when storage is reused
+typedef struct ThsOceanSampleBatch {
+  uint32_t count;
+  uint32_t capacity;
+  uint32_t stride;
+
+  // Sample points on the XZ plane, filled in by the caller
+  float *x;
+  float *z;
+
+  // Results
+  float *pos_x;
+  float *pos_y;
+  float *pos_z;
+  float *tangent_x;
+  float *tangent_y;
+  float *tangent_z;
+  float *binormal_x;
+  float *binormal_y;
+  float *binormal_z;
+} ThsOceanSampleBatch;
+
+// Allocates every array of the batch out of a single block from `alloc`
+// Intended to be used with the temporary allocator
+bool ths_create_ocean_batch(TbAllocator alloc, uint32_t count,
+                            ThsOceanSampleBatch *batch);
+
+// Resizes a batch to hold `count` samples, only reallocating when the
+// existing storage is too small. Meant for batches that live across frames
+bool ths_reserve_ocean_batch(TbAllocator alloc, uint32_t count,
+                             ThsOceanSampleBatch *batch);
+
+void ths_destroy_ocean_batch(TbAllocator alloc, ThsOceanSampleBatch *batch);
+
+// Evaluates the ocean waves for every point in the batch
+// Produces the same results as calling tb_sample_ocean once per point for an
+// ocean entity with no rotation or scale
+void ths_sample_ocean_batch(const TbOceanComponent *ocean, ecs_world_t *ecs,
+                            ecs_entity_t ocean_ent,
+                            ThsOceanSampleBatch *batch);
+
+// Averages a contiguous run of samples from a batch, normalizing the
+// resulting tangent and binormal
+TbOceanSample ths_average_ocean_batch(const ThsOceanSampleBatch *batch,
+                                      uint32_t first, uint32_t count);
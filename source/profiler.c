@@ -0,0 +1,218 @@
+#include "profiler.h"
+
+#include "imguisystem.h"
+#include "profiling.h"
+#include "tbcommon.h"
+#include "tbimgui.h"
+#include "world.h"
+
+#include <SDL3/SDL.h>
+
+#include <flecs.h>
+
+#include <stdatomic.h>
+#include <stdio.h>
+
+typedef struct ThsProfilerTrack {
+  const char *name;
+  // Performance counter ticks spent in this track during the current frame
+  _Atomic uint64_t frame_ticks;
+  float history_ms[THS_PROFILER_HISTORY];
+} ThsProfilerTrack;
+
+typedef struct ThsProfiler {
+  uint32_t track_count;
+  ThsProfilerTrack tracks[THS_PROFILER_MAX_TRACKS];
+
+  uint32_t head;        // History slot the next frame is written to
+  uint32_t frame_count; // Frames recorded, up to THS_PROFILER_HISTORY
+  double ms_per_tick;
+
+  bool overlay;
+  const char *csv_path;
+} ThsProfiler;
+
+bool ths_profiler_active = false;
+
+static ThsProfiler profiler = {0};
+
+ThsProfileTrack ths_profiler_track(const char *name) {
+  for (uint32_t i = 0; i < profiler.track_count; ++i) {
+    if (SDL_strcmp(profiler.tracks[i].name, name) == 0) {
+      return i;
+    }
+  }
+  TB_CHECK(profiler.track_count < THS_PROFILER_MAX_TRACKS,
+           "Too many profiler tracks");
+  if (profiler.track_count >= THS_PROFILER_MAX_TRACKS) {
+    return 0;
+  }
+  ThsProfileTrack track = profiler.track_count++;
+  profiler.tracks[track].name = name;
+  return track;
+}
+
+void ths_profiler_set_enabled(bool enabled) {
+  if (enabled && !ths_profiler_active) {
+    // Start from a clean history so old frames don't skew percentiles
+    for (uint32_t i = 0; i < profiler.track_count; ++i) {
+      tb_auto *track = &profiler.tracks[i];
+      atomic_store(&track->frame_ticks, 0);
+      SDL_memset(track->history_ms, 0, sizeof(track->history_ms));
+    }
+    profiler.head = 0;
+    profiler.frame_count = 0;
+    profiler.ms_per_tick = 1000.0 / (double)SDL_GetPerformanceFrequency();
+  }
+  profiler.overlay = enabled;
+  ths_profiler_active = enabled || profiler.csv_path != NULL;
+}
+
+bool ths_profiler_enabled(void) { return profiler.overlay; }
+
+void ths_profiler_configure(int32_t argc, char *argv[]) {
+  for (int32_t i = 1; i < argc; ++i) {
+    if (SDL_strcmp(argv[i], "--profile") == 0) {
+      ths_profiler_set_enabled(true);
+    } else if (SDL_strcmp(argv[i], "--profile-csv") == 0 && i + 1 < argc) {
+      profiler.csv_path = argv[i + 1];
+      ths_profiler_set_enabled(true);
+    }
+  }
+}
+
+uint64_t ths_profile_now(void) { return SDL_GetPerformanceCounter(); }
+
+void ths_profile_record(ThsProfileTrack track, uint64_t start) {
+  const uint64_t ticks = SDL_GetPerformanceCounter() - start;
+  atomic_fetch_add_explicit(&profiler.tracks[track].frame_ticks, ticks,
+                            memory_order_relaxed);
+}
+
+void ths_profiler_end_frame(void) {
+  if (!ths_profiler_active) {
+    return;
+  }
+  for (uint32_t i = 0; i < profiler.track_count; ++i) {
+    tb_auto *track = &profiler.tracks[i];
+    const uint64_t ticks = atomic_exchange(&track->frame_ticks, 0);
+    track->history_ms[profiler.head] =
+        (float)((double)ticks * profiler.ms_per_tick);
+  }
+  profiler.head = (profiler.head + 1) % THS_PROFILER_HISTORY;
+  profiler.frame_count =
+      SDL_min(profiler.frame_count + 1, THS_PROFILER_HISTORY);
+}
+
+// Index into a history buffer of the nth oldest recorded frame
+static uint32_t history_index(uint32_t n) {
+  return (profiler.head + THS_PROFILER_HISTORY - profiler.frame_count + n) %
+         THS_PROFILER_HISTORY;
+}
+
+bool ths_profiler_write_csv(const char *path) {
+  FILE *file = fopen(path, "w");
+  if (file == NULL) {
+    SDL_Log("Profiler: failed to open %s for writing", path);
+    return false;
+  }
+
+  fprintf(file, "frame");
+  for (uint32_t i = 0; i < profiler.track_count; ++i) {
+    fprintf(file, ",%s", profiler.tracks[i].name);
+  }
+  fprintf(file, "\n");
+
+  for (uint32_t f = 0; f < profiler.frame_count; ++f) {
+    const uint32_t idx = history_index(f);
+    fprintf(file, "%u", f);
+    for (uint32_t i = 0; i < profiler.track_count; ++i) {
+      fprintf(file, ",%.4f", (double)profiler.tracks[i].history_ms[idx]);
+    }
+    fprintf(file, "\n");
+  }
+
+  fclose(file);
+  SDL_Log("Profiler: wrote %u frames to %s", profiler.frame_count, path);
+  return true;
+}
+
+void ths_profiler_finish(void) {
+  if (profiler.csv_path) {
+    ths_profiler_write_csv(profiler.csv_path);
+  }
+}
+
+static int32_t compare_floats(const void *a, const void *b) {
+  const float fa = *(const float *)a;
+  const float fb = *(const float *)b;
+  return (fa > fb) - (fa < fb);
+}
+
+void profiler_overlay_tick(ecs_iter_t *it) {
+  if (!profiler.overlay) {
+    return;
+  }
+  TracyCZoneNC(ctx, "Profiler Overlay", TracyCategoryColorUI, true);
+
+  tb_auto ui = ecs_singleton_get(it->world, TbImGuiSystem);
+  if (ui == NULL || ui->context_count == 0) {
+    TracyCZoneEnd(ctx);
+    return;
+  }
+  igSetCurrentContext(ui->contexts[0].context);
+
+  bool open = true;
+  igSetNextWindowPos((ImVec2){10, 10}, ImGuiCond_FirstUseEver, (ImVec2){0});
+  if (igBegin("Profiler", &open, ImGuiWindowFlags_AlwaysAutoResize)) {
+    igText("%u frames", profiler.frame_count);
+    igSameLine(0.0f, -1.0f);
+    if (igButton("Dump CSV", (ImVec2){0})) {
+      ths_profiler_write_csv(profiler.csv_path ? profiler.csv_path
+                                               : "profile.csv");
+    }
+
+    float sorted[THS_PROFILER_HISTORY] = {0};
+    const uint32_t count = profiler.frame_count;
+    for (uint32_t i = 0; i < profiler.track_count && count > 0; ++i) {
+      const tb_auto *track = &profiler.tracks[i];
+
+      SDL_memcpy(sorted, track->history_ms, sizeof(sorted));
+      // Unfilled slots are zero and sort to the front; skip past them
+      SDL_qsort(sorted, THS_PROFILER_HISTORY, sizeof(float), compare_floats);
+      const float *valid = &sorted[THS_PROFILER_HISTORY - count];
+      const float p50 = valid[(count - 1) / 2];
+      const float p95 = valid[(uint32_t)((count - 1) * 0.95f)];
+      const float p99 = valid[(uint32_t)((count - 1) * 0.99f)];
+
+      char overlay[64] = {0};
+      SDL_snprintf(overlay, sizeof(overlay), "p50 %.2f p95 %.2f p99 %.2f ms",
+                   (double)p50, (double)p95, (double)p99);
+      igPlotHistogram_FloatPtr(
+          track->name, track->history_ms, THS_PROFILER_HISTORY, profiler.head,
+          overlay, 0.0f, valid[count - 1] * 1.1f + 0.001f,
+          (ImVec2){THS_PROFILER_HISTORY, 32}, sizeof(float));
+    }
+  }
+  igEnd();
+
+  // Closing the overlay stops recording too unless a CSV was asked for. The
+  // main menu turns it back on
+  if (!open) {
+    ths_profiler_set_enabled(false);
+  }
+
+  TracyCZoneEnd(ctx);
+}
+
+void ths_register_profiler_sys(TbWorld *world) {
+  ecs_world_t *ecs = world->ecs;
+  ecs_system(ecs, {.entity = ecs_entity(ecs, {.name = "Profiler Overlay",
+                                              .add = {ecs_dependson(
+                                                  EcsOnUpdate)}}),
+                   .callback = profiler_overlay_tick});
+}
+
+void ths_unregister_profiler_sys(TbWorld *world) { (void)world; }
+
+TB_REGISTER_SYS(ths, profiler, TB_SYSTEM_NORMAL)
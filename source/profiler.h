@@ -0,0 +1,60 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Frames of history kept per track
+#define THS_PROFILER_HISTORY 240
+#define THS_PROFILER_MAX_TRACKS 32
+
+// Built in frame timing for machines without a Tracy server attached
+// Systems time themselves into named tracks; every frame the time spent in
+// each track is pushed into a ring buffer that the overlay and CSV read from
+// When the profiler is off a scope costs one predictable branch
+
+typedef uint32_t ThsProfileTrack;
+
+typedef struct ThsProfileScope {
+  ThsProfileTrack track;
+  uint64_t start; // 0 when the profiler was off as the scope began
+} ThsProfileScope;
+
+extern bool ths_profiler_active;
+
+// Returns the track with the given name, creating it if needed
+// Names must outlive the profiler; string literals are expected
+ThsProfileTrack ths_profiler_track(const char *name);
+
+// Shows or hides the overlay. Recording keeps going while a CSV is pending
+void ths_profiler_set_enabled(bool enabled);
+bool ths_profiler_enabled(void);
+
+// Applies --profile and --profile-csv <path> from the command line
+// A CSV path also turns the profiler on and is written by ths_profiler_finish
+void ths_profiler_configure(int32_t argc, char *argv[]);
+
+// Pushes this frame's accumulated track times into the history
+void ths_profiler_end_frame(void);
+
+// Writes one row per recorded frame and one column per track
+bool ths_profiler_write_csv(const char *path);
+
+// Writes the CSV requested on the command line, if any
+void ths_profiler_finish(void);
+
+uint64_t ths_profile_now(void);
+void ths_profile_record(ThsProfileTrack track, uint64_t start);
+
+static inline ThsProfileScope ths_profile_begin(ThsProfileTrack track) {
+  return (ThsProfileScope){
+      .track = track,
+      .start = ths_profiler_active ? ths_profile_now() : 0,
+  };
+}
+
+// Safe to call from worker threads; times from every thread are summed
+static inline void ths_profile_end(ThsProfileScope scope) {
+  if (scope.start != 0) {
+    ths_profile_record(scope.track, scope.start);
+  }
+}
@@ -0,0 +1,742 @@
+#include "savegame.h"
+
+#include "boatcameracomponent.h"
+#include "boatmovementcomponent.h"
+#include "config.h"
+#include "profiling.h"
+#include "sceneloader.h"
+#include "simulation.h"
+#include "tbcommon.h"
+#include "transformcomponent.h"
+#include "world.h"
+
+#include <SDL3/SDL.h>
+
+#include <stdio.h>
+#include <time.h>
+
+ECS_COMPONENT_DECLARE(ThsSaveSystem);
+
+ECS_SYSTEM_DECLARE(autosave_tick);
+
+// Slots the load game dialog looks for; the autosave always comes first
+static const char *save_slots[THS_SAVE_MAX_SLOTS] = {
+    THS_AUTOSAVE_SLOT,
+    "slot1",
+    "slot2",
+    "slot3",
+};
+
+// A run of zeros packs to one byte and a literal to its length plus one
+#define THS_PACK_MAX_RUN 128
+
+static size_t packed_bound(size_t size) {
+  return size + size / THS_PACK_MAX_RUN + 1;
+}
+
+// Zero runs are stored as 0x80 | (length - 1); anything else is stored as
+// (length - 1) followed by the bytes. Deltas are mostly zeros and even full
+// saves have plenty of them in quaternions and unit scales
+static uint32_t pack_zero_runs(const uint8_t *src, uint32_t size,
+                               uint8_t *dst) {
+  uint32_t out = 0;
+  uint32_t i = 0;
+  while (i < size) {
+    uint32_t run = 0;
+    while (i + run < size && run < THS_PACK_MAX_RUN && src[i + run] == 0) {
+      run++;
+    }
+    // A lone zero is cheaper left inside a literal
+    if (run >= 2) {
+      dst[out++] = (uint8_t)(0x80 | (run - 1));
+      i += run;
+      continue;
+    }
+
+    uint32_t len = 0;
+    while (i + len < size && len < THS_PACK_MAX_RUN) {
+      const bool zero_pair = src[i + len] == 0 && i + len + 1 < size &&
+                             src[i + len + 1] == 0;
+      if (zero_pair) {
+        break;
+      }
+      len++;
+    }
+    dst[out++] = (uint8_t)(len - 1);
+    SDL_memcpy(&dst[out], &src[i], len);
+    out += len;
+    i += len;
+  }
+  return out;
+}
+
+static bool unpack_zero_runs(const uint8_t *src, uint32_t size, uint8_t *dst,
+                             size_t dst_size) {
+  size_t out = 0;
+  uint32_t i = 0;
+  while (i < size) {
+    const uint8_t ctl = src[i++];
+    const uint32_t len = (uint32_t)(ctl & 0x7F) + 1;
+    if (out + len > dst_size) {
+      return false;
+    }
+    if (ctl & 0x80) {
+      SDL_memset(&dst[out], 0, len);
+    } else {
+      if (i + len > size) {
+        return false;
+      }
+      SDL_memcpy(&dst[out], &src[i], len);
+      i += len;
+    }
+    out += len;
+  }
+  return out == dst_size;
+}
+
+static void xor_bytes(uint8_t *dst, const uint8_t *src, size_t size) {
+  for (size_t i = 0; i < size; ++i) {
+    dst[i] ^= src[i];
+  }
+}
+
+static int32_t compare_records(const void *a, const void *b) {
+  const ThsSaveRecord *ra = a;
+  const ThsSaveRecord *rb = b;
+  if (ra->key != rb->key) {
+    return ra->key < rb->key ? -1 : 1;
+  }
+  return (ra->kind > rb->kind) - (ra->kind < rb->kind);
+}
+
+static void copy_snapshot(ThsSnapshot *dst, const ThsSnapshot *src) {
+  dst->sequence = src->sequence;
+  dst->scene_type = src->scene_type;
+  dst->saved_at = src->saved_at;
+  SDL_strlcpy(dst->scene, src->scene, sizeof(dst->scene));
+  TB_DYN_ARR_CLEAR(dst->records);
+  TB_DYN_ARR_FOREACH(src->records, i) {
+    TB_DYN_ARR_APPEND(dst->records, TB_DYN_ARR_AT(src->records, i));
+  }
+}
+
+// Deltas only line up byte for byte when both snapshots hold the same records
+static bool snapshots_match(const ThsSnapshot *a, const ThsSnapshot *b) {
+  const uint32_t count = (uint32_t)TB_DYN_ARR_SIZE(a->records);
+  if (count != TB_DYN_ARR_SIZE(b->records) ||
+      SDL_strcmp(a->scene, b->scene) != 0) {
+    return false;
+  }
+  for (uint32_t i = 0; i < count; ++i) {
+    const tb_auto *ra = &TB_DYN_ARR_AT(a->records, i);
+    const tb_auto *rb = &TB_DYN_ARR_AT(b->records, i);
+    if (ra->key != rb->key || ra->kind != rb->kind) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static void save_path(char *path, size_t size, const char *dir,
+                      const char *slot, ThsSaveKind kind) {
+  SDL_snprintf(path, size, "%s%s%s", dir, slot,
+               kind == THS_SAVE_DELTA ? THS_SAVE_DELTA_EXTENSION
+                                      : THS_SAVE_EXTENSION);
+}
+
+static bool write_save_file(const char *path, const ThsSaveHeader *header,
+                            const uint8_t *packed) {
+  char tmp_path[600] = {0};
+  SDL_snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+  FILE *file = fopen(tmp_path, "wb");
+  if (file == NULL) {
+    return false;
+  }
+  bool ok = fwrite(header, sizeof(*header), 1, file) == 1;
+  if (header->packed_size > 0) {
+    ok = ok && fwrite(packed, header->packed_size, 1, file) == 1;
+  }
+  ok = fclose(file) == 0 && ok;
+  if (!ok) {
+    remove(tmp_path);
+    return false;
+  }
+  // Replacing in one step means a crash mid write keeps the previous save
+#ifdef _WIN32
+  remove(path);
+#endif
+  return rename(tmp_path, path) == 0;
+}
+
+static int32_t save_write_thread(void *data) {
+  TracyCSetThreadName("Save Writer");
+  TracyCZoneNC(ctx, "Save Write", TracyCategoryColorCore, true);
+  ThsSaveJob *job = data;
+  const uint64_t start = SDL_GetPerformanceCounter();
+
+  const tb_auto *snap = &job->snapshot;
+  const uint32_t count = (uint32_t)TB_DYN_ARR_SIZE(snap->records);
+  const uint32_t raw_size = count * (uint32_t)sizeof(ThsSaveRecord);
+  const bool delta = !job->force_full &&
+                     SDL_strcmp(job->base_slot, job->slot) == 0 &&
+                     snapshots_match(snap, &job->base);
+
+  uint8_t *raw = tb_alloc_nm_tp(job->gp_alloc, raw_size + 1, uint8_t);
+  uint8_t *packed =
+      tb_alloc_nm_tp(job->gp_alloc, packed_bound(raw_size), uint8_t);
+  if (count > 0) {
+    SDL_memcpy(raw, &TB_DYN_ARR_AT(snap->records, 0), raw_size);
+    if (delta) {
+      xor_bytes(raw, (const uint8_t *)&TB_DYN_ARR_AT(job->base.records, 0),
+                raw_size);
+    }
+  }
+
+  ThsSaveHeader header = {
+      .magic = THS_SAVE_MAGIC,
+      .version = THS_SAVE_VERSION,
+      .kind = delta ? THS_SAVE_DELTA : THS_SAVE_FULL,
+      .sequence = snap->sequence,
+      .base_sequence = delta ? job->base.sequence : snap->sequence,
+      .record_count = count,
+      .packed_size = pack_zero_runs(raw, raw_size, packed),
+      .scene_type = (int32_t)snap->scene_type,
+      .saved_at = snap->saved_at,
+  };
+  SDL_strlcpy(header.scene, snap->scene, sizeof(header.scene));
+
+  char path[600] = {0};
+  save_path(path, sizeof(path), job->dir, job->slot, header.kind);
+  const bool ok = write_save_file(path, &header, packed);
+  if (ok && !delta) {
+    // The old delta was against the previous base and can't be applied now
+    save_path(path, sizeof(path), job->dir, job->slot, THS_SAVE_DELTA);
+    remove(path);
+    copy_snapshot(&job->base, snap);
+    SDL_strlcpy(job->base_slot, job->slot, sizeof(job->base_slot));
+  }
+
+  tb_free(job->gp_alloc, packed);
+  tb_free(job->gp_alloc, raw);
+
+  job->raw_size = raw_size;
+  job->packed_size = header.packed_size;
+  job->write_ms =
+      (float)((double)(SDL_GetPerformanceCounter() - start) * 1000.0 /
+              (double)SDL_GetPerformanceFrequency());
+  if (ok) {
+    SDL_Log("Save: %s %s %u records, %u -> %u bytes in %.2f ms", job->slot,
+            delta ? "delta" : "full", count, raw_size, header.packed_size,
+            (double)job->write_ms);
+  } else {
+    SDL_Log("Save: failed to write %s", job->slot);
+  }
+
+  atomic_store(&job->busy, 0);
+  TracyCZoneEnd(ctx);
+  return ok ? 0 : -1;
+}
+
+static void join_writer(ThsSaveSystem *save) {
+  if (save->thread) {
+    SDL_WaitThread(save->thread, NULL);
+    save->thread = NULL;
+  }
+}
+
+static uint32_t entity_key(ecs_world_t *ecs, ecs_entity_t ent) {
+  // FNV-1a over the names from the entity up to the root
+  uint32_t h = 0x811C9DC5u;
+  for (; ent != 0; ent = ecs_get_parent(ecs, ent)) {
+    const char *name = ecs_get_name(ecs, ent);
+    for (const char *c = name ? name : ""; *c; ++c) {
+      h ^= (uint8_t)*c;
+      h *= 0x01000193u;
+    }
+    // Keeps "a/bc" and "ab/c" apart
+    h ^= (uint8_t)'/';
+    h *= 0x01000193u;
+  }
+  return h;
+}
+
+static ThsSaveTransform to_save_transform(const TbTransform *t) {
+  return (ThsSaveTransform){
+      .position = {t->position.x, t->position.y, t->position.z},
+      .rotation = {t->rotation.x, t->rotation.y, t->rotation.z,
+                   t->rotation.w},
+      .scale = {t->scale.x, t->scale.y, t->scale.z},
+  };
+}
+
+static void from_save_transform(const ThsSaveTransform *s, TbTransform *t) {
+  t->position = (float3){s->position[0], s->position[1], s->position[2]};
+  t->rotation = (TbQuaternion){s->rotation[0], s->rotation[1],
+                               s->rotation[2], s->rotation[3]};
+  t->scale = (float3){s->scale[0], s->scale[1], s->scale[2]};
+}
+
+// Made on first use; the simulation defines ThsInterpolatedTransform when its
+// system registers, which may be after this one
+static void init_queries(ThsSaveSystem *save, ecs_world_t *ecs) {
+  if (save->interp_query) {
+    return;
+  }
+  save->interp_query =
+      ecs_query(ecs, {.filter.terms =
+                          {
+                              {.id = ecs_id(ThsInterpolatedTransform)},
+                              {.id = ecs_id(TbTransformComponent)},
+                          }});
+  save->boat_query =
+      ecs_query(ecs, {.filter.terms =
+                          {
+                              {.id = ecs_id(ThsBoatMovementComponent)},
+                          }});
+  save->camera_query =
+      ecs_query(ecs, {.filter.terms =
+                          {
+                              {.id = ecs_id(TbTransformComponent)},
+                              {.id = ecs_id(ThsBoatCameraComponent)},
+                          }});
+  save->game_query =
+      ecs_query(ecs, {.filter.terms =
+                          {
+                              {.id = ecs_id(ThsGameSceneSettings)},
+                          }});
+}
+
+static void capture_snapshot(ThsSaveSystem *save, ecs_world_t *ecs,
+                             ThsSnapshot *snap) {
+  TracyCZoneNC(ctx, "Save Capture", TracyCategoryColorCore, true);
+  init_queries(save, ecs);
+  TB_DYN_ARR_CLEAR(snap->records);
+  snap->sequence = save->sequence++;
+  snap->saved_at = (int64_t)time(NULL);
+  snap->scene_type = THS_GS_UNKNOWN;
+
+  const tb_auto *loader = ecs_singleton_get(ecs, ThsSceneLoader);
+  SDL_strlcpy(snap->scene, loader->job->scene, sizeof(snap->scene));
+
+  ecs_iter_t it = ecs_query_iter(ecs, save->game_query);
+  while (ecs_iter_next(&it)) {
+    tb_auto *settings = ecs_field(&it, ThsGameSceneSettings, 1);
+    if (it.count > 0) {
+      snap->scene_type = settings[0].type;
+    }
+  }
+
+  // The simulated state rather than what was blended for rendering
+  it = ecs_query_iter(ecs, save->interp_query);
+  while (ecs_iter_next(&it)) {
+    tb_auto *interps = ecs_field(&it, ThsInterpolatedTransform, 1);
+    for (int32_t i = 0; i < it.count; ++i) {
+      ThsSaveRecord rec = {
+          .key = entity_key(ecs, it.entities[i]),
+          .kind = THS_SAVE_REC_TRANSFORM,
+          .transform = to_save_transform(&interps[i].current),
+      };
+      TB_DYN_ARR_APPEND(snap->records, rec);
+    }
+  }
+
+  it = ecs_query_iter(ecs, save->boat_query);
+  while (ecs_iter_next(&it)) {
+    tb_auto *boats = ecs_field(&it, ThsBoatMovementComponent, 1);
+    for (int32_t i = 0; i < it.count; ++i) {
+      const tb_auto *boat = &boats[i];
+      ThsSaveRecord rec = {
+          .key = entity_key(ecs, it.entities[i]),
+          .kind = THS_SAVE_REC_BOAT,
+          .boat =
+              {
+                  .speed = boat->speed,
+                  .acceleration = boat->acceleration,
+                  .target_height_offset = boat->target_height_offset,
+                  // Saved in 3D; headings only ever turn about up
+                  .target_heading = {boat->target_heading.x, 0.0f,
+                                     boat->target_heading.y},
+              },
+      };
+      TB_DYN_ARR_APPEND(snap->records, rec);
+    }
+  }
+
+  it = ecs_query_iter(ecs, save->camera_query);
+  while (ecs_iter_next(&it)) {
+    tb_auto *transforms = ecs_field(&it, TbTransformComponent, 1);
+    tb_auto *cameras = ecs_field(&it, ThsBoatCameraComponent, 2);
+    for (int32_t i = 0; i < it.count; ++i) {
+      const tb_auto *cam = &cameras[i];
+      ThsSaveRecord rec = {
+          .key = entity_key(ecs, it.entities[i]),
+          .kind = THS_SAVE_REC_CAMERA,
+          .camera =
+              {
+                  .transform = to_save_transform(&transforms[i].transform),
+                  .target_dist = cam->target_dist,
+                  .target_hull_to_camera = {cam->target_hull_to_camera.x,
+                                            cam->target_hull_to_camera.y,
+                                            cam->target_hull_to_camera.z},
+              },
+      };
+      TB_DYN_ARR_APPEND(snap->records, rec);
+    }
+  }
+
+  if (TB_DYN_ARR_SIZE(snap->records) > 0) {
+    SDL_qsort(&TB_DYN_ARR_AT(snap->records, 0), TB_DYN_ARR_SIZE(snap->records),
+              sizeof(ThsSaveRecord), compare_records);
+  }
+  TracyCZoneEnd(ctx);
+}
+
+bool ths_save_game(ThsSaveSystem *save, ecs_world_t *ecs, const char *slot,
+                   bool full) {
+  tb_auto *job = save->job;
+  if (atomic_load(&job->busy)) {
+    return false;
+  }
+  join_writer(save);
+
+  capture_snapshot(save, ecs, &job->snapshot);
+  SDL_strlcpy(job->slot, slot, sizeof(job->slot));
+  job->force_full = full;
+  atomic_store(&job->busy, 1);
+
+  save->thread = SDL_CreateThread(save_write_thread, "Save Writer", job);
+  if (save->thread == NULL) {
+    // Better a hitch than a lost save
+    SDL_Log("Save: failed to create thread: %s", SDL_GetError());
+    save_write_thread(job);
+  }
+  return true;
+}
+
+static bool read_save_file(TbAllocator alloc, const char *path,
+                           ThsSaveHeader *header, ThsSnapshot *snap) {
+  FILE *file = fopen(path, "rb");
+  if (file == NULL) {
+    return false;
+  }
+  bool ok = fread(header, sizeof(*header), 1, file) == 1 &&
+            header->magic == THS_SAVE_MAGIC &&
+            header->version == THS_SAVE_VERSION;
+
+  // Nothing gets sized from the header until it fits the file. Every packed
+  // byte unpacks to at most one run, which bounds the record count
+  size_t raw_size = 0;
+  if (ok) {
+    const long header_end = ftell(file);
+    ok = header_end >= 0 && fseek(file, 0, SEEK_END) == 0;
+    const long file_end = ok ? ftell(file) : -1;
+    ok = ok && file_end >= header_end &&
+         fseek(file, header_end, SEEK_SET) == 0 &&
+         header->packed_size <= (uint64_t)(file_end - header_end) &&
+         header->record_count <= (uint64_t)header->packed_size *
+                                     THS_PACK_MAX_RUN / sizeof(ThsSaveRecord);
+  }
+  if (ok) {
+    raw_size = (size_t)header->record_count * sizeof(ThsSaveRecord);
+    ok = header->packed_size <= packed_bound(raw_size);
+  }
+
+  uint8_t *packed = NULL;
+  if (ok && snap) {
+    packed = tb_alloc_nm_tp(alloc, header->packed_size + 1, uint8_t);
+    ok = header->packed_size == 0 ||
+         fread(packed, header->packed_size, 1, file) == 1;
+  }
+  fclose(file);
+
+  if (ok && snap) {
+    TB_DYN_ARR_CLEAR(snap->records);
+    for (uint32_t i = 0; i < header->record_count; ++i) {
+      TB_DYN_ARR_APPEND(snap->records, (ThsSaveRecord){0});
+    }
+    ok = header->record_count == 0 ||
+         unpack_zero_runs(packed, header->packed_size,
+                          (uint8_t *)&TB_DYN_ARR_AT(snap->records, 0),
+                          raw_size);
+    snap->sequence = header->sequence;
+    snap->scene_type = (ThsGameSceneType)header->scene_type;
+    snap->saved_at = header->saved_at;
+    SDL_strlcpy(snap->scene, header->scene, sizeof(snap->scene));
+  }
+  if (packed) {
+    tb_free(alloc, packed);
+  }
+  return ok;
+}
+
+void ths_scan_saves(ThsSaveSystem *save) {
+  save->slot_count = 0;
+  for (uint32_t i = 0; i < THS_SAVE_MAX_SLOTS; ++i) {
+    char path[600] = {0};
+    ThsSaveHeader full = {0};
+    save_path(path, sizeof(path), save->dir, save_slots[i], THS_SAVE_FULL);
+    if (!read_save_file(save->gp_alloc, path, &full, NULL)) {
+      continue;
+    }
+    tb_auto *info = &save->slots[save->slot_count++];
+    *info = (ThsSaveSlotInfo){
+        .saved_at = full.saved_at,
+        .sequence = full.sequence,
+    };
+    SDL_strlcpy(info->slot, save_slots[i], sizeof(info->slot));
+    SDL_strlcpy(info->scene, full.scene, sizeof(info->scene));
+
+    // A newer delta makes the slot as recent as the delta
+    ThsSaveHeader delta = {0};
+    save_path(path, sizeof(path), save->dir, save_slots[i], THS_SAVE_DELTA);
+    if (read_save_file(save->gp_alloc, path, &delta, NULL) &&
+        delta.base_sequence == full.sequence) {
+      info->saved_at = delta.saved_at;
+      info->sequence = delta.sequence;
+    }
+  }
+
+  // Newest first so continue can take the first slot
+  for (uint32_t i = 1; i < save->slot_count; ++i) {
+    for (uint32_t j = i; j > 0; --j) {
+      if (save->slots[j].saved_at <= save->slots[j - 1].saved_at) {
+        break;
+      }
+      ThsSaveSlotInfo tmp = save->slots[j];
+      save->slots[j] = save->slots[j - 1];
+      save->slots[j - 1] = tmp;
+    }
+  }
+}
+
+const char *ths_load_save(ThsSaveSystem *save, const char *slot) {
+  TracyCZoneNC(ctx, "Save Load", TracyCategoryColorCore, true);
+  tb_auto *snap = &save->restore;
+  save->restore_pending = false;
+
+  char path[600] = {0};
+  ThsSaveHeader full = {0};
+  save_path(path, sizeof(path), save->dir, slot, THS_SAVE_FULL);
+  if (!read_save_file(save->gp_alloc, path, &full, snap)) {
+    SDL_Log("Save: failed to read %s", slot);
+    TracyCZoneEnd(ctx);
+    return NULL;
+  }
+
+  ThsSnapshot delta = {0};
+  TB_DYN_ARR_RESET(delta.records, save->gp_alloc, full.record_count);
+  ThsSaveHeader delta_header = {0};
+  save_path(path, sizeof(path), save->dir, slot, THS_SAVE_DELTA);
+  if (read_save_file(save->gp_alloc, path, &delta_header, &delta) &&
+      delta_header.base_sequence == full.sequence &&
+      delta_header.record_count == full.record_count &&
+      full.record_count > 0) {
+    xor_bytes((uint8_t *)&TB_DYN_ARR_AT(snap->records, 0),
+              (const uint8_t *)&TB_DYN_ARR_AT(delta.records, 0),
+              full.record_count * sizeof(ThsSaveRecord));
+    snap->sequence = delta.sequence;
+    snap->saved_at = delta.saved_at;
+  }
+  TB_DYN_ARR_DESTROY(delta.records);
+
+  save->restore_pending = true;
+  TracyCZoneEnd(ctx);
+  return snap->scene;
+}
+
+static const ThsSaveRecord *find_record(const ThsSnapshot *snap,
+                                        uint32_t key, uint32_t kind) {
+  const ThsSaveRecord target = {.key = key, .kind = kind};
+  uint32_t lo = 0;
+  uint32_t hi = (uint32_t)TB_DYN_ARR_SIZE(snap->records);
+  while (lo < hi) {
+    const uint32_t mid = lo + (hi - lo) / 2;
+    const tb_auto *rec = &TB_DYN_ARR_AT(snap->records, mid);
+    const int32_t cmp = compare_records(rec, &target);
+    if (cmp == 0) {
+      return rec;
+    }
+    if (cmp < 0) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  return NULL;
+}
+
+void ths_restore_pending_save(ThsSaveSystem *save, ecs_world_t *ecs) {
+  if (!save->restore_pending) {
+    return;
+  }
+  TracyCZoneNC(ctx, "Save Restore", TracyCategoryColorCore, true);
+  save->restore_pending = false;
+  init_queries(save, ecs);
+  const tb_auto *snap = &save->restore;
+  uint32_t restored = 0;
+
+  ecs_iter_t it = ecs_query_iter(ecs, save->game_query);
+  while (ecs_iter_next(&it)) {
+    tb_auto *settings = ecs_field(&it, ThsGameSceneSettings, 1);
+    for (int32_t i = 0; i < it.count; ++i) {
+      settings[i].type = snap->scene_type;
+    }
+  }
+
+  it = ecs_query_iter(ecs, save->interp_query);
+  while (ecs_iter_next(&it)) {
+    tb_auto *interps = ecs_field(&it, ThsInterpolatedTransform, 1);
+    tb_auto *transforms = ecs_field(&it, TbTransformComponent, 2);
+    for (int32_t i = 0; i < it.count; ++i) {
+      const tb_auto *rec = find_record(
+          snap, entity_key(ecs, it.entities[i]), THS_SAVE_REC_TRANSFORM);
+      if (rec == NULL) {
+        continue;
+      }
+      from_save_transform(&rec->transform, &interps[i].current);
+      interps[i].previous = interps[i].current;
+      transforms[i].transform = interps[i].current;
+      tb_transform_mark_dirty(ecs, it.entities[i]);
+      restored++;
+    }
+  }
+
+  it = ecs_query_iter(ecs, save->boat_query);
+  while (ecs_iter_next(&it)) {
+    tb_auto *boats = ecs_field(&it, ThsBoatMovementComponent, 1);
+    for (int32_t i = 0; i < it.count; ++i) {
+      const tb_auto *rec = find_record(
+          snap, entity_key(ecs, it.entities[i]), THS_SAVE_REC_BOAT);
+      if (rec == NULL) {
+        continue;
+      }
+      tb_auto *boat = &boats[i];
+      boat->speed = rec->boat.speed;
+      boat->acceleration = rec->boat.acceleration;
+      boat->target_height_offset = rec->boat.target_height_offset;
+      boat->target_heading =
+          (float2){rec->boat.target_heading[0], rec->boat.target_heading[2]};
+      restored++;
+    }
+  }
+
+  it = ecs_query_iter(ecs, save->camera_query);
+  while (ecs_iter_next(&it)) {
+    tb_auto *transforms = ecs_field(&it, TbTransformComponent, 1);
+    tb_auto *cameras = ecs_field(&it, ThsBoatCameraComponent, 2);
+    for (int32_t i = 0; i < it.count; ++i) {
+      const tb_auto *rec = find_record(
+          snap, entity_key(ecs, it.entities[i]), THS_SAVE_REC_CAMERA);
+      if (rec == NULL) {
+        continue;
+      }
+      tb_auto *cam = &cameras[i];
+      from_save_transform(&rec->camera.transform, &transforms[i].transform);
+      cam->target_dist = rec->camera.target_dist;
+      cam->target_hull_to_camera = (float3){
+          rec->camera.target_hull_to_camera[0],
+          rec->camera.target_hull_to_camera[1],
+          rec->camera.target_hull_to_camera[2],
+      };
+      tb_transform_mark_dirty(ecs, it.entities[i]);
+      restored++;
+    }
+  }
+
+  SDL_Log("Save: restored %u of %u records into %s", restored,
+          (uint32_t)TB_DYN_ARR_SIZE(snap->records), snap->scene);
+  TracyCZoneEnd(ctx);
+}
+
+void autosave_tick(ecs_iter_t *it) {
+  ecs_world_t *ecs = it->world;
+  tb_auto gss = ecs_field(it, ThsGameSceneSettings, 1);
+  if (it->count == 0 || gss->type != THS_GS_GAME_WORLD) {
+    return;
+  }
+
+  tb_auto *save = ecs_singleton_get_mut(ecs, ThsSaveSystem);
+  save->autosave_timer += it->delta_time;
+  if (save->autosave_timer < THS_AUTOSAVE_INTERVAL) {
+    return;
+  }
+
+  const bool full = save->autosaves_since_full >= THS_AUTOSAVE_FULL_INTERVAL;
+  // Busy writers just push the autosave to a later frame
+  if (ths_save_game(save, ecs, THS_AUTOSAVE_SLOT, full)) {
+    save->autosave_timer = 0.0f;
+    save->autosaves_since_full = full ? 0 : save->autosaves_since_full + 1;
+  }
+}
+
+static void create_snapshot(TbAllocator alloc, ThsSnapshot *snap) {
+  *snap = (ThsSnapshot){0};
+  TB_DYN_ARR_RESET(snap->records, alloc, 64);
+}
+
+static void destroy_snapshot(ThsSnapshot *snap) {
+  TB_DYN_ARR_DESTROY(snap->records);
+}
+
+void ths_register_save_game_sys(TbWorld *world) {
+  ecs_world_t *ecs = world->ecs;
+  ECS_COMPONENT_DEFINE(ecs, ThsSaveSystem);
+
+  ThsSaveSystem save = {
+      .gp_alloc = world->gp_alloc,
+      .job = tb_alloc_nm_tp(world->gp_alloc, 1, ThsSaveJob),
+      // Unique across sessions so a stale delta never matches a new base
+      .sequence = (uint32_t)time(NULL),
+  };
+
+  char *pref_path = SDL_GetPrefPath("Honeybunch", TB_GAME_NAME);
+  if (pref_path) {
+    SDL_strlcpy(save.dir, pref_path, sizeof(save.dir));
+    SDL_free(pref_path);
+  } else {
+    SDL_Log("Save: no pref path (%s); saving next to the game",
+            SDL_GetError());
+  }
+
+  tb_auto *job = save.job;
+  *job = (ThsSaveJob){.gp_alloc = world->gp_alloc};
+  SDL_strlcpy(job->dir, save.dir, sizeof(job->dir));
+  create_snapshot(world->gp_alloc, &job->snapshot);
+  create_snapshot(world->gp_alloc, &job->base);
+  create_snapshot(world->gp_alloc, &save.restore);
+  // So the main menu knows whether there is anything to continue
+  ths_scan_saves(&save);
+  ecs_singleton_set_ptr(ecs, ThsSaveSystem, &save);
+
+  ecs_system(ecs, {
+                      .entity = ecs_entity(
+                          ecs, {.id = ecs_id(autosave_tick),
+                                .name = "Autosave Tick",
+                                .add = {ecs_dependson(EcsOnUpdate)}}),
+                      .query.filter.terms =
+                          {
+                              {.id = ecs_id(ThsGameSceneSettings)},
+                          },
+                      .callback = autosave_tick,
+                      .no_readonly = true,
+                  });
+}
+
+void ths_unregister_save_game_sys(TbWorld *world) {
+  ecs_world_t *ecs = world->ecs;
+  tb_auto *save = ecs_singleton_get_mut(ecs, ThsSaveSystem);
+  join_writer(save);
+  destroy_snapshot(&save->job->snapshot);
+  destroy_snapshot(&save->job->base);
+  destroy_snapshot(&save->restore);
+  tb_free(save->gp_alloc, save->job);
+  if (save->interp_query) {
+    ecs_query_fini(save->interp_query);
+    ecs_query_fini(save->boat_query);
+    ecs_query_fini(save->camera_query);
+    ecs_query_fini(save->game_query);
+  }
+  ecs_singleton_remove(ecs, ThsSaveSystem);
+}
+
+TB_REGISTER_SYS(ths, save_game, TB_SYSTEM_NORMAL)
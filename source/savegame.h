@@ -0,0 +1,162 @@
+#pragma once
+
+#include "allocator.h"
+#include "dynarray.h"
+#include "gamestate.h"
+
+#include <flecs.h>
+
+#include <stdatomic.h>
+
+typedef struct SDL_Thread SDL_Thread;
+typedef struct TbWorld TbWorld;
+
+// Binary save snapshots of the dynamic game state
+//
+// A snapshot is a flat array of fixed size records sorted by entity key and
+// kind. Entities are keyed by a hash of their names so a snapshot can be
+// applied to a freshly loaded copy of the scene it came from. Everything the
+// scene itself describes (meshes, tuning, cooked components) comes from the
+// scene; only state that changes during play is stored here
+//
+// Autosaves are written as a delta against the slot's last full save: the
+// records are XORed with the base so unchanged bytes become zero runs that
+// pack down to almost nothing. Packing and file IO happen on a background
+// thread so capturing a snapshot is the only work done during a frame
+#define THS_SAVE_MAGIC 0x56534854 // THSV
+#define THS_SAVE_VERSION 1
+#define THS_SAVE_EXTENSION ".thss"
+#define THS_SAVE_DELTA_EXTENSION ".delta.thss"
+
+#define THS_AUTOSAVE_SLOT "autosave"
+#define THS_AUTOSAVE_INTERVAL 30.0f
+// Autosaves between full saves; deltas grow as play drifts from the base
+#define THS_AUTOSAVE_FULL_INTERVAL 10
+
+#define THS_SAVE_MAX_SLOTS 4
+#define THS_SAVE_SLOT_NAME_LEN 32
+
+typedef enum ThsSaveKind {
+  THS_SAVE_FULL,
+  THS_SAVE_DELTA,
+} ThsSaveKind;
+
+typedef enum ThsSaveRecordKind {
+  THS_SAVE_REC_TRANSFORM, // Simulated transform of an interpolated entity
+  THS_SAVE_REC_BOAT,
+  THS_SAVE_REC_CAMERA,
+} ThsSaveRecordKind;
+
+// Stored as plain floats so the layout doesn't depend on simd alignment
+typedef struct ThsSaveTransform {
+  float position[3];
+  float rotation[4];
+  float scale[3];
+} ThsSaveTransform;
+
+typedef struct ThsSaveRecord {
+  uint32_t key;  // Hash of the entity's names from the root down
+  uint32_t kind; // ThsSaveRecordKind
+  union {
+    ThsSaveTransform transform;
+    struct {
+      float speed;
+      float acceleration;
+      float target_height_offset;
+      float target_heading[3];
+    } boat;
+    struct {
+      ThsSaveTransform transform;
+      float target_dist;
+      float target_hull_to_camera[3];
+    } camera;
+  };
+} ThsSaveRecord;
+
+typedef struct ThsSaveHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t kind; // ThsSaveKind
+  uint32_t sequence;
+  uint32_t base_sequence; // Sequence of the full save a delta applies to
+  uint32_t record_count;
+  uint32_t packed_size; // Bytes of packed records following the header
+  int32_t scene_type;   // ThsGameSceneType
+  int64_t saved_at;     // Seconds since the unix epoch
+  char scene[256];      // Asset relative path of the scene to load
+} ThsSaveHeader;
+
+typedef struct ThsSnapshot {
+  uint32_t sequence;
+  ThsGameSceneType scene_type;
+  int64_t saved_at;
+  char scene[256];
+  TB_DYN_ARR_OF(ThsSaveRecord) records;
+} ThsSnapshot;
+
+// State shared with the writer thread. Heap allocated for the same reason
+// as ThsSceneLoadJob
+typedef struct ThsSaveJob {
+  TbAllocator gp_alloc;
+  char dir[512];
+  char slot[THS_SAVE_SLOT_NAME_LEN];
+
+  _Atomic int32_t busy;
+  bool force_full;
+
+  ThsSnapshot snapshot; // Filled by the main thread before a job starts
+  ThsSnapshot base;     // Last full save of the slot; only the writer uses it
+  char base_slot[THS_SAVE_SLOT_NAME_LEN];
+
+  // Written by the writer for logging
+  uint32_t raw_size;
+  uint32_t packed_size;
+  float write_ms;
+} ThsSaveJob;
+
+typedef struct ThsSaveSlotInfo {
+  char slot[THS_SAVE_SLOT_NAME_LEN];
+  char scene[256];
+  int64_t saved_at;
+  uint32_t sequence;
+} ThsSaveSlotInfo;
+
+typedef struct ThsSaveSystem {
+  TbAllocator gp_alloc;
+  SDL_Thread *thread;
+  ThsSaveJob *job;
+
+  ecs_query_t *interp_query;
+  ecs_query_t *boat_query;
+  ecs_query_t *camera_query;
+  ecs_query_t *game_query;
+
+  char dir[512];
+  float autosave_timer;
+  uint32_t sequence;
+  uint32_t autosaves_since_full;
+
+  // Filled by ths_scan_saves for the load game dialog
+  uint32_t slot_count;
+  ThsSaveSlotInfo slots[THS_SAVE_MAX_SLOTS];
+
+  // A loaded snapshot waiting for its scene to be instantiated
+  bool restore_pending;
+  ThsSnapshot restore;
+} ThsSaveSystem;
+extern ECS_COMPONENT_DECLARE(ThsSaveSystem);
+
+// Captures the current state and hands it to the writer thread. Returns
+// false if a previous save is still being written
+bool ths_save_game(ThsSaveSystem *save, ecs_world_t *ecs, const char *slot,
+                   bool full);
+
+// Refreshes save->slots with every slot that has a save on disk, newest first
+void ths_scan_saves(ThsSaveSystem *save);
+
+// Reads a slot, applying its delta if there is one, and holds on to it until
+// ths_restore_pending_save. Returns the scene the save needs loaded or NULL
+const char *ths_load_save(ThsSaveSystem *save, const char *slot);
+
+// Applies a loaded save to the entities of its freshly instantiated scene
+void ths_restore_pending_save(ThsSaveSystem *save, ecs_world_t *ecs);
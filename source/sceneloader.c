@@ -0,0 +1,190 @@
+#include "sceneloader.h"
+
+#include "assets.h"
+#include "mappedfile.h"
+#include "navigation.h"
+#include "profiling.h"
+#include "tbcommon.h"
+#include "world.h"
+
+#include <SDL3/SDL.h>
+
+ECS_COMPONENT_DECLARE(ThsSceneLoader);
+
+#define THS_SCENE_READ_CHUNK (1024 * 1024)
+
+static void set_state(ThsSceneLoadJob *job, ThsSceneLoadState state) {
+  atomic_store(&job->state, (int32_t)state);
+}
+
+static int32_t scene_load_thread(void *data) {
+  TracyCSetThreadName("Scene Loader");
+  TracyCZoneNC(ctx, "Scene Load Background", TracyCategoryColorCore, true);
+  ThsSceneLoadJob *job = data;
+  const uint64_t start = SDL_GetPerformanceCounter();
+
+  char *path = tb_resolve_asset_path(job->gp_alloc, job->scene);
+  ThsMappedFile file = {0};
+  if (!ths_map_file(path, &file)) {
+    SDL_Log("Scene loader: failed to open %s", path);
+    tb_free(job->gp_alloc, path);
+    set_state(job, THS_SCENE_LOAD_FAILED);
+    TracyCZoneEnd(ctx);
+    return -1;
+  }
+  atomic_store(&job->bytes_total, file.size);
+
+  // Chunked so progress moves while big scenes come off disk
+  for (size_t offset = 0; offset < file.size; offset += THS_SCENE_READ_CHUNK) {
+    ths_prefault_mapped_file(&file, offset, THS_SCENE_READ_CHUNK);
+    atomic_store(&job->bytes_read,
+                 SDL_min(offset + THS_SCENE_READ_CHUNK, file.size));
+  }
+
+  // Pages stay in the file cache for the main thread stage after this
+  ths_unmap_file(&file);
+  tb_free(job->gp_alloc, path);
+
+  job->background_ms =
+      (float)((double)(SDL_GetPerformanceCounter() - start) * 1000.0 /
+              (double)SDL_GetPerformanceFrequency());
+  set_state(job, THS_SCENE_LOAD_READY);
+
+  TracyCZoneEnd(ctx);
+  return 0;
+}
+
+static void join_loader(ThsSceneLoader *loader) {
+  if (loader->thread) {
+    SDL_WaitThread(loader->thread, NULL);
+    loader->thread = NULL;
+  }
+}
+
+static void start_read(ThsSceneLoader *loader, const char *scene) {
+  // A read for some other scene may still be in flight
+  join_loader(loader);
+
+  tb_auto *job = loader->job;
+  SDL_strlcpy(job->scene, scene, sizeof(job->scene));
+  atomic_store(&job->bytes_read, 0);
+  atomic_store(&job->bytes_total, 0);
+  loader->frames_waited = 0;
+  set_state(job, THS_SCENE_LOAD_READING);
+
+  loader->thread = SDL_CreateThread(scene_load_thread, "Scene Loader", job);
+  if (loader->thread == NULL) {
+    // Still loadable; the main thread will just do all of the work
+    SDL_Log("Scene loader: failed to create thread: %s", SDL_GetError());
+    set_state(job, THS_SCENE_LOAD_READY);
+  }
+}
+
+void ths_prefetch_scene(ThsSceneLoader *loader, const char *scene) {
+  // Never trade a scene that was asked for for a guess
+  if (loader->commit_pending) {
+    return;
+  }
+  // A scene that failed stays failed until it is requested
+  if (SDL_strcmp(loader->job->scene, scene) == 0 &&
+      ths_scene_load_state(loader) != THS_SCENE_LOAD_IDLE) {
+    return;
+  }
+  start_read(loader, scene);
+}
+
+void ths_request_scene(ThsSceneLoader *loader, const char *scene) {
+  const ThsSceneLoadState state = ths_scene_load_state(loader);
+  if (SDL_strcmp(loader->job->scene, scene) != 0 ||
+      state == THS_SCENE_LOAD_IDLE || state == THS_SCENE_LOAD_FAILED) {
+    start_read(loader, scene);
+  }
+  loader->commit_pending = true;
+  loader->frames_waited = 0;
+}
+
+ThsSceneLoadState ths_scene_load_state(const ThsSceneLoader *loader) {
+  return (ThsSceneLoadState)atomic_load(&loader->job->state);
+}
+
+float ths_scene_load_progress(const ThsSceneLoader *loader) {
+  const tb_auto *job = loader->job;
+  switch (ths_scene_load_state(loader)) {
+  case THS_SCENE_LOAD_READING: {
+    const uint64_t total = atomic_load(&job->bytes_total);
+    const uint64_t read = atomic_load(&job->bytes_read);
+    return total > 0 ? (float)read / (float)total : 0.0f;
+  }
+  case THS_SCENE_LOAD_READY:
+    return 1.0f;
+  default:
+    return 0.0f;
+  }
+}
+
+bool ths_scene_loader_commit(ThsSceneLoader *loader, TbWorld *world) {
+  if (!loader->commit_pending) {
+    return false;
+  }
+  const ThsSceneLoadState state = ths_scene_load_state(loader);
+  if (state == THS_SCENE_LOAD_READING) {
+    return false;
+  }
+  if (state == THS_SCENE_LOAD_FAILED) {
+    // Leave the current scene be rather than clear it for one that can't load
+    SDL_Log("Scene loader: dropping request for %s", loader->job->scene);
+    join_loader(loader);
+    loader->commit_pending = false;
+    return false;
+  }
+  // Give the loading screen a frame to present before the main thread stage
+  // takes over
+  if (loader->frames_waited++ < 1) {
+    return false;
+  }
+
+  TracyCZoneNC(ctx, "Scene Load Instantiate", TracyCategoryColorCore, true);
+  join_loader(loader);
+  loader->commit_pending = false;
+
+  // Clearing the world may move component storage, so hold on to the job
+  // rather than the loader from here on
+  tb_auto *job = loader->job;
+  const uint64_t start = SDL_GetPerformanceCounter();
+  tb_clear_world(world);
+  tb_load_scene(world, job->scene);
+  ths_nav_load_scene(world->ecs, job->scene);
+  const double main_ms = (double)(SDL_GetPerformanceCounter() - start) *
+                         1000.0 / (double)SDL_GetPerformanceFrequency();
+
+  SDL_Log("Scene loader: %s file %.1f KB, read ahead %.1f ms, main thread "
+          "%.1f ms",
+          job->scene, (double)atomic_load(&job->bytes_total) / 1024.0,
+          (double)job->background_ms, main_ms);
+
+  set_state(job, THS_SCENE_LOAD_IDLE);
+  TracyCZoneEnd(ctx);
+  return true;
+}
+
+void ths_register_scene_loader_sys(TbWorld *world) {
+  ecs_world_t *ecs = world->ecs;
+  ECS_COMPONENT_DEFINE(ecs, ThsSceneLoader);
+
+  ThsSceneLoader loader = {
+      .gp_alloc = world->gp_alloc,
+      .job = tb_alloc_nm_tp(world->gp_alloc, 1, ThsSceneLoadJob),
+  };
+  *loader.job = (ThsSceneLoadJob){.gp_alloc = world->gp_alloc};
+  ecs_singleton_set_ptr(ecs, ThsSceneLoader, &loader);
+}
+
+void ths_unregister_scene_loader_sys(TbWorld *world) {
+  ecs_world_t *ecs = world->ecs;
+  tb_auto *loader = ecs_singleton_get_mut(ecs, ThsSceneLoader);
+  join_loader(loader);
+  tb_free(loader->gp_alloc, loader->job);
+  ecs_singleton_remove(ecs, ThsSceneLoader);
+}
+
+TB_REGISTER_SYS(ths, scene_loader, TB_SYSTEM_NORMAL)
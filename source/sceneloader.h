@@ -0,0 +1,71 @@
+#pragma once
+
+#include "allocator.h"
+
+#include <flecs.h>
+
+#include <stdatomic.h>
+
+typedef struct SDL_Thread SDL_Thread;
+typedef struct TbWorld TbWorld;
+
+typedef enum ThsSceneLoadState {
+  THS_SCENE_LOAD_IDLE,
+  THS_SCENE_LOAD_READING, // Background thread is pulling the file into memory
+  THS_SCENE_LOAD_READY,   // The file is in the OS file cache
+  THS_SCENE_LOAD_FAILED,
+} ThsSceneLoadState;
+
+// State shared with the background thread. Heap allocated so it stays put
+// no matter what happens to component storage
+typedef struct ThsSceneLoadJob {
+  TbAllocator gp_alloc;
+  char scene[256]; // Asset relative path of the scene being loaded
+
+  _Atomic int32_t state; // ThsSceneLoadState
+  _Atomic uint64_t bytes_read;
+  _Atomic uint64_t bytes_total;
+
+  // Written by the background stage before it reports ready
+  float background_ms;
+} ThsSceneLoadJob;
+
+// Splits a scene load into a background read ahead and a main thread stage
+//
+// The background stage only pulls the glb into the OS file cache so that
+// tb_load_scene doesn't wait on the disk. Prefetching lets the read happen
+// while the player is still in the menu
+//
+// This is not a hitch free load. tb_clear_world and tb_load_scene parse and
+// instantiate the whole scene on the main thread in a single frame; toybox
+// takes neither a parsed scene nor a per frame budget, so that frame still
+// freezes behind the loading screen. Its length is logged on every commit
+typedef struct ThsSceneLoader {
+  TbAllocator gp_alloc;
+  SDL_Thread *thread;
+  ThsSceneLoadJob *job;
+
+  // Set once a switch to the job's scene was requested
+  bool commit_pending;
+  uint32_t frames_waited;
+} ThsSceneLoader;
+extern ECS_COMPONENT_DECLARE(ThsSceneLoader);
+
+// Starts the background stage for a scene if it isn't already running. Does
+// nothing while a requested switch is pending or once the scene has failed
+void ths_prefetch_scene(ThsSceneLoader *loader, const char *scene);
+
+// Requests a switch to the scene. It happens on a later frame once the
+// background stage is done and the loading screen has had a chance to draw.
+// A scene that failed to load is dropped and the request cleared; requesting
+// it again retries
+void ths_request_scene(ThsSceneLoader *loader, const char *scene);
+
+ThsSceneLoadState ths_scene_load_state(const ThsSceneLoader *loader);
+
+// 0 to 1 across the background read
+float ths_scene_load_progress(const ThsSceneLoader *loader);
+
+// Performs a pending switch if it is ready. Returns true if the world was
+// cleared and the new scene instantiated
+bool ths_scene_loader_commit(ThsSceneLoader *loader, TbWorld *world);
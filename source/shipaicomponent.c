@@ -0,0 +1,81 @@
+#include "shipaicomponent.h"
+
+#include "cookedcomponents.h"
+#include "world.h"
+
+#include <flecs.h>
+#include <json.h>
+
+ECS_COMPONENT_DECLARE(ThsShipAiComponent);
+
+typedef struct ThsShipAiDescriptor {
+  float destination_x;
+  float destination_z;
+  float cruise_throttle;
+  float arrive_radius;
+} ThsShipAiDescriptor;
+ECS_COMPONENT_DECLARE(ThsShipAiDescriptor);
+
+static void parse_ship_ai_desc(json_object *object, ThsShipAiDescriptor *desc) {
+  json_object_object_foreach(object, key, value) {
+    if (SDL_strcmp(key, "destination_x") == 0) {
+      desc->destination_x = (float)json_object_get_double(value);
+    } else if (SDL_strcmp(key, "destination_z") == 0) {
+      desc->destination_z = (float)json_object_get_double(value);
+    } else if (SDL_strcmp(key, "cruise_throttle") == 0) {
+      desc->cruise_throttle = (float)json_object_get_double(value);
+    } else if (SDL_strcmp(key, "arrive_radius") == 0) {
+      desc->arrive_radius = (float)json_object_get_double(value);
+    }
+  }
+}
+
+bool ths_load_ship_ai_comp(TbWorld *world, ecs_entity_t ent,
+                           const char *source_path, const cgltf_node *node,
+                           json_object *object) {
+  // Scenes cooked with COOK_ASSETS carry this already packed
+  ThsShipAiDescriptor desc = {0};
+  const ThsShipAiDescriptor *cooked = ths_find_cooked_component(
+      world, source_path, node, "ThsShipAiDescriptor", sizeof(desc));
+  if (cooked) {
+    desc = *cooked;
+  } else {
+    parse_ship_ai_desc(object, &desc);
+  }
+
+  ThsShipAiComponent comp = {
+      .destination = tb_f3(desc.destination_x, 0.0f, desc.destination_z),
+      .cruise_throttle = desc.cruise_throttle > 0.0f ? desc.cruise_throttle
+                                                     : 1.0f,
+      .arrive_radius = desc.arrive_radius > 0.0f ? desc.arrive_radius : 20.0f,
+  };
+  ecs_set_ptr(world->ecs, ent, ThsShipAiComponent, &comp);
+  return true;
+}
+
+void ths_destroy_ship_ai_comp(TbWorld *world, ecs_entity_t ent) {
+  ecs_remove(world->ecs, ent, ThsShipAiComponent);
+}
+
+ecs_entity_t ths_register_ship_ai_comp(TbWorld *world) {
+  ecs_world_t *ecs = world->ecs;
+  ECS_COMPONENT_DEFINE(ecs, ThsShipAiDescriptor);
+  ECS_COMPONENT_DEFINE(ecs, ThsShipAiComponent);
+
+  ecs_struct(ecs,
+             {
+                 .entity = ecs_id(ThsShipAiDescriptor),
+                 .members =
+                     {
+                         {.name = "destination_x", .type = ecs_id(ecs_f32_t)},
+                         {.name = "destination_z", .type = ecs_id(ecs_f32_t)},
+                         {.name = "cruise_throttle",
+                          .type = ecs_id(ecs_f32_t)},
+                         {.name = "arrive_radius", .type = ecs_id(ecs_f32_t)},
+                     },
+             });
+
+  return ecs_id(ThsShipAiDescriptor);
+}
+
+TB_REGISTER_COMP(ths, ship_ai)
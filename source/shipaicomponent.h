@@ -0,0 +1,15 @@
+#pragma once
+
+#include "simd.h"
+
+#include <flecs.h>
+
+// A ship that steers itself instead of following player input. Lives on
+// the hull next to its ThsBoatMovementComponent
+typedef struct ThsShipAiComponent {
+  float3 destination;    // Only X and Z matter
+  float cruise_throttle; // 0 to 1 while underway
+  float arrive_radius;   // Stops once this close to the destination
+  bool arrived;
+} ThsShipAiComponent;
+extern ECS_COMPONENT_DECLARE(ThsShipAiComponent);
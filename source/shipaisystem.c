@@ -0,0 +1,100 @@
+#include "navigation.h"
+#include "profiler.h"
+#include "profiling.h"
+#include "simulation.h"
+#include "tbcommon.h"
+#include "transformcomponent.h"
+#include "world.h"
+
+#include "boatmovementcomponent.h"
+#include "shipaicomponent.h"
+
+#include <flecs.h>
+
+static ThsProfileTrack ai_track = 0;
+
+// Points every AI ship along the flow field towards its destination. Each
+// ship only reads one cell of a shared field, so this stays cheap no matter
+// how many ships there are; the fields themselves are built on the
+// navigation workers
+void ship_ai_update_tick(ecs_iter_t *it) {
+  TracyCZoneNC(ctx, "Ship AI Update", TracyCategoryColorGame, true);
+  ThsProfileScope prof = ths_profile_begin(ai_track);
+
+  ecs_world_t *ecs = it->world;
+  tb_auto *nav = ecs_singleton_get_mut(ecs, ThsNavigation);
+  const uint64_t step = ecs_singleton_get(ecs, ThsSimClock)->step_count;
+
+  tb_auto *ais = ecs_field(it, ThsShipAiComponent, 1);
+  tb_auto *hulls = ecs_field(it, ThsBoatMovementComponent, 2);
+  // Hulls in a table share a boat
+  const tb_auto *boat_transform = ecs_field(it, TbTransformComponent, 3);
+  const float3 boat_pos = boat_transform->transform.position;
+  const float2 pos = {boat_pos.x, boat_pos.z};
+
+  for (int32_t i = 0; i < it->count; ++i) {
+    tb_auto *ai = &ais[i];
+    tb_auto *hull = &hulls[i];
+    hull->autopilot = true;
+
+    const float2 destination = {ai->destination.x, ai->destination.z};
+    const float2 to_dest = destination - pos;
+    const float dist_sq = to_dest.x * to_dest.x + to_dest.y * to_dest.y;
+    ai->arrived = dist_sq <= ai->arrive_radius * ai->arrive_radius;
+    if (ai->arrived) {
+      hull->throttle = 0.0f;
+      continue;
+    }
+
+    // Straight at the destination until the field is ready or when the
+    // ship is somewhere the field doesn't cover
+    float2 dir = to_dest / SDL_sqrtf(dist_sq);
+    const ThsNavField *field = ths_nav_request_field(nav, step, destination);
+    ths_nav_field_direction(nav, field, pos, &dir);
+    nav->step_lookups++;
+
+    hull->target_heading = dir;
+    hull->throttle = ai->cruise_throttle;
+  }
+
+  ths_profile_end(prof);
+  TracyCZoneEnd(ctx);
+}
+
+// Publishes the navigation counters once every ship has been steered
+void ship_ai_end_tick(ecs_iter_t *it) {
+  tb_auto *nav = ecs_singleton_get_mut(it->world, ThsNavigation);
+  ths_nav_end_step(nav);
+}
+
+void ths_register_ship_ai_sys(TbWorld *world) {
+  ecs_world_t *ecs = world->ecs;
+  ECS_COMPONENT_DEFINE(ecs, ThsShipAiComponent);
+
+  ai_track = ths_profiler_track("Ship AI Update");
+
+  // Steering has to be decided before boat movement reads it
+  ecs_entity_t phase = ths_sim_phase(ecs, THS_SIM_PRE_UPDATE);
+  ecs_system(ecs, {.entity = ecs_entity(ecs, {.name = "Ship AI Tick",
+                                              .add = {ecs_dependson(phase)}}),
+                   .query.filter.terms =
+                       {
+                           {.id = ecs_id(ThsShipAiComponent)},
+                           {.id = ecs_id(ThsBoatMovementComponent)},
+                           {.id = ecs_id(TbTransformComponent),
+                            .inout = EcsIn,
+                            .src.flags = EcsUp,
+                            .src.trav = EcsChildOf},
+                       },
+                   .callback = ship_ai_update_tick});
+  ecs_system(ecs, {.entity = ecs_entity(ecs, {.name = "Ship AI End",
+                                              .add = {ecs_dependson(phase)}}),
+                   .callback = ship_ai_end_tick});
+}
+
+void ths_unregister_ship_ai_sys(TbWorld *world) {
+  ecs_world_t *ecs = world->ecs;
+  (void)ecs;
+}
+
+TB_REGISTER_SYS(ths, ship_ai, TB_SYSTEM_NORMAL)
@@ -0,0 +1,188 @@
+#pragma once
+
+// Thin wrapper over the widest float vector unit we were compiled for so that
+// structure-of-arrays kernels can be written once and run on AVX, SSE2 or
+// NEON. Anything else falls back to one float per lane.
+
+#include <math.h>
+#include <stdint.h>
+
+#if defined(__AVX__)
+#define THS_LANES_AVX
+#include <immintrin.h>
+#define THS_LANE_WIDTH 8
+typedef __m256 ThsLane;
+#elif defined(__SSE2__) || defined(_M_X64) ||                                 \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define THS_LANES_SSE
+#include <emmintrin.h>
+#define THS_LANE_WIDTH 4
+typedef __m128 ThsLane;
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#define THS_LANES_NEON
+#include <arm_neon.h>
+#define THS_LANE_WIDTH 4
+typedef float32x4_t ThsLane;
+#else
+#define THS_LANES_SCALAR
+#define THS_LANE_WIDTH 1
+typedef float ThsLane;
+#endif
+
+// Round a count up so that it can be processed in whole lanes
+static inline uint32_t ths_lane_pad(uint32_t count) {
+  return (count + (THS_LANE_WIDTH - 1)) & ~(uint32_t)(THS_LANE_WIDTH - 1);
+}
+
+#if defined(THS_LANES_AVX)
+
+static inline ThsLane ths_lane_set1(float v) { return _mm256_set1_ps(v); }
+static inline ThsLane ths_lane_load(const float *p) {
+  return _mm256_loadu_ps(p);
+}
+static inline void ths_lane_store(float *p, ThsLane v) {
+  _mm256_storeu_ps(p, v);
+}
+static inline ThsLane ths_lane_add(ThsLane a, ThsLane b) {
+  return _mm256_add_ps(a, b);
+}
+static inline ThsLane ths_lane_sub(ThsLane a, ThsLane b) {
+  return _mm256_sub_ps(a, b);
+}
+static inline ThsLane ths_lane_mul(ThsLane a, ThsLane b) {
+  return _mm256_mul_ps(a, b);
+}
+static inline ThsLane ths_lane_div(ThsLane a, ThsLane b) {
+  return _mm256_div_ps(a, b);
+}
+static inline ThsLane ths_lane_min(ThsLane a, ThsLane b) {
+  return _mm256_min_ps(a, b);
+}
+static inline ThsLane ths_lane_max(ThsLane a, ThsLane b) {
+  return _mm256_max_ps(a, b);
+}
+static inline ThsLane ths_lane_sqrt(ThsLane a) { return _mm256_sqrt_ps(a); }
+static inline ThsLane ths_lane_round(ThsLane a) {
+  return _mm256_round_ps(a, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+}
+
+#elif defined(THS_LANES_SSE)
+
+static inline ThsLane ths_lane_set1(float v) { return _mm_set1_ps(v); }
+static inline ThsLane ths_lane_load(const float *p) { return _mm_loadu_ps(p); }
+static inline void ths_lane_store(float *p, ThsLane v) { _mm_storeu_ps(p, v); }
+static inline ThsLane ths_lane_add(ThsLane a, ThsLane b) {
+  return _mm_add_ps(a, b);
+}
+static inline ThsLane ths_lane_sub(ThsLane a, ThsLane b) {
+  return _mm_sub_ps(a, b);
+}
+static inline ThsLane ths_lane_mul(ThsLane a, ThsLane b) {
+  return _mm_mul_ps(a, b);
+}
+static inline ThsLane ths_lane_div(ThsLane a, ThsLane b) {
+  return _mm_div_ps(a, b);
+}
+static inline ThsLane ths_lane_min(ThsLane a, ThsLane b) {
+  return _mm_min_ps(a, b);
+}
+static inline ThsLane ths_lane_max(ThsLane a, ThsLane b) {
+  return _mm_max_ps(a, b);
+}
+static inline ThsLane ths_lane_sqrt(ThsLane a) { return _mm_sqrt_ps(a); }
+static inline ThsLane ths_lane_round(ThsLane a) {
+  // SSE2 has no round instruction but conversion honors the default
+  // round-to-nearest mode. Inputs are small phase values so this can't
+  // overflow the integer range
+  return _mm_cvtepi32_ps(_mm_cvtps_epi32(a));
+}
+
+#elif defined(THS_LANES_NEON)
+
+static inline ThsLane ths_lane_set1(float v) { return vdupq_n_f32(v); }
+static inline ThsLane ths_lane_load(const float *p) { return vld1q_f32(p); }
+static inline void ths_lane_store(float *p, ThsLane v) { vst1q_f32(p, v); }
+static inline ThsLane ths_lane_add(ThsLane a, ThsLane b) {
+  return vaddq_f32(a, b);
+}
+static inline ThsLane ths_lane_sub(ThsLane a, ThsLane b) {
+  return vsubq_f32(a, b);
+}
+static inline ThsLane ths_lane_mul(ThsLane a, ThsLane b) {
+  return vmulq_f32(a, b);
+}
+static inline ThsLane ths_lane_div(ThsLane a, ThsLane b) {
+  return vdivq_f32(a, b);
+}
+static inline ThsLane ths_lane_min(ThsLane a, ThsLane b) {
+  return vminq_f32(a, b);
+}
+static inline ThsLane ths_lane_max(ThsLane a, ThsLane b) {
+  return vmaxq_f32(a, b);
+}
+static inline ThsLane ths_lane_sqrt(ThsLane a) { return vsqrtq_f32(a); }
+static inline ThsLane ths_lane_round(ThsLane a) { return vrndnq_f32(a); }
+
+#else
+
+static inline ThsLane ths_lane_set1(float v) { return v; }
+static inline ThsLane ths_lane_load(const float *p) { return *p; }
+static inline void ths_lane_store(float *p, ThsLane v) { *p = v; }
+static inline ThsLane ths_lane_add(ThsLane a, ThsLane b) { return a + b; }
+static inline ThsLane ths_lane_sub(ThsLane a, ThsLane b) { return a - b; }
+static inline ThsLane ths_lane_mul(ThsLane a, ThsLane b) { return a * b; }
+static inline ThsLane ths_lane_div(ThsLane a, ThsLane b) { return a / b; }
+static inline ThsLane ths_lane_min(ThsLane a, ThsLane b) {
+  return a < b ? a : b;
+}
+static inline ThsLane ths_lane_max(ThsLane a, ThsLane b) {
+  return a > b ? a : b;
+}
+static inline ThsLane ths_lane_sqrt(ThsLane a) { return sqrtf(a); }
+static inline ThsLane ths_lane_round(ThsLane a) { return nearbyintf(a); }
+
+#endif
+
+// Fused multiply-add in spirit; not all targets have the instruction so this
+// is just a mul + add
+static inline ThsLane ths_lane_madd(ThsLane a, ThsLane b, ThsLane c) {
+  return ths_lane_add(ths_lane_mul(a, b), c);
+}
+
+// sin(x) for x in [-pi/2, pi/2] via a degree 9 odd polynomial
+// Max error is around 1e-5 after range reduction which is far below what the
+// waves can show
+static inline ThsLane ths_lane_sin_half_range(ThsLane x) {
+  const ThsLane x2 = ths_lane_mul(x, x);
+  ThsLane p = ths_lane_set1(2.7557319e-6f);
+  p = ths_lane_madd(p, x2, ths_lane_set1(-1.9841270e-4f));
+  p = ths_lane_madd(p, x2, ths_lane_set1(8.3333333e-3f));
+  p = ths_lane_madd(p, x2, ths_lane_set1(-1.6666667e-1f));
+  p = ths_lane_madd(p, x2, ths_lane_set1(1.0f));
+  return ths_lane_mul(p, x);
+}
+
+// Computes both sin and cos of x for any finite x
+// Range reduction only uses min/max so that every target gets the same
+// branch-free sequence
+static inline void ths_lane_sincos(ThsLane x, ThsLane *s, ThsLane *c) {
+  const ThsLane pi = ths_lane_set1(3.14159265f);
+  const ThsLane half_pi = ths_lane_set1(1.57079633f);
+  const ThsLane two_pi = ths_lane_set1(6.28318531f);
+  const ThsLane inv_two_pi = ths_lane_set1(0.15915494f);
+
+  // Wrap into [-pi, pi]
+  ThsLane q = ths_lane_round(ths_lane_mul(x, inv_two_pi));
+  ThsLane r = ths_lane_sub(x, ths_lane_mul(q, two_pi));
+
+  // sin(r) == sin(pi - r) == sin(-pi - r) so fold into [-pi/2, pi/2]
+  ThsLane sin_arg = ths_lane_min(r, ths_lane_sub(pi, r));
+  sin_arg = ths_lane_max(sin_arg, ths_lane_sub(ths_lane_set1(-3.14159265f),
+                                               sin_arg));
+  *s = ths_lane_sin_half_range(sin_arg);
+
+  // cos(r) == sin(pi/2 - r) which lands in [-pi/2, 3pi/2]
+  ThsLane cos_arg = ths_lane_sub(half_pi, r);
+  cos_arg = ths_lane_min(cos_arg, ths_lane_sub(pi, cos_arg));
+  *c = ths_lane_sin_half_range(cos_arg);
+}
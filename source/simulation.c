@@ -0,0 +1,251 @@
+#include "simulation.h"
+
+#include "profiler.h"
+#include "profiling.h"
+#include "tbcommon.h"
+#include "transformcomponent.h"
+#include "transformwrites.h"
+#include "world.h"
+
+ECS_COMPONENT_DECLARE(ThsSimClock);
+ECS_COMPONENT_DECLARE(ThsInterpolatedTransform);
+
+static ThsProfileTrack advance_track = 0;
+static ThsProfileTrack pipeline_track = 0;
+
+static const char *sim_phase_names[] = {
+    "ThsSimPreUpdate",
+    "ThsSimUpdate",
+    "ThsSimPostUpdate",
+};
+
+ecs_entity_t ths_sim_phase(ecs_world_t *ecs, ThsSimPhase phase) {
+  // Phases are created on first use since systems may register before the
+  // simulation system does. The tag marks phases of the fixed step pipeline
+  // the way EcsPhase marks the phases of the main pipeline
+  ecs_entity_t tag = ecs_entity(ecs, {.name = "ThsSimPhaseTag"});
+  ecs_entity_t ent = ecs_entity(ecs, {.name = sim_phase_names[phase]});
+  if (!ecs_has_id(ecs, ent, tag)) {
+    ecs_add_id(ecs, ent, tag);
+    if (phase > THS_SIM_PRE_UPDATE) {
+      ecs_add_pair(ecs, ent, EcsDependsOn,
+                   ths_sim_phase(ecs, (ThsSimPhase)(phase - 1)));
+    }
+  }
+  return ent;
+}
+
+ecs_entity_t ths_sim_frame_phase(ecs_world_t *ecs) {
+  return ecs_entity(ecs, {.name = "ThsSimFrame"});
+}
+
+void ths_sim_set_rate(ecs_world_t *ecs, float rate_hz, uint32_t max_steps) {
+  tb_auto *clock = ecs_singleton_get_mut(ecs, ThsSimClock);
+  clock->step = 1.0f / SDL_max(rate_hz, 1.0f);
+  clock->max_steps = SDL_max(max_steps, 1u);
+  ecs_singleton_modified(ecs, ThsSimClock);
+}
+
+void ths_sim_configure(ecs_world_t *ecs, int32_t argc, char *argv[]) {
+  const tb_auto *clock = ecs_singleton_get(ecs, ThsSimClock);
+  float rate = 1.0f / clock->step;
+  uint32_t max_steps = clock->max_steps;
+  for (int32_t i = 1; i < argc - 1; ++i) {
+    if (SDL_strcmp(argv[i], "--sim-rate") == 0) {
+      rate = (float)SDL_atof(argv[i + 1]);
+    } else if (SDL_strcmp(argv[i], "--sim-max-steps") == 0) {
+      max_steps = (uint32_t)SDL_strtoul(argv[i + 1], NULL, 10);
+    }
+  }
+  ths_sim_set_rate(ecs, rate, max_steps);
+}
+
+void ths_sim_interpolate(ecs_world_t *ecs, ecs_entity_t entity) {
+  const tb_auto *trans = ecs_get(ecs, entity, TbTransformComponent);
+  if (trans == NULL || ecs_has(ecs, entity, ThsInterpolatedTransform)) {
+    return;
+  }
+  ThsInterpolatedTransform interp = {
+      .previous = trans->transform,
+      .current = trans->transform,
+  };
+  ecs_set_ptr(ecs, entity, ThsInterpolatedTransform, &interp);
+}
+
+static TbTransform blend_transforms(const TbTransform *a, const TbTransform *b,
+                                    float alpha) {
+  return (TbTransform){
+      .position = a->position + (b->position - a->position) * alpha,
+      .scale = a->scale + (b->scale - a->scale) * alpha,
+      .rotation = tb_slerp(a->rotation, b->rotation, alpha),
+  };
+}
+
+// Restore and blend go through the transform write list so entities that
+// end up where they were last rendered are never marked dirty
+typedef enum ThsInterpOp {
+  THS_INTERP_RESTORE,  // Put the simulated state back before stepping
+  THS_INTERP_PREVIOUS, // Remember the state before a step
+  THS_INTERP_CURRENT,  // Remember the state after all steps
+  THS_INTERP_BLEND,    // Write the blended state for rendering
+} ThsInterpOp;
+
+static void apply_interp_op(ecs_world_t *ecs, const ThsSimClock *clock,
+                            ThsInterpOp op) {
+  ecs_iter_t it = ecs_query_iter(ecs, clock->interp_query);
+  while (ecs_iter_next(&it)) {
+    tb_auto *transforms = ecs_field(&it, TbTransformComponent, 1);
+    tb_auto *interps = ecs_field(&it, ThsInterpolatedTransform, 2);
+    for (int32_t i = 0; i < it.count; ++i) {
+      tb_auto *trans = &transforms[i].transform;
+      tb_auto *interp = &interps[i];
+      switch (op) {
+      case THS_INTERP_RESTORE:
+        ths_write_transform(ecs, it.entities[i], &interp->current);
+        break;
+      case THS_INTERP_PREVIOUS:
+        interp->previous = *trans;
+        break;
+      case THS_INTERP_CURRENT:
+        interp->current = *trans;
+        break;
+      case THS_INTERP_BLEND: {
+        const TbTransform blended = blend_transforms(
+            &interp->previous, &interp->current, clock->alpha);
+        ths_write_transform(ecs, it.entities[i], &blended);
+        break;
+      }
+      }
+    }
+  }
+  if (op == THS_INTERP_RESTORE) {
+    // Steps read the simulated state straight from the components
+    ths_apply_transform_writes(ecs);
+  }
+}
+
+uint32_t ths_sim_advance(ecs_world_t *ecs, float frame_delta) {
+  TracyCZoneNC(ctx, "Simulation Advance", TracyCategoryColorGame, true);
+  ThsProfileScope prof = ths_profile_begin(advance_track);
+
+  tb_auto *clock = ecs_singleton_get_mut(ecs, ThsSimClock);
+  clock->accumulator += frame_delta;
+
+  // Counted up front so frame systems know how many steps share the input
+  clock->frame_steps = 0;
+  clock->frame_step = 0;
+  for (float acc = clock->accumulator;
+       acc >= clock->step && clock->frame_steps < clock->max_steps;
+       acc -= clock->step) {
+    clock->frame_steps++;
+  }
+  ecs_run_pipeline(ecs, clock->frame_pipeline, frame_delta);
+
+  uint32_t steps = 0;
+  if (clock->accumulator >= clock->step) {
+    apply_interp_op(ecs, clock, THS_INTERP_RESTORE);
+
+    while (clock->accumulator >= clock->step && steps < clock->max_steps) {
+      apply_interp_op(ecs, clock, THS_INTERP_PREVIOUS);
+      ThsProfileScope step_prof = ths_profile_begin(pipeline_track);
+      ecs_run_pipeline(ecs, clock->pipeline, clock->step);
+      // Picks up anything written late in the step, like the cameras
+      ths_apply_transform_writes(ecs);
+      ths_profile_end(step_prof);
+      clock->accumulator -= clock->step;
+      clock->step_count++;
+      clock->frame_step++;
+      steps++;
+    }
+
+    // Don't try to catch up after a long stall; that only makes the next
+    // frame slower too
+    if (clock->accumulator >= clock->step) {
+      clock->accumulator = SDL_fmodf(clock->accumulator, clock->step);
+    }
+
+    apply_interp_op(ecs, clock, THS_INTERP_CURRENT);
+  }
+
+  clock->alpha = clock->accumulator / clock->step;
+  apply_interp_op(ecs, clock, THS_INTERP_BLEND);
+  // Everything written this frame reaches world matrices here, once
+  ths_propagate_transforms(ecs);
+
+  TracyCPlot("Simulation Steps", (double)steps);
+  ths_profile_end(prof);
+  TracyCZoneEnd(ctx);
+  return steps;
+}
+
+void ths_register_simulation_sys(TbWorld *world) {
+  ecs_world_t *ecs = world->ecs;
+  ECS_COMPONENT_DEFINE(ecs, ThsSimClock);
+  ECS_COMPONENT_DEFINE(ecs, ThsInterpolatedTransform);
+
+  // Advance covers interpolation too; the pipeline track is only the steps
+  advance_track = ths_profiler_track("Simulation Advance");
+  pipeline_track = ths_profiler_track("Simulation Pipeline");
+
+  // Same shape as the builtin pipeline but only picks up systems in the
+  // fixed step phases
+  ecs_entity_t phase_tag = ecs_entity(ecs, {.name = "ThsSimPhaseTag"});
+  ecs_entity_t pipeline = ecs_pipeline(
+      ecs, {.entity = ecs_entity(ecs, {.name = "ThsSimPipeline"}),
+            .query = {
+                .filter.terms =
+                    {
+                        {.id = EcsSystem},
+                        {.id = phase_tag,
+                         .src.flags = EcsCascade,
+                         .src.trav = EcsDependsOn},
+                        {.id = EcsDisabled,
+                         .src.flags = EcsUp,
+                         .src.trav = EcsDependsOn,
+                         .oper = EcsNot},
+                        {.id = EcsDisabled,
+                         .src.flags = EcsUp,
+                         .src.trav = EcsChildOf,
+                         .oper = EcsNot},
+                    },
+            }});
+
+  // Systems of the frame phase only, once per advance
+  ecs_entity_t frame_pipeline = ecs_pipeline(
+      ecs, {.entity = ecs_entity(ecs, {.name = "ThsSimFramePipeline"}),
+            .query = {
+                .filter.terms =
+                    {
+                        {.id = EcsSystem},
+                        {.id = ecs_pair(EcsDependsOn,
+                                        ths_sim_frame_phase(ecs))},
+                        {.id = EcsDisabled,
+                         .src.flags = EcsUp,
+                         .src.trav = EcsChildOf,
+                         .oper = EcsNot},
+                    },
+            }});
+
+  ThsSimClock clock = {
+      .pipeline = pipeline,
+      .frame_pipeline = frame_pipeline,
+      .interp_query =
+          ecs_query(ecs, {.filter.terms =
+                              {
+                                  {.id = ecs_id(TbTransformComponent)},
+                                  {.id = ecs_id(ThsInterpolatedTransform)},
+                              }}),
+      .step = 1.0f / THS_SIM_DEFAULT_RATE,
+      .max_steps = THS_SIM_DEFAULT_MAX_STEPS,
+  };
+  ecs_singleton_set_ptr(ecs, ThsSimClock, &clock);
+}
+
+void ths_unregister_simulation_sys(TbWorld *world) {
+  ecs_world_t *ecs = world->ecs;
+  tb_auto *clock = ecs_singleton_get_mut(ecs, ThsSimClock);
+  ecs_query_fini(clock->interp_query);
+  ecs_singleton_remove(ecs, ThsSimClock);
+}
+
+TB_REGISTER_SYS(ths, simulation, TB_SYSTEM_NORMAL)
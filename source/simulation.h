@@ -0,0 +1,61 @@
+#pragma once
+
+#include "simd.h"
+
+#include <flecs.h>
+
+#define THS_SIM_DEFAULT_RATE 60.0f
+#define THS_SIM_DEFAULT_MAX_STEPS 4
+
+// Game simulation systems don't run in the main pipeline. They are placed in
+// one of these phases and stepped at a fixed rate by ths_sim_advance
+typedef enum ThsSimPhase {
+  THS_SIM_PRE_UPDATE,
+  THS_SIM_UPDATE,
+  THS_SIM_POST_UPDATE,
+} ThsSimPhase;
+
+typedef struct ThsSimClock {
+  ecs_entity_t pipeline;
+  ecs_entity_t frame_pipeline;
+  ecs_query_t *interp_query;
+
+  float step;         // Seconds per fixed step
+  uint32_t max_steps; // Most steps taken in one frame before dropping time
+  float accumulator;  // Frame time not yet simulated
+  float alpha;        // How far rendering is between the last two steps
+  uint64_t step_count;
+
+  uint32_t frame_steps; // Steps the current frame takes
+  uint32_t frame_step;  // Steps the current frame has already taken
+} ThsSimClock;
+extern ECS_COMPONENT_DECLARE(ThsSimClock);
+
+// Entities whose transforms are driven by the simulation carry this so that
+// rendering can blend between the last two simulated states
+typedef struct ThsInterpolatedTransform {
+  TbTransform previous;
+  TbTransform current;
+} ThsInterpolatedTransform;
+extern ECS_COMPONENT_DECLARE(ThsInterpolatedTransform);
+
+// Phase entity to use as the DependsOn target of a fixed step system
+ecs_entity_t ths_sim_phase(ecs_world_t *ecs, ThsSimPhase phase);
+
+// Systems in this phase run once per ths_sim_advance, before any step and
+// with the frame's delta. Per frame input is gathered here so that steps can
+// share it out; it is kept on frames that take no steps
+ecs_entity_t ths_sim_frame_phase(ecs_world_t *ecs);
+
+void ths_sim_set_rate(ecs_world_t *ecs, float rate_hz, uint32_t max_steps);
+
+// Applies --sim-rate <hz> and --sim-max-steps <n> from the command line
+void ths_sim_configure(ecs_world_t *ecs, int32_t argc, char *argv[]);
+
+// Starts blending the transform of an entity between simulation steps
+void ths_sim_interpolate(ecs_world_t *ecs, ecs_entity_t entity);
+
+// Consumes frame time by running as many fixed steps as fit, capped at
+// max_steps, then writes interpolated transforms for rendering
+// Returns the number of steps taken
+uint32_t ths_sim_advance(ecs_world_t *ecs, float frame_delta);
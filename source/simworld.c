@@ -0,0 +1,257 @@
+#include "simworld.h"
+
+#include "inputsystem.h"
+#include "oceancomponent.h"
+#include "simulation.h"
+#include "tbcommon.h"
+#include "transformcomponent.h"
+#include "visualloggingsystem.h"
+
+#include "boatcameracomponent.h"
+#include "boatmovementcomponent.h"
+#include "gamestate.h"
+#include "shipaicomponent.h"
+
+#include <SDL3/SDL_cpuinfo.h>
+
+// Normally toybox registers these while creating a world, so no header
+// declares them
+ecs_entity_t ths_register_boat_movement_comp(TbWorld *world);
+ecs_entity_t ths_register_boat_camera_comp(TbWorld *world);
+ecs_entity_t ths_register_game_state_comp(TbWorld *world);
+ecs_entity_t ths_register_ship_ai_comp(TbWorld *world);
+void ths_register_cooked_components_sys(TbWorld *world);
+void ths_unregister_cooked_components_sys(TbWorld *world);
+void ths_register_transform_writes_sys(TbWorld *world);
+void ths_unregister_transform_writes_sys(TbWorld *world);
+void ths_register_simulation_sys(TbWorld *world);
+void ths_unregister_simulation_sys(TbWorld *world);
+void ths_register_ocean_cache_sys(TbWorld *world);
+void ths_unregister_ocean_cache_sys(TbWorld *world);
+void ths_register_wind_sys(TbWorld *world);
+void ths_unregister_wind_sys(TbWorld *world);
+void ths_register_spatial_hash_sys(TbWorld *world);
+void ths_unregister_spatial_hash_sys(TbWorld *world);
+void ths_register_navigation_sys(TbWorld *world);
+void ths_unregister_navigation_sys(TbWorld *world);
+void ths_register_ship_ai_sys(TbWorld *world);
+void ths_unregister_ship_ai_sys(TbWorld *world);
+void ths_register_boat_lod_sys(TbWorld *world);
+void ths_unregister_boat_lod_sys(TbWorld *world);
+void ths_register_boat_movement_sys(TbWorld *world);
+void ths_unregister_boat_movement_sys(TbWorld *world);
+void ths_register_boat_camera_sys(TbWorld *world);
+void ths_unregister_boat_camera_sys(TbWorld *world);
+void ths_register_vlog_sys(TbWorld *world);
+void ths_unregister_vlog_sys(TbWorld *world);
+
+// Stands in for the toybox ocean system which isn't registered here
+void sim_ocean_time_tick(ecs_iter_t *it) {
+  tb_auto *oceans = ecs_field(it, TbOceanComponent, 1);
+  for (int32_t i = 0; i < it->count; ++i) {
+    oceans[i].time += it->delta_time;
+  }
+}
+
+bool ths_create_sim_world(const ThsSimWorldDesc *desc, TbWorld *world) {
+  ecs_world_t *ecs = ecs_init();
+  if (ecs == NULL) {
+    return false;
+  }
+
+  *world = (TbWorld){
+      .ecs = ecs,
+      .gp_alloc = desc->gp_alloc,
+      .tmp_alloc = ths_frame_alloc(desc->frame_mem),
+  };
+
+  // Engine components and singletons the game systems read
+  ECS_COMPONENT_DEFINE(ecs, TbTransformComponent);
+  ECS_COMPONENT_DEFINE(ecs, TbOceanComponent);
+  ECS_COMPONENT_DEFINE(ecs, TbInputSystem);
+  ECS_COMPONENT_DEFINE(ecs, TbVisualLoggingSystem);
+
+  // No devices are attached so input stays neutral, and with logging left
+  // off the vlog calls are no-ops
+  TbInputSystem input = {0};
+  ecs_singleton_set_ptr(ecs, TbInputSystem, &input);
+  TbVisualLoggingSystem vlog = {0};
+  ecs_singleton_set_ptr(ecs, TbVisualLoggingSystem, &vlog);
+
+  // Component loaders read cooked descriptors through the world
+  ths_register_cooked_components_sys(world);
+  ths_register_boat_movement_comp(world);
+  ths_register_boat_camera_comp(world);
+  ths_register_game_state_comp(world);
+  ths_register_ship_ai_comp(world);
+
+  // Order matters; the ocean cache must exist before the boats look it up
+  ths_register_transform_writes_sys(world);
+  ths_register_simulation_sys(world);
+  ecs_system(ecs, {.entity = ecs_entity(
+                       ecs, {.name = "sim_ocean_time_tick",
+                             .add = {ecs_dependson(ths_sim_phase(
+                                 ecs, THS_SIM_PRE_UPDATE))}}),
+                   .query.filter.terms =
+                       {
+                           {.id = ecs_id(TbOceanComponent)},
+                       },
+                   .callback = sim_ocean_time_tick});
+  ths_register_ocean_cache_sys(world);
+  ths_register_wind_sys(world);
+  ths_register_spatial_hash_sys(world);
+  ths_register_navigation_sys(world);
+  ths_register_ship_ai_sys(world);
+  ths_register_boat_lod_sys(world);
+  ths_register_boat_movement_sys(world);
+  ths_register_boat_camera_sys(world);
+  ths_register_vlog_sys(world);
+
+  int32_t thread_count = desc->thread_count;
+  if (thread_count <= 0) {
+    thread_count = SDL_GetCPUCount();
+  }
+  ecs_set_threads(ecs, thread_count);
+  ths_attach_frame_memory(desc->frame_mem, ecs);
+
+  return true;
+}
+
+void ths_destroy_sim_world(TbWorld *world) {
+  ths_unregister_vlog_sys(world);
+  ths_unregister_boat_camera_sys(world);
+  ths_unregister_boat_movement_sys(world);
+  ths_unregister_boat_lod_sys(world);
+  ths_unregister_ship_ai_sys(world);
+  ths_unregister_navigation_sys(world);
+  ths_unregister_spatial_hash_sys(world);
+  ths_unregister_wind_sys(world);
+  ths_unregister_ocean_cache_sys(world);
+  ths_unregister_simulation_sys(world);
+  ths_unregister_transform_writes_sys(world);
+  ths_unregister_cooked_components_sys(world);
+  ecs_fini(world->ecs);
+  *world = (TbWorld){0};
+}
+
+static TbTransformComponent make_transform(float3 position) {
+  return (TbTransformComponent){
+      .transform =
+          {
+              .position = position,
+              .scale = {1, 1, 1},
+              .rotation = {0, 0, 0, 1},
+          },
+  };
+}
+
+ecs_entity_t ths_spawn_sim_ocean(TbWorld *world) {
+  ecs_world_t *ecs = world->ecs;
+
+  // Roughly what the ocean in the boat scene looks like
+  TbOceanComponent ocean = {
+      .wave_count = 4,
+      .waves =
+          {
+              {.steepness = 0.4f,
+               .wavelength = 60.0f,
+               .direction_x = 1.0f,
+               .direction_y = 0.2f},
+              {.steepness = 0.3f,
+               .wavelength = 31.0f,
+               .direction_x = 0.8f,
+               .direction_y = 0.6f},
+              {.steepness = 0.2f,
+               .wavelength = 18.0f,
+               .direction_x = -0.3f,
+               .direction_y = 1.0f},
+              {.steepness = 0.1f,
+               .wavelength = 9.0f,
+               .direction_x = 0.5f,
+               .direction_y = -0.9f},
+          },
+  };
+  TbTransformComponent trans = make_transform((float3){0});
+
+  ecs_entity_t ent = ecs_new_entity(ecs, "Ocean");
+  ecs_set_ptr(ecs, ent, TbTransformComponent, &trans);
+  ecs_set_ptr(ecs, ent, TbOceanComponent, &ocean);
+  return ent;
+}
+
+void ths_spawn_fleet(TbWorld *world, const ThsFleetDesc *desc) {
+  ecs_world_t *ecs = world->ecs;
+
+  const uint32_t row_len =
+      (uint32_t)SDL_ceilf(SDL_sqrtf((float)desc->boat_count));
+  const float half_extent = (float)row_len * desc->spacing * 0.5f;
+
+  // Every ship of the fleet is of one class
+  const ThsBoatTuningComponent hull_tuning = {
+      .max_acceleration = 1.0f,
+      .max_speed = 25.0f,
+      .inertia = 0.1f,
+      .friction = 0.1f,
+      .half_width = 1.0f,
+      .half_length = 1.0f,
+      .half_height = 0.5f,
+      .density = 500.0f,
+  };
+  const ThsBoatCameraTuningComponent camera_tuning = {
+      .min_dist = 5.0f,
+      .max_dist = 50.0f,
+      .move_speed = 1.0f,
+      .zoom_speed = 1.0f,
+      .pitch_limit = 1.2f,
+  };
+  const ecs_entity_t hull_class = ths_boat_class_prefab(ecs, &hull_tuning);
+  const ecs_entity_t camera_class =
+      ths_boat_camera_class_prefab(ecs, &camera_tuning);
+  ThsBoatMovementComponent hull_comp = {
+      .heading_change_speed = 0.5f,
+  };
+  ThsBoatCameraComponent camera_comp = {0};
+
+  // AI ships split between the corners of the fleet so they share a few
+  // flow fields
+  const float3 destinations[4] = {
+      tb_f3(-half_extent, 0, -half_extent),
+      tb_f3(half_extent, 0, -half_extent),
+      tb_f3(half_extent, 0, half_extent),
+      tb_f3(-half_extent, 0, half_extent),
+  };
+
+  for (uint32_t i = 0; i < desc->boat_count; ++i) {
+    const float x = (float)(i % row_len) * desc->spacing - half_extent;
+    const float z = (float)(i / row_len) * desc->spacing - half_extent;
+
+    TbTransformComponent boat_trans = make_transform(tb_f3(x, 0, z));
+    ecs_entity_t boat = ecs_new_id(ecs);
+    ecs_set_ptr(ecs, boat, TbTransformComponent, &boat_trans);
+
+    TbTransformComponent hull_trans = make_transform((float3){0});
+    ecs_entity_t hull = ecs_new_w_pair(ecs, EcsChildOf, boat);
+    ecs_set_ptr(ecs, hull, TbTransformComponent, &hull_trans);
+    ecs_add_pair(ecs, hull, EcsIsA, hull_class);
+    ecs_set_ptr(ecs, hull, ThsBoatMovementComponent, &hull_comp);
+
+    if (desc->with_ai) {
+      ThsShipAiComponent ai = {
+          .destination = destinations[i % SDL_arraysize(destinations)],
+          .cruise_throttle = 1.0f,
+          .arrive_radius = desc->spacing,
+      };
+      ecs_set_ptr(ecs, hull, ThsShipAiComponent, &ai);
+    }
+
+    if (desc->with_cameras || (desc->with_player && i == 0)) {
+      TbTransformComponent cam_trans = make_transform(tb_f3(0, 5, -10));
+      ecs_entity_t cam = ecs_new_w_pair(ecs, EcsChildOf, hull);
+      ecs_set_ptr(ecs, cam, TbTransformComponent, &cam_trans);
+      ecs_add_pair(ecs, cam, EcsIsA, camera_class);
+      ecs_set_ptr(ecs, cam, ThsBoatCameraComponent, &camera_comp);
+    }
+
+    tb_transform_mark_dirty(ecs, boat);
+  }
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "allocator.h"
+#include "framememory.h"
+#include "world.h"
+
+#include <flecs.h>
+
+// A world with only the game simulation systems registered. No window,
+// renderer, audio or UI is created so this can run on machines without a GPU
+typedef struct ThsSimWorldDesc {
+  TbAllocator gp_alloc;
+  ThsFrameMemory *frame_mem; // Supplies tmp_alloc and per stage scratch
+  int32_t thread_count;      // 0 picks one per core
+} ThsSimWorldDesc;
+
+// Describes a generated scene: a single ocean plus a grid of boats
+typedef struct ThsFleetDesc {
+  uint32_t boat_count;
+  float spacing;     // Distance between boats on the grid
+  bool with_cameras; // Attach a ThsBoatCameraComponent to every hull
+  bool with_ai;      // Attach a ThsShipAiComponent to every hull
+  bool with_player;  // Attach a camera to the first hull so input steers it
+} ThsFleetDesc;
+
+bool ths_create_sim_world(const ThsSimWorldDesc *desc, TbWorld *world);
+void ths_destroy_sim_world(TbWorld *world);
+
+// Creates an ocean with a default set of waves
+ecs_entity_t ths_spawn_sim_ocean(TbWorld *world);
+
+// Creates `boat_count` boats, each a root entity with a hull child
+void ths_spawn_fleet(TbWorld *world, const ThsFleetDesc *desc);
@@ -0,0 +1,371 @@
+#include "spatialaudio.h"
+
+#include "assets.h"
+#include "boatcameracomponent.h"
+#include "boatmovementcomponent.h"
+#include "profiler.h"
+#include "profiling.h"
+#include "spatialhash.h"
+#include "tbcommon.h"
+#include "transformcomponent.h"
+#include "world.h"
+
+#include <SDL3/SDL.h>
+
+ECS_COMPONENT_DECLARE(ThsAudioSystem);
+
+static ThsProfileTrack update_track = 0;
+
+// Playing sounds rank this much louder than they are so two sounds of about
+// the same loudness don't trade a voice back and forth every frame
+#define KEEP_BIAS 1.5f
+// Voices fade rather than cut so handing one over doesn't click
+#define FADE_MS 60
+// The wake is at its loudest from this speed in m/s
+#define WAKE_FULL_SPEED 10.0f
+// Hulls creak a little all the time and more when turning hard
+#define CREAK_BASE 0.2f
+#define CREAK_TURN 0.4f
+#define SOUND_SECONDS 2
+
+typedef struct ThsAudioCandidate {
+  ecs_entity_t hull;
+  ThsBoatSound sound;
+  float gain;
+  float pan;
+  float rank;
+  int32_t voice; // Already playing on this voice, or -1
+} ThsAudioCandidate;
+
+static float synth_sample(ThsBoatSound sound, float t, uint32_t *seed,
+                          float *state) {
+  *seed = *seed * 1664525u + 1013904223u;
+  const float noise = (float)(*seed >> 8) / (float)(1u << 23) - 1.0f;
+  if (sound == THS_BOAT_SOUND_WAKE) {
+    // Low passed noise that swells once per loop
+    *state += 0.08f * (noise - *state);
+    const float swell =
+        0.75f + 0.25f * SDL_sinf(2.0f * SDL_PI_F * t / SOUND_SECONDS);
+    return *state * 3.0f * swell;
+  }
+  // Two creaks a loop; a falling sawtooth with some grit
+  static const float starts[] = {0.2f, 1.1f};
+  const float length = 0.35f;
+  for (uint32_t i = 0; i < SDL_arraysize(starts); ++i) {
+    const float progress = (t - starts[i]) / length;
+    if (progress < 0.0f || progress >= 1.0f) {
+      continue;
+    }
+    const float pitch = 110.0f - 40.0f * progress;
+    const float phase = t * pitch - SDL_floorf(t * pitch);
+    const float envelope = SDL_sinf(SDL_PI_F * progress);
+    return (phase * 2.0f - 1.0f + noise * 0.3f) * envelope * 0.6f;
+  }
+  return 0.0f;
+}
+
+// The game ships no recorded boat sounds, so the loops are made at startup
+// in whatever format the mixer runs at
+static void synth_sound(ThsAudioSystem *audio, ThsBoatSound sound,
+                        int32_t freq, int32_t channels) {
+  const uint32_t frames = (uint32_t)freq * SOUND_SECONDS;
+  const uint32_t size = frames * (uint32_t)channels * sizeof(int16_t);
+  int16_t *samples =
+      tb_alloc_nm_tp(audio->gp_alloc, frames * (uint32_t)channels, int16_t);
+  uint32_t seed = 0x7a11 + (uint32_t)sound;
+  float state = 0.0f;
+  for (uint32_t f = 0; f < frames; ++f) {
+    const float t = (float)f / (float)freq;
+    const float value =
+        SDL_clamp(synth_sample(sound, t, &seed, &state), -1.0f, 1.0f);
+    for (int32_t c = 0; c < channels; ++c) {
+      samples[f * (uint32_t)channels + (uint32_t)c] =
+          (int16_t)(value * 32767.0f);
+    }
+  }
+  audio->sound_data[sound] = (uint8_t *)samples;
+  audio->sounds[sound] = Mix_QuickLoad_RAW((uint8_t *)samples, size);
+}
+
+static void open_device(ThsAudioSystem *audio) {
+  if (SDL_InitSubSystem(SDL_INIT_AUDIO) != 0) {
+    SDL_Log("Audio: failed to initialize audio: %s", SDL_GetError());
+    return;
+  }
+  const SDL_AudioSpec spec = {
+      .format = SDL_AUDIO_S16,
+      .channels = 2,
+      .freq = 48000,
+  };
+  if (Mix_OpenAudio(SDL_AUDIO_DEVICE_DEFAULT_OUTPUT, &spec) != 0) {
+    SDL_Log("Audio: failed to open device: %s", SDL_GetError());
+    SDL_QuitSubSystem(SDL_INIT_AUDIO);
+    return;
+  }
+  audio->device_open = true;
+  Mix_AllocateChannels(THS_AUDIO_VOICE_COUNT);
+
+  int32_t freq = 0;
+  SDL_AudioFormat format = 0;
+  int32_t channels = 0;
+  Mix_QuerySpec(&freq, &format, &channels);
+  if (format == SDL_AUDIO_S16) {
+    for (uint32_t i = 0; i < THS_BOAT_SOUND_COUNT; ++i) {
+      synth_sound(audio, (ThsBoatSound)i, freq, channels);
+    }
+  } else {
+    SDL_Log("Audio: mixer runs at format %x; boats stay silent", format);
+  }
+
+  // Music is decoded as it plays, so a long track costs a small buffer
+  char *path = tb_resolve_asset_path(audio->gp_alloc, THS_AUDIO_AMBIENCE);
+  audio->ambience = Mix_LoadMUS(path);
+  if (audio->ambience) {
+    Mix_PlayMusic(audio->ambience, -1);
+    Mix_VolumeMusic(MIX_MAX_VOLUME / 2);
+  } else {
+    SDL_Log("Audio: no ambience at %s", path);
+  }
+  tb_free(audio->gp_alloc, path);
+
+  SDL_Log("Audio: %s driver at %d Hz with %d voices",
+          SDL_GetCurrentAudioDriver(), freq, THS_AUDIO_VOICE_COUNT);
+}
+
+static int32_t find_voice(const ThsAudioSystem *audio, ecs_entity_t hull,
+                          ThsBoatSound sound) {
+  for (int32_t v = 0; v < THS_AUDIO_VOICE_COUNT; ++v) {
+    const tb_auto *voice = &audio->voices[v];
+    if (voice->hull == hull && voice->sound == sound) {
+      return v;
+    }
+  }
+  return -1;
+}
+
+// A free voice whose last sound has finished fading out. Starting a sound on
+// a channel halts whatever it still plays, which would cut the fade short
+static int32_t find_quiet_voice(const ThsAudioSystem *audio) {
+  for (int32_t v = 0; v < THS_AUDIO_VOICE_COUNT; ++v) {
+    if (audio->voices[v].hull == 0 &&
+        (!audio->device_open || !Mix_Playing(v))) {
+      return v;
+    }
+  }
+  return -1;
+}
+
+// Keeps the loudest candidates sorted by rank, loudest first
+static uint32_t insert_candidate(ThsAudioCandidate *chosen, uint32_t count,
+                                 const ThsAudioCandidate *cand) {
+  if (count == THS_AUDIO_VOICE_COUNT &&
+      cand->rank <= chosen[count - 1].rank) {
+    return count;
+  }
+  uint32_t i = count < THS_AUDIO_VOICE_COUNT ? count : count - 1;
+  for (; i > 0 && chosen[i - 1].rank < cand->rank; --i) {
+    chosen[i] = chosen[i - 1];
+  }
+  chosen[i] = *cand;
+  return count < THS_AUDIO_VOICE_COUNT ? count + 1 : count;
+}
+
+static void apply_voice(const ThsAudioSystem *audio, int32_t v) {
+  if (!audio->device_open) {
+    return;
+  }
+  const tb_auto *voice = &audio->voices[v];
+  Mix_Volume(v, (int32_t)(SDL_clamp(voice->gain, 0.0f, 1.0f) *
+                          (float)MIX_MAX_VOLUME));
+  // Constant power so sounds don't dip as they cross the middle
+  const float angle = (voice->pan + 1.0f) * 0.25f * SDL_PI_F;
+  Mix_SetPanning(v, (uint8_t)(SDL_cosf(angle) * 254.0f),
+                 (uint8_t)(SDL_sinf(angle) * 254.0f));
+}
+
+// Stops voices whose sound fell out of the loudest, then starts the newly
+// loudest on voices that have gone quiet. A sound that finds none waits for
+// a later update while the fades finish. Returns how many sounds have a voice
+static uint32_t assign_voices(ThsAudioSystem *audio,
+                              const ThsAudioCandidate *chosen, uint32_t count,
+                              ThsAudioCounters *counters) {
+  uint32_t playing = 0;
+  bool kept[THS_AUDIO_VOICE_COUNT] = {0};
+  for (uint32_t i = 0; i < count; ++i) {
+    if (chosen[i].voice >= 0) {
+      kept[chosen[i].voice] = true;
+    }
+  }
+  for (int32_t v = 0; v < THS_AUDIO_VOICE_COUNT; ++v) {
+    if (audio->voices[v].hull == 0 || kept[v]) {
+      continue;
+    }
+    if (audio->device_open) {
+      Mix_FadeOutChannel(v, FADE_MS);
+    }
+    audio->voices[v] = (ThsAudioVoice){0};
+    counters->stopped++;
+  }
+
+  for (uint32_t i = 0; i < count; ++i) {
+    const tb_auto *cand = &chosen[i];
+    int32_t v = cand->voice;
+    const bool start = v < 0;
+    if (start) {
+      v = find_quiet_voice(audio);
+      if (v < 0) {
+        continue;
+      }
+      audio->voices[v] = (ThsAudioVoice){
+          .hull = cand->hull,
+          .sound = cand->sound,
+      };
+      counters->started++;
+    }
+    audio->voices[v].gain = cand->gain;
+    audio->voices[v].pan = cand->pan;
+    apply_voice(audio, v);
+
+    Mix_Chunk *chunk = audio->sounds[cand->sound];
+    if (start && audio->device_open && chunk) {
+      Mix_FadeInChannel(v, chunk, -1, FADE_MS);
+    }
+    playing++;
+  }
+  return playing;
+}
+
+void ths_audio_update(ecs_world_t *ecs) {
+  TracyCZoneNC(ctx, "Audio Update", TracyCategoryColorGame, true);
+  ThsProfileScope prof = ths_profile_begin(update_track);
+  const uint64_t start = SDL_GetPerformanceCounter();
+
+  tb_auto *audio = ecs_singleton_get_mut(ecs, ThsAudioSystem);
+
+  ThsAudioCounters counters = {0};
+  ThsAudioCandidate chosen[THS_AUDIO_VOICE_COUNT] = {0};
+  uint32_t chosen_count = 0;
+
+  // Rebuilt at the start of the last step
+  const tb_auto *hash = ecs_singleton_get(ecs, ThsSpatialHash);
+  // The active camera is the listener
+  ThsActiveBoatCamera camera = {0};
+  if (hash && ths_find_active_boat_camera(ecs, &audio->camera_query, &camera)) {
+    const float3 listener = camera.position;
+    const float3 right = camera.right;
+    uint32_t hits[THS_AUDIO_MAX_CANDIDATES] = {0};
+    const uint32_t hit_count = ths_spatial_hash_query(
+        hash, (float2){listener.x, listener.z}, THS_AUDIO_MAX_DISTANCE, hits,
+        THS_AUDIO_MAX_CANDIDATES);
+    for (uint32_t h = 0; h < hit_count; ++h) {
+      const tb_auto *entry = &hash->entries[hits[h]];
+      // The scene may have been swapped since the hash was built
+      if (!ecs_is_alive(ecs, entry->hull)) {
+        continue;
+      }
+      const tb_auto *hull =
+          ecs_get(ecs, entry->hull, ThsBoatMovementComponent);
+      if (hull == NULL) {
+        continue;
+      }
+
+      // Boats sound from the waterline
+      const float3 offset =
+          (float3){entry->pos.x, 0.0f, entry->pos.y} - listener;
+      const float dist = tb_magf3(offset);
+      const float falloff = THS_AUDIO_REF_DISTANCE /
+                            SDL_max(dist, THS_AUDIO_REF_DISTANCE) *
+                            SDL_max(1.0f - dist / THS_AUDIO_MAX_DISTANCE, 0.0f);
+      const float pan = dist > 0.001f ? tb_dotf3(offset / dist, right) : 0.0f;
+
+      const float loudness[THS_BOAT_SOUND_COUNT] = {
+          [THS_BOAT_SOUND_WAKE] =
+              SDL_min(SDL_fabsf(hull->speed) / WAKE_FULL_SPEED, 1.0f),
+          [THS_BOAT_SOUND_CREAK] =
+              CREAK_BASE +
+              CREAK_TURN * SDL_min(SDL_fabsf(hull->heading_change_speed), 1.0f),
+      };
+      for (uint32_t s = 0; s < THS_BOAT_SOUND_COUNT; ++s) {
+        counters.candidates++;
+        const float gain = loudness[s] * falloff;
+        if (gain < THS_AUDIO_MIN_GAIN) {
+          continue;
+        }
+        counters.audible++;
+        ThsAudioCandidate cand = {
+            .hull = entry->hull,
+            .sound = (ThsBoatSound)s,
+            .gain = gain,
+            .pan = pan,
+            .voice = find_voice(audio, entry->hull, (ThsBoatSound)s),
+        };
+        cand.rank = cand.voice >= 0 ? gain * KEEP_BIAS : gain;
+        chosen_count = insert_candidate(chosen, chosen_count, &cand);
+      }
+    }
+  }
+
+  counters.playing = assign_voices(audio, chosen, chosen_count, &counters);
+  counters.virtualized = counters.audible - counters.playing;
+  counters.update_ms =
+      (float)((double)(SDL_GetPerformanceCounter() - start) * 1000.0 /
+              (double)SDL_GetPerformanceFrequency());
+  audio->counters = counters;
+
+  TracyCPlot("Audio Sounds Scored", (double)counters.candidates);
+  TracyCPlot("Audio Voices Playing", (double)counters.playing);
+  TracyCPlot("Audio Sounds Virtual", (double)counters.virtualized);
+
+  ths_profile_end(prof);
+  TracyCZoneEnd(ctx);
+}
+
+ThsAudioCounters ths_audio_counters(ecs_world_t *ecs) {
+  const tb_auto *audio = ecs_singleton_get(ecs, ThsAudioSystem);
+  return audio ? audio->counters : (ThsAudioCounters){0};
+}
+
+void audio_update_tick(ecs_iter_t *it) { ths_audio_update(it->world); }
+
+void ths_register_audio_sys(TbWorld *world) {
+  ecs_world_t *ecs = world->ecs;
+  ECS_COMPONENT_DEFINE(ecs, ThsAudioSystem);
+
+  update_track = ths_profiler_track("Audio Update");
+
+  ThsAudioSystem audio = {.gp_alloc = world->gp_alloc};
+  open_device(&audio);
+  ecs_singleton_set_ptr(ecs, ThsAudioSystem, &audio);
+
+  // Once a frame after the simulation has moved the boats and the camera
+  ecs_system(ecs, {.entity = ecs_entity(ecs, {.name = "Audio Update",
+                                              .add = {ecs_dependson(
+                                                  EcsPostUpdate)}}),
+                   .callback = audio_update_tick});
+}
+
+void ths_unregister_audio_sys(TbWorld *world) {
+  ecs_world_t *ecs = world->ecs;
+  tb_auto *audio = ecs_singleton_get_mut(ecs, ThsAudioSystem);
+  if (audio->device_open) {
+    Mix_HaltChannel(-1);
+    Mix_HaltMusic();
+    for (uint32_t i = 0; i < THS_BOAT_SOUND_COUNT; ++i) {
+      if (audio->sounds[i]) {
+        Mix_FreeChunk(audio->sounds[i]);
+        tb_free(audio->gp_alloc, audio->sound_data[i]);
+      }
+    }
+    if (audio->ambience) {
+      Mix_FreeMusic(audio->ambience);
+    }
+    Mix_CloseAudio();
+    SDL_QuitSubSystem(SDL_INIT_AUDIO);
+  }
+  if (audio->camera_query) {
+    ecs_query_fini(audio->camera_query);
+  }
+  ecs_singleton_remove(ecs, ThsAudioSystem);
+}
+
+TB_REGISTER_SYS(ths, audio, TB_SYSTEM_NORMAL)
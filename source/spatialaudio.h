@@ -0,0 +1,74 @@
+#pragma once
+
+#include "allocator.h"
+#include "simd.h"
+
+#include <SDL3_mixer/SDL_mixer.h>
+#include <flecs.h>
+
+// Sounds of the fleet mixed on a fixed pool of voices
+//
+// Every frame the boats around the listener are gathered from the spatial
+// hash and each of their sounds is scored by how loud it would be at the
+// listener. The loudest get a voice; the rest are virtual, scored but not
+// mixed, until they outrank one that is playing. Boats beyond
+// THS_AUDIO_MAX_DISTANCE are never looked at, so neither scoring nor mixing
+// grows with the size of the fleet
+//
+// The listener is the active boat camera. Ocean ambience isn't positional
+// and plays outside the pool, streamed from disk rather than decoded up
+// front
+
+#define THS_AUDIO_VOICE_COUNT 16
+#define THS_AUDIO_MAX_DISTANCE 150.0f // m
+// Sounds are at their own loudness this close and fall off past it
+#define THS_AUDIO_REF_DISTANCE 10.0f // m
+// Most boats scored per frame; a crowd beyond that goes unheard
+#define THS_AUDIO_MAX_CANDIDATES 256
+// Quieter than this at the listener is inaudible
+#define THS_AUDIO_MIN_GAIN (1.0f / 256.0f)
+#define THS_AUDIO_AMBIENCE "audio/ocean_ambience.wav"
+
+typedef enum ThsBoatSound {
+  THS_BOAT_SOUND_WAKE,  // Water at the bow; louder the faster the boat
+  THS_BOAT_SOUND_CREAK, // The hull working; louder while turning
+  THS_BOAT_SOUND_COUNT,
+} ThsBoatSound;
+
+typedef struct ThsAudioVoice {
+  ecs_entity_t hull; // 0 when the voice is free
+  ThsBoatSound sound;
+  float gain;
+  float pan; // -1 is left, 1 is right
+} ThsAudioVoice;
+
+// What the most recent update did
+typedef struct ThsAudioCounters {
+  uint32_t candidates;  // Sounds scored
+  uint32_t audible;     // Sounds above THS_AUDIO_MIN_GAIN
+  uint32_t playing;     // Sounds with a voice
+  uint32_t virtualized; // Audible sounds without a voice
+  uint32_t started;
+  uint32_t stopped;
+  float update_ms;
+} ThsAudioCounters;
+
+typedef struct ThsAudioSystem {
+  TbAllocator gp_alloc;
+  // Without a device voices are still assigned, just never mixed
+  bool device_open;
+  Mix_Chunk *sounds[THS_BOAT_SOUND_COUNT];
+  uint8_t *sound_data[THS_BOAT_SOUND_COUNT]; // Chunks don't own their samples
+  Mix_Music *ambience;
+  ecs_query_t *camera_query;
+
+  ThsAudioVoice voices[THS_AUDIO_VOICE_COUNT];
+  ThsAudioCounters counters;
+} ThsAudioSystem;
+extern ECS_COMPONENT_DECLARE(ThsAudioSystem);
+
+// Rescores every sound near the listener and hands the voices to the
+// loudest. Runs once a frame from the audio system
+void ths_audio_update(ecs_world_t *ecs);
+
+ThsAudioCounters ths_audio_counters(ecs_world_t *ecs);
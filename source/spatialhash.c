@@ -0,0 +1,391 @@
+#include "spatialhash.h"
+
+#include "profiler.h"
+#include "profiling.h"
+#include "simulation.h"
+#include "tbcommon.h"
+#include "transformcomponent.h"
+#include "world.h"
+
+#include "boatmovementcomponent.h"
+
+#include <SDL3/SDL_stdinc.h>
+
+ECS_COMPONENT_DECLARE(ThsSpatialHash);
+
+// Wide enough that boats in the default fleets rarely share a cell
+#define DEFAULT_CELL_SIZE 16.0f
+
+static ThsProfileTrack hash_track = 0;
+
+static uint32_t hash_cell(int32_t x, int32_t z) {
+  return ((uint32_t)x * 73856093u) ^ ((uint32_t)z * 19349663u);
+}
+
+static int32_t cell_coord(const ThsSpatialHash *hash, float v) {
+  return (int32_t)SDL_floorf(v * hash->inv_cell_size);
+}
+
+void ths_create_spatial_hash(TbAllocator gp_alloc, float cell_size,
+                             ThsSpatialHash *hash) {
+  *hash = (ThsSpatialHash){
+      .gp_alloc = gp_alloc,
+      .cell_size = cell_size,
+      .inv_cell_size = 1.0f / cell_size,
+      .bucket_start = tb_alloc_nm_tp(gp_alloc, 2, uint32_t),
+  };
+  hash->bucket_start[0] = 0;
+  hash->bucket_start[1] = 0;
+}
+
+void ths_destroy_spatial_hash(ThsSpatialHash *hash) {
+  if (hash->entries) {
+    tb_free(hash->gp_alloc, hash->entries);
+    tb_free(hash->gp_alloc, hash->unsorted);
+  }
+  tb_free(hash->gp_alloc, hash->bucket_start);
+  *hash = (ThsSpatialHash){0};
+}
+
+// Keeps the first `gathered` unsorted entries so the system can grow the
+// arrays while it collects hulls
+static void reserve_entries(ThsSpatialHash *hash, uint32_t count,
+                            uint32_t gathered) {
+  if (count <= hash->entry_capacity) {
+    return;
+  }
+  uint32_t capacity = SDL_max(hash->entry_capacity * 2, 64u);
+  while (capacity < count) {
+    capacity *= 2;
+  }
+  tb_auto *unsorted =
+      tb_alloc_nm_tp(hash->gp_alloc, capacity, ThsSpatialHashEntry);
+  if (hash->entries) {
+    SDL_memcpy(unsorted, hash->unsorted,
+               sizeof(ThsSpatialHashEntry) * gathered);
+    tb_free(hash->gp_alloc, hash->entries);
+    tb_free(hash->gp_alloc, hash->unsorted);
+  }
+  hash->unsorted = unsorted;
+  hash->entries =
+      tb_alloc_nm_tp(hash->gp_alloc, capacity, ThsSpatialHashEntry);
+  // Twice as many buckets as entries keeps unrelated cells apart
+  tb_free(hash->gp_alloc, hash->bucket_start);
+  hash->bucket_start =
+      tb_alloc_nm_tp(hash->gp_alloc, capacity * 2 + 1, uint32_t);
+  hash->entry_capacity = capacity;
+}
+
+void ths_spatial_hash_build(ThsSpatialHash *hash,
+                            const ThsSpatialHashEntry *entries,
+                            uint32_t count) {
+  if (entries != hash->unsorted) {
+    reserve_entries(hash, count, 0);
+    SDL_memcpy(hash->unsorted, entries, sizeof(ThsSpatialHashEntry) * count);
+  }
+
+  uint32_t bucket_count = 1;
+  while (bucket_count < count * 2) {
+    bucket_count *= 2;
+  }
+  hash->bucket_mask = bucket_count - 1;
+  hash->entry_count = count;
+  hash->max_radius = 0.0f;
+
+  // Counting sort; count every bucket, turn the counts into offsets, then
+  // scatter. Entries of a bucket keep the order they were handed in
+  uint32_t *start = hash->bucket_start;
+  SDL_memset(start, 0, sizeof(uint32_t) * (bucket_count + 1));
+  for (uint32_t i = 0; i < count; ++i) {
+    tb_auto *entry = &hash->unsorted[i];
+    entry->cell_x = cell_coord(hash, entry->pos.x);
+    entry->cell_z = cell_coord(hash, entry->pos.y);
+    hash->max_radius = SDL_max(hash->max_radius, entry->radius);
+    start[(hash_cell(entry->cell_x, entry->cell_z) & hash->bucket_mask) + 1]++;
+  }
+  for (uint32_t b = 0; b < bucket_count; ++b) {
+    start[b + 1] += start[b];
+  }
+  for (uint32_t i = 0; i < count; ++i) {
+    const tb_auto *entry = &hash->unsorted[i];
+    const uint32_t bucket =
+        hash_cell(entry->cell_x, entry->cell_z) & hash->bucket_mask;
+    hash->entries[start[bucket]++] = *entry;
+  }
+  // Scattering advanced each start to where the next bucket begins
+  for (uint32_t b = bucket_count; b > 0; --b) {
+    start[b] = start[b - 1];
+  }
+  start[0] = 0;
+}
+
+uint32_t ths_spatial_hash_query(const ThsSpatialHash *hash, float2 center,
+                                float radius, uint32_t *hits,
+                                uint32_t max_hits) {
+  const float radius_sq = radius * radius;
+  uint32_t hit_count = 0;
+  if (max_hits == 0) {
+    return hit_count;
+  }
+
+  const int32_t x0 = cell_coord(hash, center.x - radius);
+  const int32_t x1 = cell_coord(hash, center.x + radius);
+  const int32_t z0 = cell_coord(hash, center.y - radius);
+  const int32_t z1 = cell_coord(hash, center.y + radius);
+  const int64_t cell_count = (int64_t)(x1 - x0 + 1) * (z1 - z0 + 1);
+
+  if (cell_count > THS_SPATIAL_HASH_MAX_QUERY_CELLS) {
+    for (uint32_t i = 0; i < hash->entry_count && hit_count < max_hits; ++i) {
+      const float2 d = hash->entries[i].pos - center;
+      if (d.x * d.x + d.y * d.y <= radius_sq) {
+        hits[hit_count++] = i;
+      }
+    }
+    return hit_count;
+  }
+
+  for (int32_t z = z0; z <= z1; ++z) {
+    for (int32_t x = x0; x <= x1; ++x) {
+      const uint32_t bucket = hash_cell(x, z) & hash->bucket_mask;
+      const uint32_t end = hash->bucket_start[bucket + 1];
+      for (uint32_t i = hash->bucket_start[bucket]; i < end; ++i) {
+        const tb_auto *entry = &hash->entries[i];
+        // Other cells may hash to the same bucket
+        if (entry->cell_x != x || entry->cell_z != z) {
+          continue;
+        }
+        const float2 d = entry->pos - center;
+        if (d.x * d.x + d.y * d.y <= radius_sq) {
+          hits[hit_count++] = i;
+          if (hit_count == max_hits) {
+            return hit_count;
+          }
+        }
+      }
+    }
+  }
+  return hit_count;
+}
+
+static float entry_dist_sq(const ThsSpatialHash *hash, float2 center,
+                           uint32_t idx) {
+  const float2 d = hash->entries[idx].pos - center;
+  return d.x * d.x + d.y * d.y;
+}
+
+// Inserts an entry into hits, which is sorted nearest first. Once hits is
+// full the farthest one falls off the end
+static void keep_closest(const ThsSpatialHash *hash, float2 center,
+                         uint32_t idx, float dist_sq, uint32_t *hits,
+                         uint32_t *hit_count, uint32_t max_hits) {
+  uint32_t slot = *hit_count;
+  if (slot == max_hits) {
+    if (dist_sq >= entry_dist_sq(hash, center, hits[slot - 1])) {
+      return;
+    }
+    slot--;
+  } else {
+    (*hit_count)++;
+  }
+  while (slot > 0 && entry_dist_sq(hash, center, hits[slot - 1]) > dist_sq) {
+    hits[slot] = hits[slot - 1];
+    slot--;
+  }
+  hits[slot] = idx;
+}
+
+uint32_t ths_spatial_hash_query_closest(const ThsSpatialHash *hash,
+                                        float2 center, float radius,
+                                        ecs_entity_t ignore_boat,
+                                        uint32_t *hits, uint32_t max_hits) {
+  const float radius_sq = radius * radius;
+  uint32_t hit_count = 0;
+  if (max_hits == 0) {
+    return hit_count;
+  }
+
+  const int32_t x0 = cell_coord(hash, center.x - radius);
+  const int32_t x1 = cell_coord(hash, center.x + radius);
+  const int32_t z0 = cell_coord(hash, center.y - radius);
+  const int32_t z1 = cell_coord(hash, center.y + radius);
+  const int64_t cell_count = (int64_t)(x1 - x0 + 1) * (z1 - z0 + 1);
+
+  if (cell_count > THS_SPATIAL_HASH_MAX_QUERY_CELLS) {
+    for (uint32_t i = 0; i < hash->entry_count; ++i) {
+      if (hash->entries[i].boat == ignore_boat) {
+        continue;
+      }
+      const float dist_sq = entry_dist_sq(hash, center, i);
+      if (dist_sq <= radius_sq) {
+        keep_closest(hash, center, i, dist_sq, hits, &hit_count, max_hits);
+      }
+    }
+    return hit_count;
+  }
+
+  for (int32_t z = z0; z <= z1; ++z) {
+    for (int32_t x = x0; x <= x1; ++x) {
+      const uint32_t bucket = hash_cell(x, z) & hash->bucket_mask;
+      const uint32_t end = hash->bucket_start[bucket + 1];
+      for (uint32_t i = hash->bucket_start[bucket]; i < end; ++i) {
+        const tb_auto *entry = &hash->entries[i];
+        if (entry->cell_x != x || entry->cell_z != z ||
+            entry->boat == ignore_boat) {
+          continue;
+        }
+        const float dist_sq = entry_dist_sq(hash, center, i);
+        if (dist_sq <= radius_sq) {
+          keep_closest(hash, center, i, dist_sq, hits, &hit_count, max_hits);
+        }
+      }
+    }
+  }
+  return hit_count;
+}
+
+static void nearest_in_cell(const ThsSpatialHash *hash, int32_t x, int32_t z,
+                            float2 center, ecs_entity_t ignore,
+                            int32_t *best, float *best_dist_sq) {
+  const uint32_t bucket = hash_cell(x, z) & hash->bucket_mask;
+  const uint32_t end = hash->bucket_start[bucket + 1];
+  for (uint32_t i = hash->bucket_start[bucket]; i < end; ++i) {
+    const tb_auto *entry = &hash->entries[i];
+    if (entry->cell_x != x || entry->cell_z != z || entry->hull == ignore) {
+      continue;
+    }
+    const float2 d = entry->pos - center;
+    const float dist_sq = d.x * d.x + d.y * d.y;
+    if (dist_sq < *best_dist_sq) {
+      *best_dist_sq = dist_sq;
+      *best = (int32_t)i;
+    }
+  }
+}
+
+int32_t ths_spatial_hash_nearest(const ThsSpatialHash *hash, float2 center,
+                                 float max_radius, ecs_entity_t ignore) {
+  int32_t best = -1;
+  float best_dist_sq = max_radius * max_radius;
+  if (hash->entry_count == 0) {
+    return best;
+  }
+
+  const int32_t ring_count =
+      (int32_t)SDL_ceilf(max_radius * hash->inv_cell_size);
+  if ((int64_t)(ring_count * 2 + 1) * (ring_count * 2 + 1) >
+      THS_SPATIAL_HASH_MAX_QUERY_CELLS) {
+    for (uint32_t i = 0; i < hash->entry_count; ++i) {
+      const tb_auto *entry = &hash->entries[i];
+      const float2 d = entry->pos - center;
+      const float dist_sq = d.x * d.x + d.y * d.y;
+      if (entry->hull != ignore && dist_sq < best_dist_sq) {
+        best_dist_sq = dist_sq;
+        best = (int32_t)i;
+      }
+    }
+    return best;
+  }
+
+  // Rings of cells outwards from the center's cell. Anything in ring r is
+  // at least r - 1 cells away, so the search stops once the best is closer
+  const int32_t cx = cell_coord(hash, center.x);
+  const int32_t cz = cell_coord(hash, center.y);
+  for (int32_t r = 0; r <= ring_count; ++r) {
+    if (best >= 0) {
+      const float reach = (float)(r - 1) * hash->cell_size;
+      if (best_dist_sq <= reach * reach) {
+        break;
+      }
+    }
+    for (int32_t z = cz - r; z <= cz + r; ++z) {
+      // Only the edges of the ring are new
+      const bool edge_row = z == cz - r || z == cz + r;
+      const int32_t step = edge_row ? 1 : SDL_max(r * 2, 1);
+      for (int32_t x = cx - r; x <= cx + r; x += step) {
+        nearest_in_cell(hash, x, z, center, ignore, &best, &best_dist_sq);
+      }
+    }
+  }
+  return best;
+}
+
+// Runs single threaded at the start of the step so everything after it,
+// including the parallel boat tick, can query the hash without locking
+void spatial_hash_update_tick(ecs_iter_t *it) {
+  TracyCZoneNC(ctx, "Spatial Hash Update", TracyCategoryColorGame, true);
+  ThsProfileScope prof = ths_profile_begin(hash_track);
+
+  ecs_world_t *ecs = it->world;
+  tb_auto *hash = ecs_singleton_get_mut(ecs, ThsSpatialHash);
+
+  uint32_t count = 0;
+  ecs_iter_t hull_it = ecs_query_iter(ecs, hash->hull_query);
+  while (ecs_iter_next(&hull_it)) {
+    // Hulls in a table share a boat and a class
+    const tb_auto *boat_transform =
+        ecs_field(&hull_it, TbTransformComponent, 2);
+    const ecs_entity_t boat = ecs_field_src(&hull_it, 2);
+    const float3 pos = boat_transform->transform.position;
+    const tb_auto *tuning = ecs_field(&hull_it, ThsBoatTuningComponent, 3);
+    const float radius = SDL_sqrtf(tuning->half_width * tuning->half_width +
+                                   tuning->half_length * tuning->half_length);
+
+    reserve_entries(hash, count + (uint32_t)hull_it.count, count);
+    for (int32_t i = 0; i < hull_it.count; ++i) {
+      hash->unsorted[count++] = (ThsSpatialHashEntry){
+          .pos = {pos.x, pos.z},
+          .radius = radius,
+          .hull = hull_it.entities[i],
+          .boat = boat,
+      };
+    }
+  }
+  ths_spatial_hash_build(hash, hash->unsorted, count);
+
+  TracyCPlot("Spatial Hash Entries", (double)count);
+
+  ths_profile_end(prof);
+  TracyCZoneEnd(ctx);
+}
+
+void ths_register_spatial_hash_sys(TbWorld *world) {
+  ecs_world_t *ecs = world->ecs;
+  ECS_COMPONENT_DEFINE(ecs, ThsSpatialHash);
+
+  hash_track = ths_profiler_track("Spatial Hash Update");
+
+  ThsSpatialHash hash = {0};
+  ths_create_spatial_hash(world->gp_alloc, DEFAULT_CELL_SIZE, &hash);
+  hash.hull_query =
+      ecs_query(ecs, {.filter.terms =
+                          {
+                              // Only picks out hulls; none of it is read
+                              {.id = ecs_id(ThsBoatMovementComponent),
+                               .inout = EcsInOutNone},
+                              {.id = ecs_id(TbTransformComponent),
+                               .inout = EcsIn,
+                               .src.flags = EcsUp,
+                               .src.trav = EcsChildOf},
+                              {.id = ecs_id(ThsBoatTuningComponent),
+                               .inout = EcsIn,
+                               .src.flags = EcsUp,
+                               .src.trav = EcsIsA},
+                          }});
+  ecs_singleton_set_ptr(ecs, ThsSpatialHash, &hash);
+
+  // Boats moved at the end of the last step; AI and movement query this one
+  ecs_entity_t phase = ths_sim_phase(ecs, THS_SIM_PRE_UPDATE);
+  ecs_system(ecs, {.entity = ecs_entity(ecs, {.name = "Spatial Hash Update",
+                                              .add = {ecs_dependson(phase)}}),
+                   .callback = spatial_hash_update_tick});
+}
+
+void ths_unregister_spatial_hash_sys(TbWorld *world) {
+  ecs_world_t *ecs = world->ecs;
+  tb_auto *hash = ecs_singleton_get_mut(ecs, ThsSpatialHash);
+  ecs_query_fini(hash->hull_query);
+  ths_destroy_spatial_hash(hash);
+  ecs_singleton_remove(ecs, ThsSpatialHash);
+}
+
+TB_REGISTER_SYS(ths, spatial_hash, TB_SYSTEM_NORMAL)
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "allocator.h"
+#include "simd.h"
+
+#include <flecs.h>
+
+// Uniform grid over the XZ positions of every hull
+//
+// Rebuilt at the start of each simulation step so anything that wants to
+// know which boats are near a point, like separation, AI or effects, pays
+// for the cells around that point rather than a pass over every boat.
+// Cells are hashed into a power of two bucket table sized to the hull count
+// so the grid needs no bounds. Entries are sorted by bucket, in query order,
+// which keeps results the same from run to run
+//
+// Positions are on the XZ plane with Z in the second lane
+
+// Queries spanning more cells than this scan every entry instead
+#define THS_SPATIAL_HASH_MAX_QUERY_CELLS 1024
+
+typedef struct ThsSpatialHashEntry {
+  float2 pos;
+  float radius; // Bounding circle of the hull
+  int32_t cell_x;
+  int32_t cell_z;
+  ecs_entity_t hull;
+  ecs_entity_t boat;
+} ThsSpatialHashEntry;
+
+typedef struct ThsSpatialHash {
+  TbAllocator gp_alloc;
+  float cell_size;
+  float inv_cell_size;
+
+  // Entries sorted by bucket; a bucket's entries run from bucket_start[b]
+  // up to bucket_start[b + 1]
+  ThsSpatialHashEntry *entries;
+  uint32_t entry_count;
+  uint32_t entry_capacity;
+  uint32_t *bucket_start;
+  uint32_t bucket_mask; // Bucket count minus one
+  float max_radius;     // Largest hull radius, for padding queries
+
+  // Gathered by the system before they are sorted into entries
+  ThsSpatialHashEntry *unsorted;
+  ecs_query_t *hull_query;
+} ThsSpatialHash;
+extern ECS_COMPONENT_DECLARE(ThsSpatialHash);
+
+void ths_create_spatial_hash(TbAllocator gp_alloc, float cell_size,
+                             ThsSpatialHash *hash);
+void ths_destroy_spatial_hash(ThsSpatialHash *hash);
+
+// Replaces the contents with the given entries. Their cells are filled in
+void ths_spatial_hash_build(ThsSpatialHash *hash,
+                            const ThsSpatialHashEntry *entries,
+                            uint32_t count);
+
+// Writes the indices of up to max_hits entries whose positions lie within
+// radius of center. Returns how many were written
+uint32_t ths_spatial_hash_query(const ThsSpatialHash *hash, float2 center,
+                                float radius, uint32_t *hits,
+                                uint32_t max_hits);
+
+// Like ths_spatial_hash_query but skips the hulls of one boat and keeps the
+// max_hits entries nearest to center rather than the first ones found. Hits
+// are written nearest first
+uint32_t ths_spatial_hash_query_closest(const ThsSpatialHash *hash,
+                                        float2 center, float radius,
+                                        ecs_entity_t ignore_boat,
+                                        uint32_t *hits, uint32_t max_hits);
+
+// Index of the entry nearest to center other than the ignored hull, or -1
+// when there is none within max_radius
+int32_t ths_spatial_hash_nearest(const ThsSpatialHash *hash, float2 center,
+                                 float max_radius, ecs_entity_t ignore);
@@ -0,0 +1,222 @@
+#include "transformwrites.h"
+
+#include "profiler.h"
+#include "profiling.h"
+#include "tbcommon.h"
+#include "transformcomponent.h"
+#include "world.h"
+
+#include <SDL3/SDL.h>
+
+ECS_COMPONENT_DECLARE(ThsTransformWrites);
+
+static ThsProfileTrack propagate_track = 0;
+
+static void resize_stages(ThsTransformWrites *tw, int32_t stage_count) {
+  for (int32_t i = 0; i < tw->stage_count; ++i) {
+    TB_DYN_ARR_DESTROY(tw->stages[i].writes);
+  }
+  if (tw->stages) {
+    tb_free(tw->gp_alloc, tw->stages);
+    tw->stages = NULL;
+  }
+
+  tw->stage_count = stage_count;
+  if (stage_count == 0) {
+    return;
+  }
+  tw->stages =
+      tb_alloc_nm_tp(tw->gp_alloc, stage_count, ThsTransformWriteStage);
+  SDL_memset(tw->stages, 0, sizeof(ThsTransformWriteStage) * stage_count);
+  for (int32_t i = 0; i < stage_count; ++i) {
+    TB_DYN_ARR_RESET(tw->stages[i].writes, tw->gp_alloc, 64);
+  }
+}
+
+void ths_prepare_transform_writes(ecs_world_t *ecs) {
+  tb_auto *tw = ecs_singleton_get_mut(ecs, ThsTransformWrites);
+  const int32_t stage_count = ecs_get_stage_count(ecs);
+  if (stage_count > tw->stage_count) {
+    // Nothing can be pending; writes are applied before workers start again
+    resize_stages(tw, stage_count);
+  }
+}
+
+void ths_write_transform(ecs_world_t *ecs, ecs_entity_t entity,
+                         const TbTransform *transform) {
+  const tb_auto *tw = ecs_singleton_get(ecs, ThsTransformWrites);
+  const int32_t stage_id = ecs_get_stage_id(ecs);
+  TB_CHECK(stage_id < tw->stage_count, "Transform writes were not prepared");
+  tb_auto *stage = &tw->stages[stage_id];
+  ThsTransformWrite write = {
+      .entity = entity,
+      .order = (uint32_t)TB_DYN_ARR_SIZE(stage->writes),
+      .transform = *transform,
+  };
+  TB_DYN_ARR_APPEND(stage->writes, write);
+}
+
+static int32_t compare_writes(const void *a, const void *b) {
+  const ThsTransformWrite *wa = a;
+  const ThsTransformWrite *wb = b;
+  if (wa->entity != wb->entity) {
+    return wa->entity < wb->entity ? -1 : 1;
+  }
+  return (wa->order > wb->order) - (wa->order < wb->order);
+}
+
+static int32_t compare_entities(const void *a, const void *b) {
+  const ecs_entity_t ea = *(const ecs_entity_t *)a;
+  const ecs_entity_t eb = *(const ecs_entity_t *)b;
+  return (ea > eb) - (ea < eb);
+}
+
+// Compares lanes individually; padding in the simd types may hold anything
+bool ths_transforms_equal(const TbTransform *a, const TbTransform *b) {
+  return a->position.x == b->position.x && a->position.y == b->position.y &&
+         a->position.z == b->position.z && a->rotation.x == b->rotation.x &&
+         a->rotation.y == b->rotation.y && a->rotation.z == b->rotation.z &&
+         a->rotation.w == b->rotation.w && a->scale.x == b->scale.x &&
+         a->scale.y == b->scale.y && a->scale.z == b->scale.z;
+}
+
+void ths_apply_transform_writes(ecs_world_t *ecs) {
+  TracyCZoneNC(ctx, "Apply Transform Writes", TracyCategoryColorCore, true);
+  tb_auto *tw = ecs_singleton_get_mut(ecs, ThsTransformWrites);
+
+  // Each stage's writes are already in order, so appending stages one after
+  // another only leaves writes to the same entity from different stages to
+  // be ordered by stage
+  TB_DYN_ARR_CLEAR(tw->merged);
+  uint32_t order = 0;
+  for (int32_t s = 0; s < tw->stage_count; ++s) {
+    tb_auto *stage = &tw->stages[s];
+    TB_DYN_ARR_FOREACH(stage->writes, i) {
+      ThsTransformWrite write = TB_DYN_ARR_AT(stage->writes, i);
+      write.order = order++;
+      TB_DYN_ARR_APPEND(tw->merged, write);
+    }
+    TB_DYN_ARR_CLEAR(stage->writes);
+  }
+
+  const uint32_t count = (uint32_t)TB_DYN_ARR_SIZE(tw->merged);
+  if (count == 0) {
+    TracyCZoneEnd(ctx);
+    return;
+  }
+  SDL_qsort(&TB_DYN_ARR_AT(tw->merged, 0), count, sizeof(ThsTransformWrite),
+            compare_writes);
+
+  for (uint32_t i = 0; i < count; ++i) {
+    const tb_auto *write = &TB_DYN_ARR_AT(tw->merged, i);
+    // Only the last write to an entity counts
+    if (i + 1 < count &&
+        TB_DYN_ARR_AT(tw->merged, i + 1).entity == write->entity) {
+      tw->skipped++;
+      continue;
+    }
+    tb_auto *trans = ecs_get_mut(ecs, write->entity, TbTransformComponent);
+    if (trans == NULL || ths_transforms_equal(&trans->transform,
+                                              &write->transform)) {
+      tw->skipped++;
+      continue;
+    }
+    trans->transform = write->transform;
+    TB_DYN_ARR_APPEND(tw->changed, write->entity);
+    tw->written++;
+  }
+
+  TracyCZoneEnd(ctx);
+}
+
+static bool contains_entity(const ecs_entity_t *sorted, uint32_t count,
+                            ecs_entity_t entity) {
+  uint32_t lo = 0;
+  uint32_t hi = count;
+  while (lo < hi) {
+    const uint32_t mid = lo + (hi - lo) / 2;
+    if (sorted[mid] == entity) {
+      return true;
+    }
+    if (sorted[mid] < entity) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  return false;
+}
+
+void ths_propagate_transforms(ecs_world_t *ecs) {
+  TracyCZoneNC(ctx, "Propagate Transforms", TracyCategoryColorCore, true);
+  ThsProfileScope prof = ths_profile_begin(propagate_track);
+
+  ths_apply_transform_writes(ecs);
+  tb_auto *tw = ecs_singleton_get_mut(ecs, ThsTransformWrites);
+
+  const uint32_t count = (uint32_t)TB_DYN_ARR_SIZE(tw->changed);
+  if (count > 0) {
+    ecs_entity_t *changed = &TB_DYN_ARR_AT(tw->changed, 0);
+    SDL_qsort(changed, count, sizeof(ecs_entity_t), compare_entities);
+
+    // Drop entities written more than once since the last propagation
+    uint32_t unique = 1;
+    for (uint32_t i = 1; i < count; ++i) {
+      if (changed[i] != changed[unique - 1]) {
+        changed[unique++] = changed[i];
+      }
+    }
+
+    for (uint32_t i = 0; i < unique; ++i) {
+      // Dirtying an ancestor already covers this entity's subtree
+      bool covered = false;
+      for (ecs_entity_t parent = ecs_get_parent(ecs, changed[i]);
+           parent != 0 && !covered; parent = ecs_get_parent(ecs, parent)) {
+        covered = contains_entity(changed, unique, parent);
+      }
+      if (!covered) {
+        tb_transform_mark_dirty(ecs, changed[i]);
+        tw->propagated++;
+      }
+    }
+  }
+
+  TracyCPlot("Transform Writes", (double)tw->written);
+  TracyCPlot("Transform Writes Skipped", (double)tw->skipped);
+  TracyCPlot("Transform Subtrees Propagated", (double)tw->propagated);
+  TB_DYN_ARR_CLEAR(tw->changed);
+  tw->written = 0;
+  tw->skipped = 0;
+  tw->propagated = 0;
+
+  ths_profile_end(prof);
+  TracyCZoneEnd(ctx);
+}
+
+void ths_register_transform_writes_sys(TbWorld *world) {
+  ecs_world_t *ecs = world->ecs;
+  ECS_COMPONENT_DEFINE(ecs, ThsTransformWrites);
+
+  propagate_track = ths_profiler_track("Transform Propagation");
+
+  ThsTransformWrites tw = {
+      .gp_alloc = world->gp_alloc,
+  };
+  TB_DYN_ARR_RESET(tw.merged, world->gp_alloc, 256);
+  TB_DYN_ARR_RESET(tw.changed, world->gp_alloc, 256);
+  // The main thread can always write; workers get theirs once the thread
+  // count is known
+  resize_stages(&tw, 1);
+  ecs_singleton_set_ptr(ecs, ThsTransformWrites, &tw);
+}
+
+void ths_unregister_transform_writes_sys(TbWorld *world) {
+  ecs_world_t *ecs = world->ecs;
+  tb_auto *tw = ecs_singleton_get_mut(ecs, ThsTransformWrites);
+  resize_stages(tw, 0);
+  TB_DYN_ARR_DESTROY(tw->merged);
+  TB_DYN_ARR_DESTROY(tw->changed);
+  ecs_singleton_remove(ecs, ThsTransformWrites);
+}
+
+TB_REGISTER_SYS(ths, transform_writes, TB_SYSTEM_NORMAL)
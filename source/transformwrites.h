@@ -0,0 +1,60 @@
+#pragma once
+
+#include "allocator.h"
+#include "dynarray.h"
+#include "simd.h"
+
+#include <flecs.h>
+
+// Deferred local transform writes
+//
+// Systems record new local transforms here instead of writing components and
+// marking them dirty directly. Writes are buffered per flecs stage so worker
+// threads can record them too. Applying the list keeps only the last write to
+// each entity and drops writes that don't change anything. Entities that did
+// change are remembered until propagation, which marks each changed subtree
+// dirty once per frame no matter how many times it was written
+typedef struct ThsTransformWrite {
+  ecs_entity_t entity;
+  uint32_t order; // Position within its stage so later writes win
+  TbTransform transform;
+} ThsTransformWrite;
+
+typedef struct ThsTransformWriteStage {
+  TB_DYN_ARR_OF(ThsTransformWrite) writes;
+} ThsTransformWriteStage;
+
+typedef struct ThsTransformWrites {
+  TbAllocator gp_alloc;
+  int32_t stage_count;
+  ThsTransformWriteStage *stages;
+
+  TB_DYN_ARR_OF(ThsTransformWrite) merged;
+  // Applied since the last propagation
+  TB_DYN_ARR_OF(ecs_entity_t) changed;
+
+  // Counts for the current frame; reset by propagation
+  uint32_t written;
+  uint32_t skipped;
+  uint32_t propagated;
+} ThsTransformWrites;
+extern ECS_COMPONENT_DECLARE(ThsTransformWrites);
+
+// Exact comparison of position, rotation and scale
+bool ths_transforms_equal(const TbTransform *a, const TbTransform *b);
+
+// Makes sure every stage has a buffer. Call on the main thread before systems
+// that write from worker threads run
+void ths_prepare_transform_writes(ecs_world_t *ecs);
+
+// Records a new local transform for an entity. Safe from worker threads
+void ths_write_transform(ecs_world_t *ecs, ecs_entity_t entity,
+                         const TbTransform *transform);
+
+// Writes the recorded transforms into their components. Later systems see the
+// new values but nothing is marked dirty yet. Must not run while worker
+// threads are writing
+void ths_apply_transform_writes(ecs_world_t *ecs);
+
+// Applies outstanding writes then marks every changed subtree dirty once
+void ths_propagate_transforms(ecs_world_t *ecs);
@@ -0,0 +1,231 @@
+#include "vlog.h"
+
+#include "imguisystem.h"
+#include "profiling.h"
+#include "simulation.h"
+#include "tbcommon.h"
+#include "tbimgui.h"
+#include "visualloggingsystem.h"
+#include "world.h"
+
+#include <SDL3/SDL.h>
+
+ECS_COMPONENT_DECLARE(ThsVlogSystem);
+
+#define VLOG_RING_MASK (THS_VLOG_RING_CAPACITY - 1)
+
+uint32_t ths_vlog_categories = 0;
+
+// Shown once --vlog is on the command line
+static bool vlog_overlay = false;
+
+static const char *category_names[THS_VLOG_CATEGORY_COUNT] = {
+    "buoyancy",
+    "camera",
+};
+
+const char *ths_vlog_category_name(ThsVlogCategory category) {
+  return category < THS_VLOG_CATEGORY_COUNT ? category_names[category] : "";
+}
+
+void ths_vlog_set_category(ThsVlogCategory category, bool enabled) {
+  if (enabled) {
+    ths_vlog_categories |= 1u << category;
+  } else {
+    ths_vlog_categories &= ~(1u << category);
+  }
+}
+
+static bool enable_named(const char *name, size_t len) {
+  if (len == 3 && SDL_strncmp(name, "all", len) == 0) {
+    ths_vlog_categories = (1u << THS_VLOG_CATEGORY_COUNT) - 1;
+    return true;
+  }
+  for (uint32_t i = 0; i < THS_VLOG_CATEGORY_COUNT; ++i) {
+    if (SDL_strlen(category_names[i]) == len &&
+        SDL_strncmp(category_names[i], name, len) == 0) {
+      ths_vlog_set_category((ThsVlogCategory)i, true);
+      return true;
+    }
+  }
+  return false;
+}
+
+void ths_vlog_configure(int32_t argc, char *argv[]) {
+  for (int32_t i = 1; i < argc - 1; ++i) {
+    if (SDL_strcmp(argv[i], "--vlog") != 0) {
+      continue;
+    }
+    vlog_overlay = true;
+    const char *names = argv[i + 1];
+    while (*names) {
+      const char *end = SDL_strchr(names, ',');
+      const size_t len = end ? (size_t)(end - names) : SDL_strlen(names);
+      if (len > 0 && !enable_named(names, len)) {
+        SDL_Log("Vlog: unknown category %.*s", (int32_t)len, names);
+      }
+      names += end ? len + 1 : len;
+    }
+  }
+#ifdef THS_VLOG_STRIP
+  if (ths_vlog_categories != 0) {
+    SDL_Log("Vlog: visual logging was compiled out of this build");
+  }
+#endif
+}
+
+void ths_vlog_push_location(ecs_world_t *ecs, float3 position, float radius,
+                            float3 color) {
+  const tb_auto *sys = ecs_singleton_get(ecs, ThsVlogSystem);
+  const int32_t stage_id = ecs_get_stage_id(ecs);
+  // Rings catch up with a new stage count at the next flush
+  if (sys == NULL || stage_id >= sys->ring_count) {
+    return;
+  }
+  ThsVlogRing *ring = &sys->rings[stage_id];
+  const uint32_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+  const uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+  if (head - tail >= THS_VLOG_RING_CAPACITY) {
+    atomic_fetch_add_explicit(&ring->dropped, 1, memory_order_relaxed);
+    return;
+  }
+  ring->entries[head & VLOG_RING_MASK] = (ThsVlogEntry){
+      .position = position,
+      .color = color,
+      .radius = radius,
+  };
+  atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+}
+
+// Hands every queued entry to the engine's logger. Returns how many there
+// were
+static uint32_t drain_rings(ecs_world_t *ecs, ThsVlogSystem *sys) {
+  TbVisualLoggingSystem *vlog = NULL;
+  uint32_t drained = 0;
+  for (int32_t r = 0; r < sys->ring_count; ++r) {
+    ThsVlogRing *ring = &sys->rings[r];
+    const uint32_t tail =
+        atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    const uint32_t head =
+        atomic_load_explicit(&ring->head, memory_order_acquire);
+    if (head == tail) {
+      continue;
+    }
+    // Only touch the logger once there is something to give it
+    if (vlog == NULL) {
+      vlog = ecs_singleton_get_mut(ecs, TbVisualLoggingSystem);
+    }
+    if (vlog) {
+      for (uint32_t i = tail; i != head; ++i) {
+        const tb_auto *entry = &ring->entries[i & VLOG_RING_MASK];
+        tb_vlog_location(vlog, entry->position, entry->radius, entry->color);
+      }
+    }
+    atomic_store_explicit(&ring->tail, head, memory_order_release);
+    drained += head - tail;
+  }
+  if (vlog) {
+    ecs_singleton_modified(ecs, TbVisualLoggingSystem);
+  }
+  return drained;
+}
+
+static void resize_rings(ThsVlogSystem *sys, int32_t ring_count) {
+  if (sys->rings) {
+    tb_free(sys->gp_alloc, sys->rings);
+    sys->rings = NULL;
+  }
+  sys->ring_count = ring_count;
+  if (ring_count > 0) {
+    sys->rings = tb_alloc_nm_tp(sys->gp_alloc, ring_count, ThsVlogRing);
+    SDL_memset(sys->rings, 0, sizeof(ThsVlogRing) * ring_count);
+  }
+}
+
+// Runs on the main thread after every other simulation system in the step
+void vlog_flush_tick(ecs_iter_t *it) {
+  TracyCZoneNC(ctx, "Vlog Flush", TracyCategoryColorCore, true);
+
+  ecs_world_t *ecs = it->world;
+  tb_auto *sys = ecs_singleton_get_mut(ecs, ThsVlogSystem);
+
+  const uint32_t drained = drain_rings(ecs, sys);
+  uint32_t dropped = 0;
+  for (int32_t r = 0; r < sys->ring_count; ++r) {
+    dropped += atomic_exchange_explicit(&sys->rings[r].dropped, 0,
+                                        memory_order_relaxed);
+  }
+  TracyCPlot("Vlog Entries", (double)drained);
+  TracyCPlot("Vlog Dropped", (double)dropped);
+
+  // Rings are empty here so they can be replaced safely. They only take
+  // up memory while some category is on
+  const int32_t ring_count =
+      ths_vlog_categories != 0 ? ecs_get_stage_count(ecs) : 0;
+  if (ring_count != sys->ring_count) {
+    resize_rings(sys, ring_count);
+  }
+
+  TracyCZoneEnd(ctx);
+}
+
+// Lets categories be switched while the game runs
+void vlog_overlay_tick(ecs_iter_t *it) {
+  if (!vlog_overlay) {
+    return;
+  }
+  TracyCZoneNC(ctx, "Vlog Overlay", TracyCategoryColorUI, true);
+
+  tb_auto ui = ecs_singleton_get(it->world, TbImGuiSystem);
+  if (ui == NULL || ui->context_count == 0) {
+    TracyCZoneEnd(ctx);
+    return;
+  }
+  igSetCurrentContext(ui->contexts[0].context);
+
+  if (igBegin("Visual Logging", &vlog_overlay,
+              ImGuiWindowFlags_AlwaysAutoResize)) {
+    for (uint32_t i = 0; i < THS_VLOG_CATEGORY_COUNT; ++i) {
+      bool enabled = THS_VLOG_ENABLED(i);
+      if (igCheckbox(category_names[i], &enabled)) {
+        ths_vlog_set_category((ThsVlogCategory)i, enabled);
+      }
+    }
+  }
+  igEnd();
+
+  TracyCZoneEnd(ctx);
+}
+
+void ths_register_vlog_sys(TbWorld *world) {
+  ecs_world_t *ecs = world->ecs;
+  ECS_COMPONENT_DEFINE(ecs, ThsVlogSystem);
+
+  // Rings are allocated by the first flush with a category on
+  ThsVlogSystem sys = {
+      .gp_alloc = world->gp_alloc,
+  };
+  ecs_singleton_set_ptr(ecs, ThsVlogSystem, &sys);
+
+#ifndef THS_VLOG_STRIP
+  // Registered last so it drains what every other system logged this step
+  ecs_system(ecs, {.entity = ecs_entity(
+                       ecs, {.name = "Vlog Flush",
+                             .add = {ecs_dependson(ths_sim_phase(
+                                 ecs, THS_SIM_POST_UPDATE))}}),
+                   .callback = vlog_flush_tick});
+  ecs_system(ecs, {.entity = ecs_entity(ecs, {.name = "Vlog Overlay",
+                                              .add = {ecs_dependson(
+                                                  EcsOnUpdate)}}),
+                   .callback = vlog_overlay_tick});
+#endif
+}
+
+void ths_unregister_vlog_sys(TbWorld *world) {
+  ecs_world_t *ecs = world->ecs;
+  tb_auto *sys = ecs_singleton_get_mut(ecs, ThsVlogSystem);
+  resize_rings(sys, 0);
+  ecs_singleton_remove(ecs, ThsVlogSystem);
+}
+
+TB_REGISTER_SYS(ths, vlog, TB_SYSTEM_NORMAL)
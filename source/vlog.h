@@ -0,0 +1,79 @@
+#pragma once
+
+#include "allocator.h"
+#include "simd.h"
+
+#include <flecs.h>
+
+#include <stdatomic.h>
+
+// Category filtered visual logging for game systems
+//
+// Systems log debug primitives under a category that can be switched on and
+// off while the game runs. A disabled category costs one predictable branch
+// and builds with THS_VLOG_STRIP (every FINAL build) compile the calls away
+//
+// Entries go into a ring owned by the flecs stage that logged them, so
+// worker threads never share a cache line or take a lock. A flush system
+// drains every ring into the engine's visual logger on the main thread
+
+typedef enum ThsVlogCategory {
+  THS_VLOG_BUOYANCY, // Where hulls sample the ocean
+  THS_VLOG_CAMERA,   // Where boat cameras orbit and want to be
+  THS_VLOG_CATEGORY_COUNT,
+} ThsVlogCategory;
+
+// Entries each stage can hold between flushes. A power of two
+#define THS_VLOG_RING_CAPACITY 4096
+
+#ifdef THS_VLOG_STRIP
+#define THS_VLOG_ENABLED(category) false
+#else
+#define THS_VLOG_ENABLED(category)                                             \
+  ((ths_vlog_categories & (1u << (category))) != 0)
+#endif
+
+// Logs a sphere if its category is on. Arguments aren't evaluated otherwise
+#define THS_VLOG_LOCATION(ecs, category, position, radius, color)              \
+  do {                                                                         \
+    if (THS_VLOG_ENABLED(category)) {                                          \
+      ths_vlog_push_location((ecs), (position), (radius), (color));            \
+    }                                                                          \
+  } while (0)
+
+typedef struct ThsVlogEntry {
+  float3 position;
+  float3 color;
+  float radius;
+} ThsVlogEntry;
+
+// Single producer, single consumer. Only the owning stage pushes and only
+// the flush system pops; head and tail are free running counters
+typedef struct ThsVlogRing {
+  _Atomic uint32_t head;
+  _Atomic uint32_t tail;
+  _Atomic uint32_t dropped; // Entries lost to a full ring
+  ThsVlogEntry entries[THS_VLOG_RING_CAPACITY];
+} ThsVlogRing;
+
+typedef struct ThsVlogSystem {
+  TbAllocator gp_alloc;
+  int32_t ring_count;
+  ThsVlogRing *rings; // One per flecs stage while any category is on
+} ThsVlogSystem;
+extern ECS_COMPONENT_DECLARE(ThsVlogSystem);
+
+// One bit per ThsVlogCategory
+extern uint32_t ths_vlog_categories;
+
+const char *ths_vlog_category_name(ThsVlogCategory category);
+void ths_vlog_set_category(ThsVlogCategory category, bool enabled);
+
+// Applies --vlog <names> from the command line, where names is a comma
+// separated list of categories or "all". Also opens an overlay with a
+// toggle per category
+void ths_vlog_configure(int32_t argc, char *argv[]);
+
+// Queues a sphere on the calling stage's ring. Prefer THS_VLOG_LOCATION
+void ths_vlog_push_location(ecs_world_t *ecs, float3 position, float radius,
+                            float3 color);
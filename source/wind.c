@@ -0,0 +1,249 @@
+#include "wind.h"
+
+#include "profiler.h"
+#include "profiling.h"
+#include "simdlanes.h"
+#include "simulation.h"
+#include "tbcommon.h"
+#include "world.h"
+
+#include <SDL3/SDL_stdinc.h>
+
+ECS_COMPONENT_DECLARE(ThsWindField);
+
+#define WIND_GRID_POINTS (THS_WIND_GRID_CELLS * THS_WIND_GRID_CELLS)
+#define WIND_GRID_MASK (THS_WIND_GRID_CELLS - 1)
+
+static ThsProfileTrack wind_track = 0;
+
+ThsWindDesc ths_wind_default_desc(void) {
+  return (ThsWindDesc){
+      .cell_size = THS_WIND_DEFAULT_CELL_SIZE,
+      .base_speed = 8.0f,
+      .base_angle = 0.3f,
+      .veer_amplitude = 0.35f,
+      .veer_period = 600.0f,
+      .gust_strength = 0.35f,
+      .gust_wavelength = 400.0f,
+      .gust_speed = 10.0f,
+      .front_speed = 6.0f,
+      .front_width = 150.0f,
+      .front_strength = 5.0f,
+      .response = 4.0f,
+  };
+}
+
+void ths_create_wind_field(TbAllocator gp_alloc, const ThsWindDesc *desc,
+                           ThsWindField *wind) {
+  *wind = (ThsWindField){
+      .gp_alloc = gp_alloc,
+      .desc = *desc,
+      .inv_cell_size = 1.0f / desc->cell_size,
+      .u = tb_alloc_nm_tp(gp_alloc, WIND_GRID_POINTS, float),
+      .v = tb_alloc_nm_tp(gp_alloc, WIND_GRID_POINTS, float),
+      .xs = tb_alloc_nm_tp(gp_alloc, WIND_GRID_POINTS, float),
+      .zs = tb_alloc_nm_tp(gp_alloc, WIND_GRID_POINTS, float),
+  };
+  // Starts out as the calm prevailing wind so boats don't wait for it to
+  // build up
+  const float u = SDL_cosf(desc->base_angle) * desc->base_speed;
+  const float v = SDL_sinf(desc->base_angle) * desc->base_speed;
+  for (uint32_t z = 0; z < THS_WIND_GRID_CELLS; ++z) {
+    for (uint32_t x = 0; x < THS_WIND_GRID_CELLS; ++x) {
+      const uint32_t idx = z * THS_WIND_GRID_CELLS + x;
+      wind->xs[idx] = (float)x * desc->cell_size;
+      wind->zs[idx] = (float)z * desc->cell_size;
+      wind->u[idx] = u;
+      wind->v[idx] = v;
+    }
+  }
+}
+
+void ths_destroy_wind_field(ThsWindField *wind) {
+  tb_free(wind->gp_alloc, wind->u);
+  tb_free(wind->gp_alloc, wind->v);
+  tb_free(wind->gp_alloc, wind->xs);
+  tb_free(wind->gp_alloc, wind->zs);
+  *wind = (ThsWindField){0};
+}
+
+// Wave vector with a whole number of periods across the grid that points
+// roughly along the given direction, so patterns tile without a seam
+static float2 tiling_wave(float extent, float wavelength, float2 dir) {
+  const float periods = SDL_max(extent / wavelength, 1.0f);
+  float nx = SDL_roundf(dir.x * periods);
+  float nz = SDL_roundf(dir.y * periods);
+  if (nx == 0.0f && nz == 0.0f) {
+    nx = 1.0f;
+  }
+  const float k = 2.0f * SDL_PI_F / extent;
+  return (float2){nx * k, nz * k};
+}
+
+void ths_update_wind_field(ThsWindField *wind, float dt) {
+  const ThsWindDesc *desc = &wind->desc;
+  wind->time += dt;
+  const float t = wind->time;
+  const float extent = desc->cell_size * THS_WIND_GRID_CELLS;
+
+  // Everything that is the same for the whole grid this step
+  const float angle =
+      desc->base_angle +
+      desc->veer_amplitude *
+          SDL_sinf(2.0f * SDL_PI_F * t / SDL_max(desc->veer_period, 1.0f));
+  const float2 dir = {SDL_cosf(angle), SDL_sinf(angle)};
+  const float2 across = {-dir.y, dir.x};
+
+  // Gusts roll downwind of the prevailing direction and are broken up
+  // across it so they arrive as patches rather than lines
+  const float2 base_dir = {SDL_cosf(desc->base_angle),
+                           SDL_sinf(desc->base_angle)};
+  const float2 base_across = {-base_dir.y, base_dir.x};
+  const float2 gust_k = tiling_wave(extent, desc->gust_wavelength, base_dir);
+  const float2 patch_k =
+      tiling_wave(extent, desc->gust_wavelength * 2.0f, base_across);
+  const float gust_k_len = SDL_sqrtf(gust_k.x * gust_k.x + gust_k.y * gust_k.y);
+  const float gust_phase = gust_k_len * desc->gust_speed * t;
+  const float patch_phase = 0.1f * t;
+
+  // The front is the zero crossing of a wave one grid across. Near it the
+  // sine is close to the distance from it, which gives the band its shape
+  const float2 front_k = tiling_wave(extent, extent, base_dir);
+  const float front_k_len =
+      SDL_sqrtf(front_k.x * front_k.x + front_k.y * front_k.y);
+  const float front_phase = front_k_len * desc->front_speed * t;
+  const float front_scale =
+      2.0f / (front_k_len * SDL_max(desc->front_width, 1.0f));
+
+  const float alpha = SDL_min(dt / SDL_max(desc->response, dt), 1.0f);
+
+  const ThsLane gust_kx = ths_lane_set1(gust_k.x);
+  const ThsLane gust_kz = ths_lane_set1(gust_k.y);
+  const ThsLane patch_kx = ths_lane_set1(patch_k.x);
+  const ThsLane patch_kz = ths_lane_set1(patch_k.y);
+  const ThsLane front_kx = ths_lane_set1(front_k.x * 0.5f);
+  const ThsLane front_kz = ths_lane_set1(front_k.y * 0.5f);
+  const ThsLane gust_offset = ths_lane_set1(gust_phase);
+  const ThsLane patch_offset = ths_lane_set1(patch_phase);
+  const ThsLane front_offset = ths_lane_set1(front_phase * 0.5f);
+  const ThsLane front_scale_l = ths_lane_set1(front_scale);
+  const ThsLane one = ths_lane_set1(1.0f);
+  const ThsLane half = ths_lane_set1(0.5f);
+  const ThsLane gust_strength = ths_lane_set1(desc->gust_strength);
+  const ThsLane front_strength = ths_lane_set1(desc->front_strength);
+  const ThsLane base_u = ths_lane_set1(dir.x * desc->base_speed);
+  const ThsLane base_v = ths_lane_set1(dir.y * desc->base_speed);
+  const ThsLane across_u = ths_lane_set1(across.x);
+  const ThsLane across_v = ths_lane_set1(across.y);
+  const ThsLane alpha_l = ths_lane_set1(alpha);
+
+  for (uint32_t i = 0; i < WIND_GRID_POINTS; i += THS_LANE_WIDTH) {
+    const ThsLane x = ths_lane_load(&wind->xs[i]);
+    const ThsLane z = ths_lane_load(&wind->zs[i]);
+
+    ThsLane gust_s, gust_c, patch_s, patch_c, front_s, front_c;
+    ths_lane_sincos(ths_lane_sub(ths_lane_madd(x, gust_kx,
+                                               ths_lane_mul(z, gust_kz)),
+                                 gust_offset),
+                    &gust_s, &gust_c);
+    ths_lane_sincos(ths_lane_add(ths_lane_madd(x, patch_kx,
+                                               ths_lane_mul(z, patch_kz)),
+                                 patch_offset),
+                    &patch_s, &patch_c);
+    // Half the front's wave so its sine only crosses zero once per grid
+    ths_lane_sincos(ths_lane_sub(ths_lane_madd(x, front_kx,
+                                               ths_lane_mul(z, front_kz)),
+                                 front_offset),
+                    &front_s, &front_c);
+
+    // 1 +- gust_strength, with patches fading gusts in and out
+    const ThsLane patch = ths_lane_madd(patch_s, half, half);
+    const ThsLane gust =
+        ths_lane_madd(ths_lane_mul(gust_s, patch), gust_strength, one);
+
+    // Falls off with the square of the distance from the front
+    const ThsLane d = ths_lane_mul(front_s, front_scale_l);
+    const ThsLane front =
+        ths_lane_div(front_strength, ths_lane_madd(d, d, one));
+
+    const ThsLane target_u =
+        ths_lane_madd(base_u, gust, ths_lane_mul(across_u, front));
+    const ThsLane target_v =
+        ths_lane_madd(base_v, gust, ths_lane_mul(across_v, front));
+
+    const ThsLane u = ths_lane_load(&wind->u[i]);
+    const ThsLane v = ths_lane_load(&wind->v[i]);
+    ths_lane_store(&wind->u[i],
+                   ths_lane_madd(ths_lane_sub(target_u, u), alpha_l, u));
+    ths_lane_store(&wind->v[i],
+                   ths_lane_madd(ths_lane_sub(target_v, v), alpha_l, v));
+  }
+}
+
+float2 ths_sample_wind(const ThsWindField *wind, float2 pos) {
+  const float fx = pos.x * wind->inv_cell_size;
+  const float fz = pos.y * wind->inv_cell_size;
+  const float cell_x = SDL_floorf(fx);
+  const float cell_z = SDL_floorf(fz);
+  const float tx = fx - cell_x;
+  const float tz = fz - cell_z;
+
+  // The grid tiles so neighbours wrap around
+  const uint32_t x0 = (uint32_t)(int32_t)cell_x & WIND_GRID_MASK;
+  const uint32_t z0 = (uint32_t)(int32_t)cell_z & WIND_GRID_MASK;
+  const uint32_t x1 = (x0 + 1) & WIND_GRID_MASK;
+  const uint32_t z1 = (z0 + 1) & WIND_GRID_MASK;
+  const uint32_t idx[4] = {
+      z0 * THS_WIND_GRID_CELLS + x0,
+      z0 * THS_WIND_GRID_CELLS + x1,
+      z1 * THS_WIND_GRID_CELLS + x0,
+      z1 * THS_WIND_GRID_CELLS + x1,
+  };
+
+  float2 corners[4];
+  for (uint32_t i = 0; i < 4; ++i) {
+    corners[i] = (float2){wind->u[idx[i]], wind->v[idx[i]]};
+  }
+  const float2 top = corners[0] + (corners[1] - corners[0]) * tx;
+  const float2 bottom = corners[2] + (corners[3] - corners[2]) * tx;
+  return top + (bottom - top) * tz;
+}
+
+void wind_update_tick(ecs_iter_t *it) {
+  TracyCZoneNC(ctx, "Wind Update", TracyCategoryColorGame, true);
+  ThsProfileScope prof = ths_profile_begin(wind_track);
+
+  tb_auto *wind = ecs_singleton_get_mut(it->world, ThsWindField);
+  ths_update_wind_field(wind, it->delta_time);
+
+  ths_profile_end(prof);
+  TracyCZoneEnd(ctx);
+}
+
+void ths_register_wind_sys(TbWorld *world) {
+  ecs_world_t *ecs = world->ecs;
+  ECS_COMPONENT_DEFINE(ecs, ThsWindField);
+
+  wind_track = ths_profiler_track("Wind Update");
+
+  const ThsWindDesc desc = ths_wind_default_desc();
+  ThsWindField wind = {0};
+  ths_create_wind_field(world->gp_alloc, &desc, &wind);
+  ecs_singleton_set_ptr(ecs, ThsWindField, &wind);
+
+  // Boats read the wind during their tick
+  ecs_system(ecs, {.entity = ecs_entity(
+                       ecs, {.name = "Wind Update",
+                             .add = {ecs_dependson(ths_sim_phase(
+                                 ecs, THS_SIM_PRE_UPDATE))}}),
+                   .callback = wind_update_tick});
+}
+
+void ths_unregister_wind_sys(TbWorld *world) {
+  ecs_world_t *ecs = world->ecs;
+  tb_auto *wind = ecs_singleton_get_mut(ecs, ThsWindField);
+  ths_destroy_wind_field(wind);
+  ecs_singleton_remove(ecs, ThsWindField);
+}
+
+TB_REGISTER_SYS(ths, wind, TB_SYSTEM_NORMAL)
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "allocator.h"
+#include "simd.h"
+
+#include <flecs.h>
+
+// Wind over the sea
+//
+// A coarse grid of wind velocities on the XZ plane that tiles across the
+// world, so every point has wind without the grid following the boats. Each
+// step the grid relaxes towards a target made of a slowly veering prevailing
+// wind, gusts rolling across it and a front sweeping through. Updating it
+// costs the same no matter how many boats there are; boats only pay for a
+// bilinear fetch
+//
+// Positions and velocities are on the XZ plane with Z in the second lane
+
+// Cells along each side of the grid. A multiple of every lane width
+#define THS_WIND_GRID_CELLS 64
+#define THS_WIND_DEFAULT_CELL_SIZE 64.0f
+
+typedef struct ThsWindDesc {
+  float cell_size;       // Meters between grid points
+  float base_speed;      // m/s of the prevailing wind
+  float base_angle;      // Radians from +X towards +Z the wind blows to
+  float veer_amplitude;  // How far in radians the prevailing wind swings
+  float veer_period;     // Seconds for one full swing
+  float gust_strength;   // Fraction of the base speed gusts add or remove
+  float gust_wavelength; // Meters between gust crests
+  float gust_speed;      // m/s the gusts roll downwind
+  float front_speed;     // m/s the front sweeps across the grid
+  float front_width;     // Meters; how wide the band of the front is
+  float front_strength;  // m/s the front adds across the prevailing wind
+  float response;        // Seconds for the grid to settle on its target
+} ThsWindDesc;
+
+typedef struct ThsWindField {
+  TbAllocator gp_alloc;
+  ThsWindDesc desc;
+  float time;
+  float inv_cell_size;
+
+  // Wind velocity per grid point, row by row along X
+  float *u; // X
+  float *v; // Z
+  // Grid point positions within the tile, filled once
+  float *xs;
+  float *zs;
+} ThsWindField;
+extern ECS_COMPONENT_DECLARE(ThsWindField);
+
+ThsWindDesc ths_wind_default_desc(void);
+
+void ths_create_wind_field(TbAllocator gp_alloc, const ThsWindDesc *desc,
+                           ThsWindField *wind);
+void ths_destroy_wind_field(ThsWindField *wind);
+
+// Advances the wind by dt seconds
+void ths_update_wind_field(ThsWindField *wind, float dt);
+
+// Bilinear fetch of the wind velocity at a point
+float2 ths_sample_wind(const ThsWindField *wind, float2 pos);
@@ -0,0 +1,159 @@
+// Bakes the component extras of a glb into a .thsc sidecar
+//
+// Usage: thehighseas_cook <scene.glb> <scene.glb.thsc>
+//
+// Descriptors are filled through the flecs meta cursor using the same
+// ecs_struct definitions the runtime registers, so adding a member to a
+// descriptor needs no changes here
+#include "cookedcomponents.h"
+
+#include "tbcommon.h"
+#include "tbgltf.h"
+#include "world.h"
+
+#include <SDL3/SDL.h>
+
+#include <flecs.h>
+#include <json.h>
+
+ecs_entity_t ths_register_boat_movement_comp(TbWorld *world);
+ecs_entity_t ths_register_boat_camera_comp(TbWorld *world);
+ecs_entity_t ths_register_ship_ai_comp(TbWorld *world);
+
+// Extras keys match the names the components are registered under. Only
+// descriptors made of plain values can be cooked; anything holding strings
+// or pointers stays on the json path
+typedef struct CookableComp {
+  const char *key;
+  ecs_entity_t (*register_fn)(TbWorld *world);
+  ecs_entity_t desc_type;
+} CookableComp;
+
+static CookableComp cookable[] = {
+    {"boat_movement", ths_register_boat_movement_comp, 0},
+    {"boat_camera", ths_register_boat_camera_comp, 0},
+    {"ship_ai", ths_register_ship_ai_comp, 0},
+};
+
+static const CookableComp *find_cookable(const char *key) {
+  for (uint32_t i = 0; i < SDL_arraysize(cookable); ++i) {
+    if (SDL_strcmp(cookable[i].key, key) == 0) {
+      return &cookable[i];
+    }
+  }
+  return NULL;
+}
+
+// Walks the json object and writes every member the descriptor knows about
+static bool fill_descriptor(ecs_world_t *ecs, ecs_entity_t type, void *ptr,
+                            json_object *json) {
+  ecs_meta_cursor_t cur = ecs_meta_cursor(ecs, type, ptr);
+  if (ecs_meta_push(&cur) != 0) {
+    return false;
+  }
+  json_object_object_foreach(json, key, value) {
+    if (ecs_meta_member(&cur, key) != 0) {
+      SDL_Log("Cook: skipping unknown member %s", key);
+      continue;
+    }
+    switch (json_object_get_type(value)) {
+    case json_type_double:
+      ecs_meta_set_float(&cur, json_object_get_double(value));
+      break;
+    case json_type_int:
+      ecs_meta_set_int(&cur, json_object_get_int64(value));
+      break;
+    case json_type_boolean:
+      ecs_meta_set_bool(&cur, json_object_get_boolean(value));
+      break;
+    default:
+      SDL_Log("Cook: member %s has a type that can't be cooked", key);
+      return false;
+    }
+  }
+  return ecs_meta_pop(&cur) == 0;
+}
+
+static uint32_t cook_node(ecs_world_t *ecs, const cgltf_data *gltf,
+                          const cgltf_node *node, ThsCookedWriter *writer) {
+  cgltf_size extras_size = 0;
+  cgltf_copy_extras_json(gltf, &node->extras, NULL, &extras_size);
+  if (extras_size == 0 || node->name == NULL) {
+    return 0;
+  }
+  char *extras_str = SDL_calloc(1, extras_size + 1);
+  cgltf_copy_extras_json(gltf, &node->extras, extras_str, &extras_size);
+  json_object *extras = json_tokener_parse(extras_str);
+  SDL_free(extras_str);
+  if (extras == NULL) {
+    return 0;
+  }
+
+  uint32_t cooked = 0;
+  json_object_object_foreach(extras, key, value) {
+    const CookableComp *comp = find_cookable(key);
+    if (comp == NULL || !json_object_is_type(value, json_type_object)) {
+      continue;
+    }
+    const EcsComponent *info = ecs_get(ecs, comp->desc_type, EcsComponent);
+    void *desc = SDL_calloc(1, info->size);
+    if (fill_descriptor(ecs, comp->desc_type, desc, value)) {
+      ths_cooked_writer_add(writer, node->name,
+                            ecs_get_name(ecs, comp->desc_type), desc,
+                            (uint32_t)info->size);
+      cooked++;
+    } else {
+      SDL_Log("Cook: failed to cook %s on node %s", key, node->name);
+    }
+    SDL_free(desc);
+  }
+  json_object_put(extras);
+  return cooked;
+}
+
+int32_t main(int32_t argc, char *argv[]) {
+  if (argc < 3) {
+    SDL_Log("Usage: %s <scene.glb> <scene.glb.thsc>", argv[0]);
+    return 1;
+  }
+  const char *in_path = argv[1];
+  const char *out_path = argv[2];
+
+  TbGeneralAllocator gp_alloc = {0};
+  tb_create_gen_alloc(&gp_alloc, "cook_alloc");
+
+  cgltf_options options = {0};
+  cgltf_data *gltf = NULL;
+  if (cgltf_parse_file(&options, in_path, &gltf) != cgltf_result_success) {
+    SDL_Log("Cook: failed to parse %s", in_path);
+    return 1;
+  }
+
+  TbWorld world = {
+      .ecs = ecs_init(),
+      .gp_alloc = gp_alloc.alloc,
+  };
+  for (uint32_t i = 0; i < SDL_arraysize(cookable); ++i) {
+    cookable[i].desc_type = cookable[i].register_fn(&world);
+  }
+
+  ThsCookedWriter writer = {0};
+  ths_create_cooked_writer(gp_alloc.alloc, &writer);
+  uint32_t record_count = 0;
+  for (cgltf_size i = 0; i < gltf->nodes_count; ++i) {
+    record_count += cook_node(world.ecs, gltf, &gltf->nodes[i], &writer);
+  }
+
+  const bool ok = ths_cooked_writer_save(&writer, out_path);
+  if (ok) {
+    SDL_Log("Cook: %u component records from %s", record_count, in_path);
+  } else {
+    SDL_Log("Cook: failed to write %s", out_path);
+  }
+
+  ths_destroy_cooked_writer(&writer);
+  ecs_fini(world.ecs);
+  cgltf_free(gltf);
+  tb_destroy_gen_alloc(gp_alloc);
+  return ok ? 0 : 1;
+}
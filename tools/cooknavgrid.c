@@ -0,0 +1,282 @@
+// Bakes the islands of a glb into a .thsn navigation grid sidecar
+//
+// Usage: thehighseas_navbake <scene.glb> <scene.glb.thsn> [cell_size] [margin]
+//
+// Any mesh node named like an island, or carrying "nav_obstacle" in its
+// extras, blocks every cell its triangles cover above sea level. Blocked
+// cells are then grown by the margin so hulls keep clear of the shore.
+// Scenes without islands get an empty grid and ships treat them as open water
+#include "navigation.h"
+
+#include "tbgltf.h"
+
+#include <SDL3/SDL.h>
+
+#include <stdio.h>
+
+#define DEFAULT_CELL_SIZE 8.0f
+#define DEFAULT_MARGIN 8.0f
+// Open water around the islands so ships can path around the outside
+#define GRID_PADDING 256.0f
+#define SEA_LEVEL 0.0f
+#define MAX_GRID_CELLS (4096 * 4096)
+
+typedef struct NavBake {
+  ThsNavGridHeader header;
+  uint8_t *blocked;
+} NavBake;
+
+static bool is_obstacle(const cgltf_data *gltf, const cgltf_node *node) {
+  if (node->mesh == NULL) {
+    return false;
+  }
+  if (node->name) {
+    char name[256] = {0};
+    SDL_strlcpy(name, node->name, sizeof(name));
+    SDL_strlwr(name);
+    if (SDL_strstr(name, "island")) {
+      return true;
+    }
+  }
+  cgltf_size extras_size = 0;
+  cgltf_copy_extras_json(gltf, &node->extras, NULL, &extras_size);
+  if (extras_size == 0) {
+    return false;
+  }
+  char *extras = SDL_calloc(1, extras_size + 1);
+  cgltf_copy_extras_json(gltf, &node->extras, extras, &extras_size);
+  const bool obstacle = SDL_strstr(extras, "\"nav_obstacle\"") != NULL;
+  SDL_free(extras);
+  return obstacle;
+}
+
+static float3 transform_point(const float m[16], const float p[3]) {
+  return (float3){
+      m[0] * p[0] + m[4] * p[1] + m[8] * p[2] + m[12],
+      m[1] * p[0] + m[5] * p[1] + m[9] * p[2] + m[13],
+      m[2] * p[0] + m[6] * p[1] + m[10] * p[2] + m[14],
+  };
+}
+
+typedef void (*TriangleFn)(void *user, float3 a, float3 b, float3 c);
+
+static void for_each_triangle(const cgltf_data *gltf, TriangleFn fn,
+                              void *user) {
+  for (cgltf_size n = 0; n < gltf->nodes_count; ++n) {
+    const cgltf_node *node = &gltf->nodes[n];
+    if (!is_obstacle(gltf, node)) {
+      continue;
+    }
+    float world[16] = {0};
+    cgltf_node_transform_world(node, world);
+
+    for (cgltf_size p = 0; p < node->mesh->primitives_count; ++p) {
+      const cgltf_primitive *prim = &node->mesh->primitives[p];
+      if (prim->type != cgltf_primitive_type_triangles) {
+        continue;
+      }
+      const cgltf_accessor *positions = NULL;
+      for (cgltf_size a = 0; a < prim->attributes_count; ++a) {
+        if (prim->attributes[a].type == cgltf_attribute_type_position) {
+          positions = prim->attributes[a].data;
+        }
+      }
+      if (positions == NULL) {
+        continue;
+      }
+      const cgltf_size count =
+          prim->indices ? prim->indices->count : positions->count;
+      for (cgltf_size i = 0; i + 2 < count; i += 3) {
+        float3 tri[3] = {0};
+        for (cgltf_size v = 0; v < 3; ++v) {
+          const cgltf_size idx =
+              prim->indices ? cgltf_accessor_read_index(prim->indices, i + v)
+                            : i + v;
+          float local[3] = {0};
+          cgltf_accessor_read_float(positions, idx, local, 3);
+          tri[v] = transform_point(world, local);
+        }
+        fn(user, tri[0], tri[1], tri[2]);
+      }
+    }
+  }
+}
+
+typedef struct Bounds {
+  float min_x, min_z, max_x, max_z;
+  uint32_t triangles;
+} Bounds;
+
+static void grow_bounds(void *user, float3 a, float3 b, float3 c) {
+  Bounds *bounds = user;
+  const float3 tri[3] = {a, b, c};
+  for (uint32_t i = 0; i < 3; ++i) {
+    bounds->min_x = SDL_min(bounds->min_x, tri[i].x);
+    bounds->min_z = SDL_min(bounds->min_z, tri[i].z);
+    bounds->max_x = SDL_max(bounds->max_x, tri[i].x);
+    bounds->max_z = SDL_max(bounds->max_z, tri[i].z);
+  }
+  bounds->triangles++;
+}
+
+static float edge(float ax, float az, float bx, float bz, float px, float pz) {
+  return (bx - ax) * (pz - az) - (bz - az) * (px - ax);
+}
+
+// Marks cells whose centers the triangle covers on the XZ plane, plus the
+// cells of its corners so slivers thinner than a cell still count
+static void rasterize(void *user, float3 a, float3 b, float3 c) {
+  NavBake *bake = user;
+  if (a.y <= SEA_LEVEL && b.y <= SEA_LEVEL && c.y <= SEA_LEVEL) {
+    return;
+  }
+  const ThsNavGridHeader *h = &bake->header;
+  const float inv = 1.0f / h->cell_size;
+  const float3 tri[3] = {a, b, c};
+
+  const float min_x = SDL_min(a.x, SDL_min(b.x, c.x));
+  const float max_x = SDL_max(a.x, SDL_max(b.x, c.x));
+  const float min_z = SDL_min(a.z, SDL_min(b.z, c.z));
+  const float max_z = SDL_max(a.z, SDL_max(b.z, c.z));
+  const int32_t x0 = SDL_max((int32_t)((min_x - h->origin_x) * inv), 0);
+  const int32_t z0 = SDL_max((int32_t)((min_z - h->origin_z) * inv), 0);
+  const int32_t x1 =
+      SDL_min((int32_t)((max_x - h->origin_x) * inv), (int32_t)h->width - 1);
+  const int32_t z1 =
+      SDL_min((int32_t)((max_z - h->origin_z) * inv), (int32_t)h->height - 1);
+
+  const float area = edge(a.x, a.z, b.x, b.z, c.x, c.z);
+  for (int32_t z = z0; z <= z1; ++z) {
+    for (int32_t x = x0; x <= x1; ++x) {
+      const float px = h->origin_x + ((float)x + 0.5f) * h->cell_size;
+      const float pz = h->origin_z + ((float)z + 0.5f) * h->cell_size;
+      const float w0 = edge(b.x, b.z, c.x, c.z, px, pz);
+      const float w1 = edge(c.x, c.z, a.x, a.z, px, pz);
+      const float w2 = edge(a.x, a.z, b.x, b.z, px, pz);
+      // Either winding
+      const bool inside = area >= 0.0f ? (w0 >= 0 && w1 >= 0 && w2 >= 0)
+                                       : (w0 <= 0 && w1 <= 0 && w2 <= 0);
+      if (inside) {
+        bake->blocked[z * (int32_t)h->width + x] = 1;
+      }
+    }
+  }
+  for (uint32_t v = 0; v < 3; ++v) {
+    const int32_t x = (int32_t)((tri[v].x - h->origin_x) * inv);
+    const int32_t z = (int32_t)((tri[v].z - h->origin_z) * inv);
+    if (x >= 0 && z >= 0 && x < (int32_t)h->width && z < (int32_t)h->height) {
+      bake->blocked[z * (int32_t)h->width + x] = 1;
+    }
+  }
+}
+
+// Grows blocked cells by a square of the given radius
+static void dilate(NavBake *bake, int32_t radius) {
+  if (radius <= 0) {
+    return;
+  }
+  const int32_t w = (int32_t)bake->header.width;
+  const int32_t h = (int32_t)bake->header.height;
+  uint8_t *src = SDL_malloc((size_t)w * h);
+  SDL_memcpy(src, bake->blocked, (size_t)w * h);
+  for (int32_t z = 0; z < h; ++z) {
+    for (int32_t x = 0; x < w; ++x) {
+      if (!src[z * w + x]) {
+        continue;
+      }
+      for (int32_t dz = -radius; dz <= radius; ++dz) {
+        for (int32_t dx = -radius; dx <= radius; ++dx) {
+          const int32_t nx = x + dx;
+          const int32_t nz = z + dz;
+          if (nx >= 0 && nz >= 0 && nx < w && nz < h) {
+            bake->blocked[nz * w + nx] = 1;
+          }
+        }
+      }
+    }
+  }
+  SDL_free(src);
+}
+
+int32_t main(int32_t argc, char *argv[]) {
+  if (argc < 3) {
+    SDL_Log("Usage: %s <scene.glb> <scene.glb.thsn> [cell_size] [margin]",
+            argv[0]);
+    return 1;
+  }
+  const char *in_path = argv[1];
+  const char *out_path = argv[2];
+  const float cell_size =
+      argc > 3 ? (float)SDL_atof(argv[3]) : DEFAULT_CELL_SIZE;
+  const float margin = argc > 4 ? (float)SDL_atof(argv[4]) : DEFAULT_MARGIN;
+  if (cell_size <= 0.0f) {
+    SDL_Log("Nav bake: cell size must be positive");
+    return 1;
+  }
+
+  cgltf_options options = {0};
+  cgltf_data *gltf = NULL;
+  if (cgltf_parse_file(&options, in_path, &gltf) != cgltf_result_success ||
+      cgltf_load_buffers(&options, gltf, in_path) != cgltf_result_success) {
+    SDL_Log("Nav bake: failed to load %s", in_path);
+    cgltf_free(gltf);
+    return 1;
+  }
+
+  Bounds bounds = {SDL_FLT_MAX, SDL_FLT_MAX, -SDL_FLT_MAX, -SDL_FLT_MAX, 0};
+  for_each_triangle(gltf, grow_bounds, &bounds);
+
+  // An empty sidecar is still written so the build has something to track;
+  // the runtime treats a grid without blocked cells like no grid at all
+  NavBake bake = {
+      .header =
+          {
+              .magic = THS_NAV_MAGIC,
+              .version = THS_NAV_VERSION,
+              .cell_size = cell_size,
+          },
+  };
+  if (bounds.triangles > 0) {
+    bake.header.origin_x = bounds.min_x - GRID_PADDING;
+    bake.header.origin_z = bounds.min_z - GRID_PADDING;
+    const float extent_x = bounds.max_x - bounds.min_x + GRID_PADDING * 2;
+    const float extent_z = bounds.max_z - bounds.min_z + GRID_PADDING * 2;
+    bake.header.width = (uint32_t)SDL_ceilf(extent_x / cell_size);
+    bake.header.height = (uint32_t)SDL_ceilf(extent_z / cell_size);
+    if ((uint64_t)bake.header.width * bake.header.height > MAX_GRID_CELLS) {
+      SDL_Log("Nav bake: %ux%u cells is too many; raise the cell size",
+              bake.header.width, bake.header.height);
+      cgltf_free(gltf);
+      return 1;
+    }
+    bake.blocked =
+        SDL_calloc((size_t)bake.header.width * bake.header.height, 1);
+    for_each_triangle(gltf, rasterize, &bake);
+    dilate(&bake, (int32_t)SDL_ceilf(margin / cell_size));
+  }
+  cgltf_free(gltf);
+
+  const size_t cell_count = (size_t)bake.header.width * bake.header.height;
+  for (size_t i = 0; i < cell_count; ++i) {
+    bake.header.blocked_count += bake.blocked[i];
+  }
+
+  bool ok = false;
+  FILE *file = fopen(out_path, "wb");
+  if (file) {
+    ok = fwrite(&bake.header, sizeof(bake.header), 1, file) == 1;
+    if (ok && cell_count > 0) {
+      ok = fwrite(bake.blocked, 1, cell_count, file) == cell_count;
+    }
+    ok = fclose(file) == 0 && ok;
+  }
+  if (ok) {
+    SDL_Log("Nav bake: %ux%u cells, %u blocked from %u triangles of %s",
+            bake.header.width, bake.header.height, bake.header.blocked_count,
+            bounds.triangles, in_path);
+  } else {
+    SDL_Log("Nav bake: failed to write %s", out_path);
+  }
+  SDL_free(bake.blocked);
+  return ok ? 0 : 1;
+}
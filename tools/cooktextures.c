@@ -0,0 +1,244 @@
+// Helps turn the images of a glb into KTX2 textures
+//
+// Usage: thehighseas_texcook extract <scene.glb> <out_dir>
+//        thehighseas_texcook verify <out_dir>
+//
+// extract writes every image of the scene to out_dir along with images.txt,
+// one line per image: name, file, color space and the scale that brings it
+// down to the low tier. toktx then encodes both tiers of each image to UASTC
+// (see cooktextures.cmake). verify transcodes every encoded texture on the
+// CPU, logs what cooking did to its size and writes manifest.txt. Only
+// textures that transcode make it into the manifest, so a bad encode shows
+// up at build time
+#include "ktxtranscode.h"
+
+#include "tbgltf.h"
+
+#include <SDL3/SDL.h>
+
+#include <stdio.h>
+
+#define IMAGE_LIST "images.txt"
+#define MAX_PATH_LEN 1024
+
+static uint32_t read_be16(const uint8_t *p) {
+  return ((uint32_t)p[0] << 8) | p[1];
+}
+
+static uint32_t read_be32(const uint8_t *p) {
+  return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) |
+         ((uint32_t)p[2] << 8) | p[3];
+}
+
+// Pulls the dimensions out of a PNG or JPEG header without decoding it
+static bool image_size(const uint8_t *data, size_t size, uint32_t *width,
+                       uint32_t *height) {
+  static const uint8_t png_sig[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A,
+                                     '\n'};
+  if (size >= 24 && SDL_memcmp(data, png_sig, sizeof(png_sig)) == 0) {
+    *width = read_be32(data + 16);
+    *height = read_be32(data + 20);
+    return true;
+  }
+  if (size < 4 || data[0] != 0xFF || data[1] != 0xD8) {
+    return false;
+  }
+  // Walk the JPEG segments to the first start of frame
+  size_t i = 2;
+  while (i + 9 < size) {
+    if (data[i] != 0xFF) {
+      return false;
+    }
+    const uint8_t marker = data[i + 1];
+    const bool sof = marker >= 0xC0 && marker <= 0xCF && marker != 0xC4 &&
+                     marker != 0xC8 && marker != 0xCC;
+    if (sof) {
+      *height = read_be16(data + i + 5);
+      *width = read_be16(data + i + 7);
+      return true;
+    }
+    i += 2 + read_be16(data + i + 2);
+  }
+  return false;
+}
+
+static bool is_color_image(const cgltf_data *gltf, const cgltf_image *image) {
+  for (cgltf_size i = 0; i < gltf->materials_count; ++i) {
+    const cgltf_material *mat = &gltf->materials[i];
+    const cgltf_texture *color[] = {
+        mat->pbr_metallic_roughness.base_color_texture.texture,
+        mat->pbr_specular_glossiness.diffuse_texture.texture,
+        mat->emissive_texture.texture,
+    };
+    for (uint32_t t = 0; t < SDL_arraysize(color); ++t) {
+      if (color[t] && color[t]->image == image) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+static bool write_file(const char *path, const void *data, size_t size) {
+  FILE *file = fopen(path, "wb");
+  if (file == NULL) {
+    return false;
+  }
+  bool ok = fwrite(data, 1, size, file) == size;
+  ok = fclose(file) == 0 && ok;
+  return ok;
+}
+
+static int32_t extract(const char *scene_path, const char *out_dir) {
+  cgltf_options options = {0};
+  cgltf_data *gltf = NULL;
+  if (cgltf_parse_file(&options, scene_path, &gltf) != cgltf_result_success ||
+      cgltf_load_buffers(&options, gltf, scene_path) !=
+          cgltf_result_success) {
+    SDL_Log("Texture cook: failed to load %s", scene_path);
+    cgltf_free(gltf);
+    return 1;
+  }
+
+  char path[MAX_PATH_LEN] = {0};
+  SDL_snprintf(path, sizeof(path), "%s/%s", out_dir, IMAGE_LIST);
+  FILE *list = fopen(path, "w");
+  if (list == NULL) {
+    SDL_Log("Texture cook: failed to open %s", path);
+    cgltf_free(gltf);
+    return 1;
+  }
+
+  bool ok = true;
+  for (cgltf_size i = 0; i < gltf->images_count; ++i) {
+    const cgltf_image *image = &gltf->images[i];
+    // Only images packed into the glb; the exporter embeds everything
+    const cgltf_buffer_view *view = image->buffer_view;
+    if (view == NULL || view->buffer->data == NULL) {
+      SDL_Log("Texture cook: skipping external image %u", (uint32_t)i);
+      continue;
+    }
+    const uint8_t *data = (const uint8_t *)view->buffer->data + view->offset;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    if (!image_size(data, view->size, &width, &height) || width == 0 ||
+        height == 0) {
+      SDL_Log("Texture cook: image %u is neither PNG nor JPEG", (uint32_t)i);
+      continue;
+    }
+    const bool png = data[0] == 0x89;
+
+    char name[64] = {0};
+    SDL_snprintf(name, sizeof(name), "image%u", (uint32_t)i);
+    char file_name[80] = {0};
+    SDL_snprintf(file_name, sizeof(file_name), "%s.%s", name,
+                 png ? "png" : "jpg");
+    SDL_snprintf(path, sizeof(path), "%s/%s", out_dir, file_name);
+    if (!write_file(path, data, view->size)) {
+      SDL_Log("Texture cook: failed to write %s", path);
+      ok = false;
+      break;
+    }
+
+    const float scale =
+        SDL_min(1.0f, (float)THS_TEXTURE_LOW_SIZE /
+                          (float)SDL_max(width, height));
+    fprintf(list, "%s %s %s %f\n", name, file_name,
+            is_color_image(gltf, image) ? "srgb" : "linear", (double)scale);
+  }
+  ok = fclose(list) == 0 && ok;
+  SDL_Log("Texture cook: extracted %u images from %s",
+          (uint32_t)gltf->images_count, scene_path);
+  cgltf_free(gltf);
+  return ok ? 0 : 1;
+}
+
+static uint64_t file_size(const char *path) {
+  FILE *file = fopen(path, "rb");
+  if (file == NULL) {
+    return 0;
+  }
+  fseek(file, 0, SEEK_END);
+  const long size = ftell(file);
+  fclose(file);
+  return size > 0 ? (uint64_t)size : 0;
+}
+
+static int32_t verify(const char *out_dir) {
+  char path[MAX_PATH_LEN] = {0};
+  SDL_snprintf(path, sizeof(path), "%s/%s", out_dir, IMAGE_LIST);
+  FILE *list = fopen(path, "r");
+  if (list == NULL) {
+    SDL_Log("Texture cook: failed to open %s", path);
+    return 1;
+  }
+  SDL_snprintf(path, sizeof(path), "%s/%s", out_dir, THS_TEXTURE_MANIFEST);
+  FILE *manifest = fopen(path, "w");
+  if (manifest == NULL) {
+    SDL_Log("Texture cook: failed to open %s", path);
+    fclose(list);
+    return 1;
+  }
+
+  bool ok = true;
+  uint64_t source_total = 0;
+  uint64_t cooked_total = 0;
+  char name[64] = {0};
+  char file_name[80] = {0};
+  char space[16] = {0};
+  float scale = 1.0f;
+  while (fscanf(list, "%63s %79s %15s %f", name, file_name, space, &scale) ==
+         4) {
+    char full_path[MAX_PATH_LEN] = {0};
+    char low_path[MAX_PATH_LEN] = {0};
+    SDL_snprintf(path, sizeof(path), "%s/%s", out_dir, file_name);
+    SDL_snprintf(full_path, sizeof(full_path), "%s/%s%s", out_dir, name,
+                 THS_TEXTURE_FULL_SUFFIX);
+    SDL_snprintf(low_path, sizeof(low_path), "%s/%s%s", out_dir, name,
+                 THS_TEXTURE_LOW_SUFFIX);
+
+    // RGBA32 is what every CPU can check without a GPU format in mind
+    ThsKtxImage full = {0};
+    ThsKtxImage low = {0};
+    if (!ths_ktx_load(full_path, KTX_TTF_RGBA32, &full) ||
+        !ths_ktx_load(low_path, KTX_TTF_RGBA32, &low)) {
+      ths_ktx_free(&full);
+      ok = false;
+      continue;
+    }
+
+    const uint64_t source = file_size(path);
+    const uint64_t cooked = file_size(full_path) + file_size(low_path);
+    source_total += source;
+    cooked_total += cooked;
+    SDL_Log("Texture cook: %s %ux%u %u mips, %llu -> %llu bytes, "
+            "transcode %.2f ms (low tier %ux%u %.2f ms)",
+            name, full.width, full.height, full.levels,
+            (unsigned long long)source, (unsigned long long)cooked,
+            (double)full.transcode_ms, low.width, low.height,
+            (double)low.transcode_ms);
+    fprintf(manifest, "%s %d %u %u\n", name,
+            SDL_strcmp(space, "srgb") == 0, full.width, full.height);
+
+    ths_ktx_free(&full);
+    ths_ktx_free(&low);
+  }
+  fclose(list);
+  ok = fclose(manifest) == 0 && ok;
+
+  SDL_Log("Texture cook: %s %llu -> %llu bytes", out_dir,
+          (unsigned long long)source_total, (unsigned long long)cooked_total);
+  return ok ? 0 : 1;
+}
+
+int32_t main(int32_t argc, char *argv[]) {
+  if (argc == 4 && SDL_strcmp(argv[1], "extract") == 0) {
+    return extract(argv[2], argv[3]);
+  }
+  if (argc == 3 && SDL_strcmp(argv[1], "verify") == 0) {
+    return verify(argv[2]);
+  }
+  SDL_Log("Usage: %s extract <scene.glb> <out_dir>", argv[0]);
+  SDL_Log("       %s verify <out_dir>", argv[0]);
+  return 1;
+}
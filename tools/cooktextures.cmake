@@ -0,0 +1,38 @@
+# Cooks every image of a scene into a full and a low tier KTX2 texture
+# Usage: cmake -DTEXCOOK=<thehighseas_texcook> -DTOKTX=<toktx>
+#              -DSCENE=<scene.glb> -DOUT_DIR=<dir> -P cooktextures.cmake
+file(REMOVE_RECURSE ${OUT_DIR})
+file(MAKE_DIRECTORY ${OUT_DIR})
+
+execute_process(COMMAND ${TEXCOOK} extract ${SCENE} ${OUT_DIR}
+                COMMAND_ERROR_IS_FATAL ANY)
+
+# UASTC keeps quality close to the source and transcodes to BC7 or ASTC
+# alike; zstd makes up most of the size difference with ETC1S
+file(STRINGS "${OUT_DIR}/images.txt" images)
+foreach(image ${images})
+  string(REPLACE " " ";" fields ${image})
+  list(GET fields 0 name)
+  list(GET fields 1 file)
+  list(GET fields 2 space)
+  list(GET fields 3 scale)
+  set(encode --t2 --encode uastc --uastc_quality 2 --zcmp 18 --genmipmap
+             --assign_oetf ${space})
+  execute_process(COMMAND ${TOKTX} ${encode} "${OUT_DIR}/${name}.ktx2"
+                          "${OUT_DIR}/${file}"
+                  COMMAND_ERROR_IS_FATAL ANY)
+  execute_process(COMMAND ${TOKTX} ${encode} --scale ${scale}
+                          "${OUT_DIR}/${name}.low.ktx2" "${OUT_DIR}/${file}"
+                  COMMAND_ERROR_IS_FATAL ANY)
+endforeach()
+
+execute_process(COMMAND ${TEXCOOK} verify ${OUT_DIR}
+                COMMAND_ERROR_IS_FATAL ANY)
+
+# Only the KTX2 files and the manifest ship
+foreach(image ${images})
+  string(REPLACE " " ";" fields ${image})
+  list(GET fields 1 file)
+  file(REMOVE "${OUT_DIR}/${file}")
+endforeach()
+file(REMOVE "${OUT_DIR}/images.txt")
@@ -0,0 +1,50 @@
+#include "ktxtranscode.h"
+
+#include "profiling.h"
+
+#include <SDL3/SDL.h>
+
+bool ths_ktx_load(const char *path, ktx_transcode_fmt_e format,
+                  ThsKtxImage *image) {
+  TracyCZoneNC(ctx, "KTX Load", TracyCategoryColorCore, true);
+  *image = (ThsKtxImage){0};
+  const uint64_t start = SDL_GetPerformanceCounter();
+
+  ktxTexture2 *texture = NULL;
+  KTX_error_code res = ktxTexture2_CreateFromNamedFile(
+      path, KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT, &texture);
+  if (res != KTX_SUCCESS) {
+    SDL_Log("KTX: failed to load %s: %s", path, ktxErrorString(res));
+    TracyCZoneEnd(ctx);
+    return false;
+  }
+  if (ktxTexture2_NeedsTranscoding(texture)) {
+    res = ktxTexture2_TranscodeBasis(texture, format, 0);
+    if (res != KTX_SUCCESS) {
+      SDL_Log("KTX: failed to transcode %s: %s", path, ktxErrorString(res));
+      ktxTexture2_Destroy(texture);
+      TracyCZoneEnd(ctx);
+      return false;
+    }
+  }
+
+  *image = (ThsKtxImage){
+      .texture = texture,
+      .width = texture->baseWidth,
+      .height = texture->baseHeight,
+      .levels = texture->numLevels,
+      .bytes = ktxTexture_GetDataSize(ktxTexture(texture)),
+      .transcode_ms =
+          (float)((double)(SDL_GetPerformanceCounter() - start) * 1000.0 /
+                  (double)SDL_GetPerformanceFrequency()),
+  };
+  TracyCZoneEnd(ctx);
+  return true;
+}
+
+void ths_ktx_free(ThsKtxImage *image) {
+  if (image->texture) {
+    ktxTexture2_Destroy(image->texture);
+  }
+  *image = (ThsKtxImage){0};
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <ktx.h>
+
+// Loads a cooked KTX2 texture and transcodes its Basis UASTC payload
+//
+// Transcoding runs entirely on the CPU, so the cook step can check every
+// texture it produced without a GPU
+
+// Cooked textures come in two tiers. The low tier is a small copy with its
+// own mips, the full tier has the complete chain
+#define THS_TEXTURE_LOW_SUFFIX ".low.ktx2"
+#define THS_TEXTURE_FULL_SUFFIX ".ktx2"
+// Longest side of the low tier in texels
+#define THS_TEXTURE_LOW_SIZE 64
+
+#define THS_TEXTURE_MANIFEST "manifest.txt"
+
+typedef struct ThsKtxImage {
+  ktxTexture2 *texture;
+  uint32_t width;
+  uint32_t height;
+  uint32_t levels;
+  uint64_t bytes; // Transcoded size of every level
+  float transcode_ms;
+} ThsKtxImage;
+
+// Reads the file and transcodes it to the given format. Textures that aren't
+// Basis compressed are loaded as they are. Returns false and logs why on
+// failure
+bool ths_ktx_load(const char *path, ktx_transcode_fmt_e format,
+                  ThsKtxImage *image);
+void ths_ktx_free(ThsKtxImage *image);